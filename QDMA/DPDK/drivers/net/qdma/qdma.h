@@ -45,8 +45,10 @@
 #include "qdma_reg.h"
 #include "qdma_resource_mgmt.h"
 #include "qdma_mbox.h"
+#include "qdma_emu.h"
 #include "rte_pmd_qdma.h"
 #include "qdma_log.h"
+#include "qdma_trace.h"
 
 #define QDMA_NUM_BARS          (6)
 #define DEFAULT_PF_CONFIG_BAR  (0)
@@ -63,7 +65,13 @@
 #define CPM_DEFAULT_QUEUE_BASE	(1)
 #define CPM_QDMA_QUEUES_NUM_MAX (2047)
 
+/* Completion entries taken per chunk by the scalar ST Rx burst */
 #define QDMA_MAX_BURST_SIZE (256)
+#define QDMA_TX_OFFLOAD_CAPA	(DEV_TX_OFFLOAD_MULTI_SEGS | \
+				 DEV_TX_OFFLOAD_MBUF_FAST_FREE)
+#define QDMA_TX_FREE_BULK_SIZE	(64)
+#define DEFAULT_TX_FREE_THRESHOLD	(32)
+#define DEFAULT_RX_FREE_THRESHOLD	(32)
 #define QDMA_MIN_RXBUFF_SIZE	(256)
 
 /* Descriptor Rings aligned to 4KB boundaries - only supported value */
@@ -72,17 +80,29 @@
 #define DEFAULT_TIMER_CNT_TRIG_MODE_TIMER	(5)
 #define DEFAULT_TIMER_CNT_TRIG_MODE_COUNT_TIMER	(30)
 
-#define MIN_RX_PIDX_UPDATE_THRESHOLD (1)
 #define MIN_TX_PIDX_UPDATE_THRESHOLD (1)
 #define DEFAULT_MM_CMPT_CNT_THRESHOLD	(2)
-#define QDMA_TXQ_PIDX_UPDATE_INTERVAL	(1000) //100 uSec
+#define QDMA_TXQ_PIDX_UPDATE_INTERVAL	(1000) //1000 uSec
+/* tx_pidx_timeout devarg range, in uSec */
+#define QDMA_TXQ_PIDX_TMO_MIN		(1)
+#define QDMA_TXQ_PIDX_TMO_MAX		(1000000)
+
+/* numa_policy devarg values */
+enum qdma_numa_policy {
+	/* everything on the socket given at queue setup */
+	QDMA_NUMA_SETUP_SOCKET = 0,
+	/* memory written by the device on its own socket, software rings
+	 * and queue structures on the socket given at queue setup
+	 */
+	QDMA_NUMA_DEVICE_RINGS = 1,
+	QDMA_NUMA_POLICY_MAX
+};
 
 /** Delays **/
 #define MAILBOX_PF_MSG_DELAY		(20)
 #define MAILBOX_VF_MSG_DELAY		(10)
 #define MAILBOX_PROG_POLL_COUNT		(1250)
 
-#define WB_TIMEOUT			(100000)
 #define RESET_TIMEOUT		(60000)
 #define SHUTDOWN_TIMEOUT	(60000)
 
@@ -118,6 +138,13 @@ enum dma_data_direction {
 	DMA_NONE = 3,
 };
 
+/** Rx burst paths selectable per queue at setup time */
+enum qdma_rx_vec_path {
+	QDMA_RX_VEC_NONE,	/* scalar burst only */
+	QDMA_RX_VEC_SSE,	/* 4 completion entries per iteration */
+	QDMA_RX_VEC_AVX2,	/* 8 completion entries per iteration */
+};
+
 enum reset_state_t {
 	RESET_STATE_IDLE,
 	RESET_STATE_RECV_PF_RESET_REQ,
@@ -138,6 +165,36 @@ struct qdma_pkt_stats {
 	uint64_t bytes;
 };
 
+/* Burst size histogram bins: 0, 1, 2-3, 4-7, ... 64-127, 128 and more */
+#define QDMA_XSTATS_BURST_BINS	(9)
+
+/*
+ * Per queue data path counters reported through xstats. Kept on their
+ * own cache lines, only the lcore polling the queue writes them.
+ */
+struct qdma_q_xstats {
+	uint64_t bursts;
+	uint64_t ring_occupancy; /* descriptors in use, summed per burst */
+	uint64_t pidx_updates;
+	uint64_t cidx_updates;
+	uint64_t mbuf_alloc_failed;
+	uint64_t cmpt_err;
+	uint64_t queue_full;
+	uint64_t burst_size[QDMA_XSTATS_BURST_BINS];
+} __rte_cache_aligned;
+
+/* Hardware error counters, one per leaf error aggregator */
+enum qdma_hw_err_aggr {
+	QDMA_HW_ERR_DSC,
+	QDMA_HW_ERR_TRQ,
+	QDMA_HW_ERR_ST_C2H,
+	QDMA_HW_ERR_ST_FATAL,
+	QDMA_HW_ERR_ST_H2C,
+	QDMA_HW_ERR_RAM_SBE,
+	QDMA_HW_ERR_RAM_DBE,
+	QDMA_HW_ERR_AGGR_MAX
+};
+
 /*
  * Structure associated with each CMPT queue.
  */
@@ -146,6 +203,7 @@ struct qdma_cmpt_queue {
 	struct wb_status    *wb_status;
 	struct qdma_q_cmpt_cidx_reg_info cmpt_cidx_info;
 	struct rte_eth_dev	*dev;
+	uint32_t	cmpt_db; /**< CIDX doorbell offset, 0 if none */
 
 	uint16_t	cmpt_desc_len;
 	uint16_t	nb_cmpt_desc;
@@ -164,8 +222,24 @@ struct qdma_cmpt_queue {
 	const struct rte_memzone *cmpt_mz;
 };
 
+/**
+ * Descriptor slot of an Rx queue in external buffer mode.
+ *
+ * Each slot is a rx_buff_size slice of a large buffer, slices of one
+ * buffer are posted to consecutive slots. The queue holds a single
+ * reference on every buffer, carried by the slot of its last slice.
+ */
+struct qdma_rx_ext_slot {
+	void		*buf; /**< large buffer, NULL once consumed */
+	uint32_t	off; /**< slice offset in buf */
+	uint32_t	last; /**< last slice of buf */
+};
+
 /**
  * Structure associated with each RX queue.
+ *
+ * The first two cache lines hold everything the Rx burst functions use,
+ * control path only fields start on the third one.
  */
 struct qdma_rx_queue {
 	struct rte_mempool	*mb_pool; /**< mbuf pool to populate RX ring. */
@@ -173,33 +247,64 @@ struct qdma_rx_queue {
 	struct qdma_ul_st_cmpt_ring	*cmpt_ring;
 	struct wb_status	*wb_status;
 	struct rte_mbuf		**sw_ring; /**< address of RX software ring. */
-	struct rte_eth_dev	*dev;
 
 	uint16_t		rx_tail;
 	uint16_t		cmpt_desc_len;
 	uint16_t		rx_buff_size;
 	uint16_t		nb_rx_desc; /**< number of RX descriptors. */
 	uint16_t		nb_rx_cmpt_desc;
+	uint16_t		rx_free_thresh; /**< ST refill batch size */
 	uint32_t		queue_id; /**< RX queue index. */
 
 	struct qdma_q_pidx_reg_info	q_pidx_info;
 	struct qdma_q_cmpt_cidx_reg_info cmpt_cidx_info;
-	struct qdma_pkt_stats	stats;
-
+	/* Flags tested on every burst are plain bytes, not bitfields */
+	uint8_t			status;
+	uint8_t			err;
+	uint8_t			st_mode; /**< dma-mode: MM or ST */
+	uint8_t			dump_immediate_data;
+	uint8_t			rx_vec_path; /**< enum qdma_rx_vec_path */
+	/* CMPT byte offsets of the timestamp and metadata, -1 if unused */
+	int8_t			cmpt_ts_off;
+	int8_t			cmpt_meta_off;
+	uint16_t		port_id; /**< Device port identifier. */
+	/* MM copy descriptors written but PIDX not yet updated */
+	uint16_t		rx_desc_pend;
 	uint32_t		ep_addr;
-	uint8_t			status:1;
-	uint8_t			err:1;
-	uint8_t			st_mode:1; /**< dma-mode: MM or ST */
+	/* triggermode/timeridx/threshidx changed on a started queue */
+	uint8_t			cmpt_moder_upd;
+	/* counter threshold follows the completion backlog */
+	uint8_t			cntr_adaptive;
+	uint16_t		cntr_avg; /**< moving average of the backlog */
+	/* data_off, refcnt, nb_segs and port of a freshly received mbuf,
+	 * stored at once over rearm_data by the vector Rx path
+	 */
+	uint64_t		mbuf_initializer;
+	struct qdma_pkt_stats	stats;
+	uint8_t			cntr_adapt_cnt; /**< bursts since last pick */
+	/* descriptors are slices of ext_pool buffers, see ext_ring */
+	uint8_t			ext_buf;
+	/* burst cycles accounted, see rte_pmd_qdma_set_queue_cycles() */
+	uint8_t			cycles_en;
+	/* doorbell offsets in the config BAR, 0 to use hw_access */
+	uint32_t		pidx_db;
+	uint32_t		cmpt_db;
+
+	/* Control path only */
+	const struct rte_memzone *rx_mz __rte_cache_aligned;
+	/* Process local, data path goes through port_id instead */
+	struct rte_eth_dev	*dev;
+	/* C2H stream mode, completion descriptor result */
+	const struct rte_memzone *rx_cmpt_mz;
+	uint16_t		intr_vec; /**< MSI-X vector, 0 if polled */
 	uint8_t			rx_deferred_start:1;
 	uint8_t			en_prefetch:1;
 	uint8_t			en_bypass:1;
-	uint8_t			dump_immediate_data:1;
 	uint8_t			en_bypass_prefetch:1;
 	uint8_t			dis_overflow_check:1;
 
 	enum rte_pmd_qdma_bypass_desc_len	bypass_desc_sz:7;
 
-	uint16_t		port_id; /**< Device port identifier. */
 	uint8_t			func_id; /**< RX queue index. */
 
 	int8_t			ringszidx;
@@ -208,40 +313,65 @@ struct qdma_rx_queue {
 	int8_t			threshidx;
 	int8_t			timeridx;
 	int8_t			triggermode;
-	const struct rte_memzone *rx_mz;
-	/* C2H stream mode, completion descriptor result */
-	const struct rte_memzone *rx_cmpt_mz;
+	struct qdma_q_xstats	xstats;
+	struct rte_pmd_qdma_q_cycles	cycles;
+
+	/* External buffer mode, descriptor slot to large buffer slice map */
+	struct rte_mempool	*ext_pool;
+	struct qdma_rx_ext_slot	*ext_ring;
+	void			*ext_cur; /**< buffer being carved, NULL if none */
+	uint32_t		ext_off; /**< next slice offset in ext_cur */
+	uint32_t		ext_len; /**< bytes of a buffer used for slices */
+	uint32_t		ext_shinfo_off; /**< shared info offset */
 };
 
 /**
  * Structure associated with each TX queue.
+ *
+ * The first two cache lines hold everything the Tx burst functions use,
+ * control path only fields start on the third one.
  */
 struct qdma_tx_queue {
 	void				*tx_ring; /* TX ring virtual address*/
 	struct wb_status		*wb_status;
 	struct rte_mbuf			**sw_ring;/* SW ring virtual address*/
-	struct rte_eth_dev		*dev;
 	uint16_t			tx_fl_tail;
 	uint16_t			tx_desc_pend;
 	uint16_t			nb_tx_desc; /* No of TX descriptors.*/
-	rte_spinlock_t			pidx_update_lock;
+	uint16_t			tx_free_thresh; /* Reclaim threshold */
+	/* Doorbell coalescing: PIDX is written once tx_desc_pend reaches
+	 * tx_pidx_batch or tx_pidx_tmo cycles after the last write
+	 */
+	uint16_t			tx_pidx_batch;
 	struct qdma_q_pidx_reg_info	q_pidx_info;
-
-	uint8_t				st_mode:1;/* dma-mode: MM or ST */
-	uint8_t				tx_deferred_start:1;
-	uint8_t				en_bypass:1;
-	uint8_t				status:1;
-	enum rte_pmd_qdma_bypass_desc_len		bypass_desc_sz:7;
+	/* Flags tested on every burst are plain bytes, not bitfields */
+	uint8_t				status;
+	uint8_t				st_mode;/* dma-mode: MM or ST */
+	uint8_t				tx_vec_en;
+	/* burst cycles accounted, see rte_pmd_qdma_set_queue_cycles() */
+	uint8_t				cycles_en;
 	uint16_t			port_id; /* Device port identifier. */
-	uint8_t				func_id; /* RX queue index. */
-	int8_t				ringszidx;
-
+	uint64_t			tx_pidx_tmo;
+	uint64_t			tx_pidx_tsc;
 	struct				qdma_pkt_stats stats;
-
+	uint64_t			offloads; /* DEV_TX_OFFLOAD_* */
 	uint32_t			ep_addr;
 	uint32_t			queue_id; /* TX queue index. */
+	/* doorbell offset in the config BAR, 0 to use hw_access */
+	uint32_t			pidx_db;
+
+	/* Control path only */
+	const struct rte_memzone	*tx_mz __rte_cache_aligned;
+	/* Process local, data path goes through port_id instead */
+	struct rte_eth_dev		*dev;
 	uint32_t			num_queues; /* TX queue index. */
-	const struct rte_memzone	*tx_mz;
+	uint8_t				func_id; /* RX queue index. */
+	int8_t				ringszidx;
+	uint8_t				tx_deferred_start:1;
+	uint8_t				en_bypass:1;
+	enum rte_pmd_qdma_bypass_desc_len		bypass_desc_sz:7;
+	struct qdma_q_xstats		xstats;
+	struct rte_pmd_qdma_q_cycles	cycles;
 };
 
 struct qdma_vf_info {
@@ -260,18 +390,27 @@ struct queue_info {
 	enum rte_pmd_qdma_bypass_desc_len tx_bypass_desc_sz:7;
 	uint8_t		timer_count;
 	int8_t		trigger_mode;
+	int8_t		cmpt_ts_off;
+	int8_t		cmpt_meta_off;
+	uint16_t	ext_buf_sz;
+	struct rte_mempool *ext_pool;
 };
 
 struct qdma_pci_dev {
 	int config_bar_idx;
 	int user_bar_idx;
 	int bypass_bar_idx;
-	void *bar_addr[QDMA_NUM_BARS]; /* memory mapped I/O addr for BARs */
 
 	/* Driver Attributes */
 	uint32_t qsets_en;  /* no. of queue pairs enabled */
 	uint32_t queue_base;
 	uint8_t func_id;  /* Function id */
+	/* Device key of the queue resource manager: the PCI bus number,
+	 * or a value above any bus number for an emulated device
+	 */
+	uint32_t dma_device_index;
+	/* Software model of the device, NULL for PCI functions */
+	struct qdma_emu *emu;
 
 	/* Device capabilities */
 	struct qdma_dev_attributes dev_cap;
@@ -281,11 +420,21 @@ struct qdma_pci_dev {
 	uint8_t h2c_bypass_mode;
 	uint8_t trigger_mode;
 	uint8_t timer_count;
+	uint16_t tx_pidx_batch; /* descriptors per Tx doorbell */
+	uint32_t tx_pidx_timeout; /* max usec between Tx doorbells */
+	uint8_t numa_policy; /* enum qdma_numa_policy */
 
 	uint8_t dev_configured:1;
 	uint8_t is_vf:1;
 	uint8_t is_master:1;
 	uint8_t en_desc_prefetch:1;
+	/* PF lacks the batched queue context write, VF only */
+	uint8_t qctxt_batch_dis:1;
+	/* errors are reported by interrupt instead of polling */
+	uint8_t err_intr_en:1;
+
+	/* Errors counted by the master PF, reported through xstats */
+	uint64_t hw_err_cnt[QDMA_HW_ERR_AGGR_MAX];
 
 	/* Reset state */
 	enum reset_state_t reset_state;
@@ -305,23 +454,147 @@ struct qdma_pci_dev {
 	uint32_t g_c2h_buf_sz[QDMA_NUM_C2H_BUFFER_SIZES];
 	uint32_t g_c2h_timer_cnt[QDMA_NUM_C2H_TIMERS];
 	void	**cmpt_queues;
-	/*Pointer to QDMA access layer function pointers*/
+	/*Pointer to QDMA access layer function pointers, valid in the
+	 * primary process only, see struct qdma_proc_priv
+	 */
 	struct qdma_hw_access *hw_access;
 
 	struct qdma_vf_info *vfinfo;
 	uint8_t vf_online_count;
 };
 
+/*
+ * Per process state of a port. dev_private is shared with secondary
+ * processes, while BAR mappings and the access layer function pointers
+ * are only valid in the process that set them up, so every process
+ * probing the port fills its own copy. The data path only uses this one.
+ */
+struct qdma_proc_priv {
+	void *bar_addr[QDMA_NUM_BARS]; /* memory mapped I/O addr for BARs */
+	uint8_t *config_bar; /* base of the queue doorbell offsets */
+	struct qdma_hw_access hw_access;
+};
+
+extern struct qdma_proc_priv qdma_proc_priv[RTE_MAX_ETHPORTS];
+
+#define QDMA_PROC_PRIV(port_id)	(&qdma_proc_priv[(port_id)])
+
+/*
+ * Queue doorbells. The register offsets are resolved at queue setup and
+ * shared by all processes, the burst functions store the value straight
+ * into the process local config BAR mapping. Designs whose doorbells are
+ * not known to the PMD keep an offset of 0 and go through hw_access.
+ */
+static inline void qdma_db_write(uint16_t port_id, uint32_t db,
+		uint32_t val)
+{
+	*(volatile uint32_t *)(QDMA_PROC_PRIV(port_id)->config_bar + db) =
+			val;
+}
+
+static inline uint32_t
+qdma_pidx_db_val(const struct qdma_q_pidx_reg_info *reg_info)
+{
+	return FIELD_SET(QDMA_DMA_SEL_DESC_PIDX_MASK, reg_info->pidx) |
+		FIELD_SET(QDMA_DMA_SEL_IRQ_EN_MASK, reg_info->irq_en);
+}
+
+static inline uint32_t
+qdma_cmpt_cidx_db_val(const struct qdma_q_cmpt_cidx_reg_info *reg_info)
+{
+	return FIELD_SET(QDMA_DMAP_SEL_CMPT_WRB_CIDX_MASK,
+			reg_info->wrb_cidx) |
+		FIELD_SET(QDMA_DMAP_SEL_CMPT_CNT_THRESH_MASK,
+			reg_info->counter_idx) |
+		FIELD_SET(QDMA_DMAP_SEL_CMPT_TMR_CNT_MASK,
+			reg_info->timer_idx) |
+		FIELD_SET(QDMA_DMAP_SEL_CMPT_TRG_MODE_MASK,
+			reg_info->trig_mode) |
+		FIELD_SET(QDMA_DMAP_SEL_CMPT_STS_DESC_EN_MASK,
+			reg_info->wrb_en) |
+		FIELD_SET(QDMA_DMAP_SEL_CMPT_IRQ_EN_MASK, reg_info->irq_en);
+}
+
+static inline void qdma_rxq_pidx_db(struct qdma_rx_queue *rxq)
+{
+	struct rte_eth_dev *dev;
+
+	qdma_trace_rx_pidx_db(rxq, rxq->q_pidx_info.pidx);
+	if (likely(rxq->pidx_db)) {
+		qdma_db_write(rxq->port_id, rxq->pidx_db,
+				qdma_pidx_db_val(&rxq->q_pidx_info));
+		return;
+	}
+	dev = &rte_eth_devices[rxq->port_id];
+	QDMA_PROC_PRIV(rxq->port_id)->hw_access.qdma_queue_pidx_update(dev,
+		((struct qdma_pci_dev *)dev->data->dev_private)->is_vf,
+		rxq->queue_id, 1, &rxq->q_pidx_info);
+}
+
+static inline void qdma_rxq_cmpt_cidx_db(struct qdma_rx_queue *rxq)
+{
+	struct rte_eth_dev *dev;
+
+	qdma_trace_rx_cmpt_cidx_db(rxq, rxq->cmpt_cidx_info.wrb_cidx);
+	if (likely(rxq->cmpt_db)) {
+		qdma_db_write(rxq->port_id, rxq->cmpt_db,
+				qdma_cmpt_cidx_db_val(&rxq->cmpt_cidx_info));
+		return;
+	}
+	dev = &rte_eth_devices[rxq->port_id];
+	QDMA_PROC_PRIV(rxq->port_id)->hw_access.qdma_queue_cmpt_cidx_update(
+		dev, ((struct qdma_pci_dev *)dev->data->dev_private)->is_vf,
+		rxq->queue_id, &rxq->cmpt_cidx_info);
+}
+
+static inline void qdma_txq_pidx_db(struct qdma_tx_queue *txq)
+{
+	struct rte_eth_dev *dev;
+
+	qdma_trace_tx_pidx_db(txq, txq->q_pidx_info.pidx);
+	if (likely(txq->pidx_db)) {
+		qdma_db_write(txq->port_id, txq->pidx_db,
+				qdma_pidx_db_val(&txq->q_pidx_info));
+		return;
+	}
+	dev = &rte_eth_devices[txq->port_id];
+	QDMA_PROC_PRIV(txq->port_id)->hw_access.qdma_queue_pidx_update(dev,
+		((struct qdma_pci_dev *)dev->data->dev_private)->is_vf,
+		txq->queue_id, 0, &txq->q_pidx_info);
+}
+
+static inline void qdma_cmptq_cidx_db(struct qdma_cmpt_queue *cmptq)
+{
+	struct rte_eth_dev *dev;
+
+	if (likely(cmptq->cmpt_db)) {
+		qdma_db_write(cmptq->port_id, cmptq->cmpt_db,
+				qdma_cmpt_cidx_db_val(&cmptq->cmpt_cidx_info));
+		return;
+	}
+	dev = &rte_eth_devices[cmptq->port_id];
+	QDMA_PROC_PRIV(cmptq->port_id)->hw_access.qdma_queue_cmpt_cidx_update(
+		dev, ((struct qdma_pci_dev *)dev->data->dev_private)->is_vf,
+		cmptq->queue_id, &cmptq->cmpt_cidx_info);
+}
+
 void qdma_dev_ops_init(struct rte_eth_dev *dev);
+int qdma_proc_priv_init(struct rte_eth_dev *dev);
 uint32_t qdma_read_reg(uint64_t addr);
 void qdma_write_reg(uint64_t addr, uint32_t val);
-void qdma_txq_pidx_update(void *arg);
 int qdma_pf_csr_read(struct rte_eth_dev *dev);
 int qdma_vf_csr_read(struct rte_eth_dev *dev);
 
 void qdma_dev_close(struct rte_eth_dev *dev);
 int qdma_dev_stats_get(struct rte_eth_dev *dev,
 			      struct rte_eth_stats *eth_stats);
+void qdma_dev_stats_reset(struct rte_eth_dev *dev);
+int qdma_dev_xstats_get(struct rte_eth_dev *dev, struct rte_eth_xstat *xstats,
+			unsigned int n);
+int qdma_dev_xstats_get_names(struct rte_eth_dev *dev,
+			struct rte_eth_xstat_name *xstats_names,
+			unsigned int size);
+void qdma_dev_xstats_reset(struct rte_eth_dev *dev);
 int qdma_dev_rx_queue_setup(struct rte_eth_dev *dev, uint16_t rx_queue_id,
 				uint16_t nb_rx_desc, unsigned int socket_id,
 				const struct rte_eth_rxconf *rx_conf,
@@ -340,6 +613,11 @@ int qdma_vf_dev_rx_queue_start(struct rte_eth_dev *dev, uint16_t rx_queue_id);
 int qdma_vf_dev_rx_queue_stop(struct rte_eth_dev *dev, uint16_t rx_queue_id);
 int qdma_vf_dev_tx_queue_start(struct rte_eth_dev *dev, uint16_t tx_queue_id);
 int qdma_vf_dev_tx_queue_stop(struct rte_eth_dev *dev, uint16_t tx_queue_id);
+int qdma_dev_rx_queue_intr_enable(struct rte_eth_dev *dev, uint16_t qid);
+int qdma_dev_rx_queue_intr_disable(struct rte_eth_dev *dev, uint16_t qid);
+int qdma_dev_rx_intr_setup(struct rte_eth_dev *dev);
+void qdma_dev_rx_intr_teardown(struct rte_eth_dev *dev);
+void qdma_error_intr_resume(struct rte_eth_dev *dev);
 
 int qdma_init_rx_queue(struct qdma_rx_queue *rxq);
 void qdma_reset_tx_queue(struct qdma_tx_queue *txq);
@@ -353,6 +631,7 @@ void qdma_clr_tx_queue_ctxts(struct rte_eth_dev *dev, uint32_t qid,
 				uint32_t mode);
 void qdma_inv_tx_queue_ctxts(struct rte_eth_dev *dev, uint32_t qid,
 				uint32_t mode);
+struct rte_mem_resource *qdma_mem_resource(struct rte_eth_dev *dev);
 int qdma_identify_bars(struct rte_eth_dev *dev);
 int qdma_get_hw_version(struct rte_eth_dev *dev);
 /* implemented in rxtx.c */
@@ -361,16 +640,39 @@ uint16_t qdma_recv_pkts(void *rx_queue, struct rte_mbuf **rx_pkts,
 uint16_t qdma_xmit_pkts(void *tx_queue, struct rte_mbuf **tx_pkts,
 				uint16_t nb_pkts);
 int qdma_dev_rx_descriptor_done(void *rx_queue, uint16_t exp_count);
+uint32_t qdma_dev_rx_queue_count(struct rte_eth_dev *dev,
+				uint16_t rx_queue_id);
+int qdma_dev_rx_descriptor_status(void *rx_queue, uint16_t offset);
+int qdma_dev_tx_descriptor_status(void *tx_queue, uint16_t offset);
 
 uint16_t qdma_recv_pkts_st(struct qdma_rx_queue *rxq, struct rte_mbuf **rx_pkts,
-				uint16_t nb_pkts);
+				uint16_t nb_pkts, uint16_t nb_pend);
 uint16_t qdma_recv_pkts_mm(struct qdma_rx_queue *rxq, struct rte_mbuf **rx_pkts,
 				uint16_t nb_pkts);
+int qdma_rx_refill_st(struct qdma_rx_queue *rxq);
+void qdma_rx_cmpt_moder_update(struct qdma_rx_queue *rxq);
+uint16_t qdma_rx_extbuf_post(struct qdma_rx_queue *rxq, uint16_t id,
+		uint16_t nb_desc);
+void qdma_rx_extbuf_release(struct qdma_rx_queue *rxq);
+#ifdef RTE_ARCH_X86
+/* implemented in rxtx_vec.c */
+void qdma_rx_vec_setup(struct qdma_rx_queue *rxq);
+uint16_t qdma_recv_pkts_st_vec(struct qdma_rx_queue *rxq,
+				struct rte_mbuf **rx_pkts, uint16_t nb_pkts);
+#endif
 
 uint16_t qdma_xmit_pkts_st(struct qdma_tx_queue *txq, struct rte_mbuf **tx_pkts,
 				uint16_t nb_pkts);
 uint16_t qdma_xmit_pkts_mm(struct qdma_tx_queue *txq, struct rte_mbuf **tx_pkts,
 				uint16_t nb_pkts);
+void reclaim_tx_mbuf(struct qdma_tx_queue *txq, uint16_t cidx);
+void qdma_tx_pidx_update_st(struct qdma_tx_queue *txq, uint16_t nb_desc);
+void qdma_tx_pidx_flush(struct qdma_tx_queue *txq);
+#ifdef RTE_ARCH_X86
+void qdma_tx_vec_setup(struct qdma_tx_queue *txq);
+uint16_t qdma_xmit_pkts_st_vec(struct qdma_tx_queue *txq,
+				struct rte_mbuf **tx_pkts, uint16_t nb_pkts);
+#endif
 
 uint32_t qdma_pci_read_reg(struct rte_eth_dev *dev, uint32_t bar, uint32_t reg);
 void qdma_pci_write_reg(struct rte_eth_dev *dev, uint32_t bar,
@@ -380,6 +682,12 @@ int index_of_array(uint32_t *arr, uint32_t n, uint32_t element);
 
 int qdma_check_kvargs(struct rte_devargs *devargs,
 			struct qdma_pci_dev *qdma_dev);
+int qdma_ring_socket(struct rte_eth_dev *dev, const char *type,
+			uint16_t qid, unsigned int socket_id);
+uint32_t qdma_pidx_db_offset(struct qdma_pci_dev *qdma_dev, uint16_t qid,
+			uint8_t is_c2h);
+uint32_t qdma_cmpt_cidx_db_offset(struct qdma_pci_dev *qdma_dev,
+			uint16_t qid);
 
 static inline const
 struct rte_memzone *qdma_zone_reserve(struct rte_eth_dev *dev,
@@ -38,10 +38,14 @@
 #include <rte_kvargs.h>
 #include "qdma.h"
 #include "qdma_access.h"
+#include "qdma_cpm_reg.h"
 
 #include <fcntl.h>
 #include <unistd.h>
 
+/* Process local state of each port, see struct qdma_proc_priv */
+struct qdma_proc_priv qdma_proc_priv[RTE_MAX_ETHPORTS];
+
 /* Read register */
 uint32_t qdma_read_reg(uint64_t reg_addr)
 {
@@ -59,7 +63,7 @@ void qdma_write_reg(uint64_t reg_addr, uint32_t val)
 
 uint32_t qdma_pci_read_reg(struct rte_eth_dev *dev, uint32_t bar, uint32_t reg)
 {
-	struct qdma_pci_dev *qdma_dev = dev->data->dev_private;
+	struct qdma_proc_priv *proc_priv = QDMA_PROC_PRIV(dev->data->port_id);
 	uint64_t baseaddr;
 	uint32_t val;
 
@@ -69,7 +73,7 @@ uint32_t qdma_pci_read_reg(struct rte_eth_dev *dev, uint32_t bar, uint32_t reg)
 		return -1;
 	}
 
-	baseaddr = (uint64_t)qdma_dev->bar_addr[bar];
+	baseaddr = (uint64_t)proc_priv->bar_addr[bar];
 	if (!baseaddr) {
 		printf("Error: PCI BAR number:%d not mapped\n", bar);
 		return -1;
@@ -82,7 +86,7 @@ uint32_t qdma_pci_read_reg(struct rte_eth_dev *dev, uint32_t bar, uint32_t reg)
 void qdma_pci_write_reg(struct rte_eth_dev *dev, uint32_t bar,
 			uint32_t reg, uint32_t val)
 {
-	struct qdma_pci_dev *qdma_dev = dev->data->dev_private;
+	struct qdma_proc_priv *proc_priv = QDMA_PROC_PRIV(dev->data->port_id);
 	uint64_t baseaddr;
 
 	if (bar >= (QDMA_NUM_BARS - 1)) {
@@ -91,7 +95,7 @@ void qdma_pci_write_reg(struct rte_eth_dev *dev, uint32_t bar,
 		return;
 	}
 
-	baseaddr = (uint64_t)qdma_dev->bar_addr[bar];
+	baseaddr = (uint64_t)proc_priv->bar_addr[bar];
 	if (!baseaddr) {
 		printf("Error: PCI BAR number:%d not mapped\n", bar);
 		return;
@@ -105,7 +109,11 @@ void qdma_reset_rx_queue(struct qdma_rx_queue *rxq)
 	uint32_t sz;
 
 	rxq->rx_tail = 0;
+	rxq->rx_desc_pend = 0;
 	rxq->q_pidx_info.pidx = 0;
+	/* Rx interrupts start unarmed, see rx_queue_intr_enable */
+	rxq->q_pidx_info.irq_en = 0;
+	rxq->cmpt_cidx_info.irq_en = 0;
 
 	/* Zero out HW ring memory, For MM Descriptor */
 	if (rxq->st_mode) {  /** if ST-mode **/
@@ -126,6 +134,10 @@ void qdma_reset_rx_queue(struct qdma_rx_queue *rxq)
 	/* Initialize SW ring entries */
 	for (i = 0; i < rxq->nb_rx_desc; i++)
 		rxq->sw_ring[i] = NULL;
+
+	/* Return the external buffers still posted or being carved */
+	if (rxq->ext_buf)
+		qdma_rx_extbuf_release(rxq);
 }
 
 void qdma_inv_rx_queue_ctxts(struct rte_eth_dev *dev,
@@ -192,7 +204,7 @@ int qdma_init_rx_queue(struct qdma_rx_queue *rxq)
 	struct rte_mbuf *mb;
 	void *obj = NULL;
 	uint64_t phys_addr;
-	uint16_t i;
+	uint16_t i = 0;
 	struct qdma_ul_st_c2h_desc *rx_ring_st = NULL;
 
 	/* allocate new buffers for the Rx descriptor ring */
@@ -205,7 +217,18 @@ int qdma_init_rx_queue(struct qdma_rx_queue *rxq)
 				rte_mempool_avail_count(rxq->mb_pool),
 				rte_mempool_in_use_count(rxq->mb_pool));
 #endif //DUMP_MEMPOOL_USAGE_STATS
-		for (i = 0; i < (rxq->nb_rx_desc - 2); i++) {
+		/* external buffer slices take the place of the mbufs */
+		if (rxq->ext_buf) {
+			if (qdma_rx_extbuf_post(rxq, 0, rxq->nb_rx_desc - 2) !=
+					rxq->nb_rx_desc - 2) {
+				PMD_DRV_LOG(ERR, "%s(): %d: qid %d, external "
+					"buffer pool exhausted",
+					__func__, __LINE__, rxq->queue_id);
+				goto fail;
+			}
+			i = rxq->nb_rx_desc - 2;
+		}
+		for (; i < (rxq->nb_rx_desc - 2); i++) {
 			if (rte_mempool_get(rxq->mb_pool, &obj) != 0) {
 				PMD_DRV_LOG(ERR, "qdma-start-rx-queue(): "
 						"rte_mempool_get: failed");
@@ -443,6 +466,65 @@ static int h2c_byp_mode_check_handler(__rte_unused const char *key,
 	return 0;
 }
 
+static int tx_pidx_batch_handler(__rte_unused const char *key,
+					const char *value,  void *opaque)
+{
+	struct qdma_pci_dev *qdma_dev = (struct qdma_pci_dev *)opaque;
+	char *end = NULL;
+	unsigned long batch;
+
+	PMD_DRV_LOG(INFO, "QDMA devargs tx_pidx_batch is: %s\n", value);
+	batch = strtoul(value, &end, 10);
+	if (batch == 0 || batch > UINT16_MAX) {
+		PMD_DRV_LOG(INFO, "QDMA devargs incorrect "
+				"tx_pidx_batch = %lu specified\n", batch);
+		return -1;
+	}
+	qdma_dev->tx_pidx_batch = (uint16_t)batch;
+
+	return 0;
+}
+
+static int tx_pidx_timeout_handler(__rte_unused const char *key,
+					const char *value,  void *opaque)
+{
+	struct qdma_pci_dev *qdma_dev = (struct qdma_pci_dev *)opaque;
+	char *end = NULL;
+	unsigned long tmo;
+
+	PMD_DRV_LOG(INFO, "QDMA devargs tx_pidx_timeout is: %s\n", value);
+	tmo = strtoul(value, &end, 10);
+	if (tmo < QDMA_TXQ_PIDX_TMO_MIN || tmo > QDMA_TXQ_PIDX_TMO_MAX) {
+		PMD_DRV_LOG(INFO, "QDMA devargs incorrect "
+				"tx_pidx_timeout = %lu specified, range is "
+				"%u to %u usec\n", tmo, QDMA_TXQ_PIDX_TMO_MIN,
+				QDMA_TXQ_PIDX_TMO_MAX);
+		return -1;
+	}
+	qdma_dev->tx_pidx_timeout = (uint32_t)tmo;
+
+	return 0;
+}
+
+static int numa_policy_handler(__rte_unused const char *key,
+					const char *value,  void *opaque)
+{
+	struct qdma_pci_dev *qdma_dev = (struct qdma_pci_dev *)opaque;
+	char *end = NULL;
+	unsigned long policy;
+
+	PMD_DRV_LOG(INFO, "QDMA devargs numa_policy is: %s\n", value);
+	policy = strtoul(value, &end, 10);
+	if (policy >= QDMA_NUMA_POLICY_MAX) {
+		PMD_DRV_LOG(INFO, "QDMA devargs incorrect "
+				"numa_policy = %lu specified\n", policy);
+		return -1;
+	}
+	qdma_dev->numa_policy = (uint8_t)policy;
+
+	return 0;
+}
+
 /* Process the all devargs */
 int qdma_check_kvargs(struct rte_devargs *devargs,
 						struct qdma_pci_dev *qdma_dev)
@@ -454,6 +536,9 @@ int qdma_check_kvargs(struct rte_devargs *devargs,
 	const char *config_bar_key = "config_bar";
 	const char *c2h_byp_mode_key = "c2h_byp_mode";
 	const char *h2c_byp_mode_key = "h2c_byp_mode";
+	const char *tx_pidx_batch_key = "tx_pidx_batch";
+	const char *tx_pidx_timeout_key = "tx_pidx_timeout";
+	const char *numa_policy_key = "numa_policy";
 	int ret = 0;
 
 	if (!devargs)
@@ -523,21 +608,175 @@ int qdma_check_kvargs(struct rte_devargs *devargs,
 		}
 	}
 
+	/* process tx_pidx_batch*/
+	if (rte_kvargs_count(kvlist, tx_pidx_batch_key)) {
+		ret = rte_kvargs_process(kvlist, tx_pidx_batch_key,
+					  tx_pidx_batch_handler, qdma_dev);
+		if (ret) {
+			rte_kvargs_free(kvlist);
+			return ret;
+		}
+	}
+
+	/* process tx_pidx_timeout*/
+	if (rte_kvargs_count(kvlist, tx_pidx_timeout_key)) {
+		ret = rte_kvargs_process(kvlist, tx_pidx_timeout_key,
+					  tx_pidx_timeout_handler, qdma_dev);
+		if (ret) {
+			rte_kvargs_free(kvlist);
+			return ret;
+		}
+	}
+
+	/* process numa_policy*/
+	if (rte_kvargs_count(kvlist, numa_policy_key)) {
+		ret = rte_kvargs_process(kvlist, numa_policy_key,
+					  numa_policy_handler, qdma_dev);
+		if (ret) {
+			rte_kvargs_free(kvlist);
+			return ret;
+		}
+	}
+
 	rte_kvargs_free(kvlist);
 	return ret;
 }
 
+/**
+ * Socket for the rings of a queue the device writes to: descriptor
+ * rings, CMPT rings and their writeback status.
+ *
+ * @param dev
+ *   Pointer to Ethernet device structure.
+ * @param type
+ *   Queue type, for the log.
+ * @param qid
+ *   Queue index, for the log.
+ * @param socket_id
+ *   Socket given at queue setup, the one of the polling lcore.
+ *
+ * @return
+ *   Socket to reserve the ring memzones on.
+ */
+int qdma_ring_socket(struct rte_eth_dev *dev, const char *type,
+			uint16_t qid, unsigned int socket_id)
+{
+	struct qdma_pci_dev *qdma_dev = dev->data->dev_private;
+	int dev_socket = dev->device->numa_node;
+
+	if (dev_socket == SOCKET_ID_ANY || (int)socket_id == SOCKET_ID_ANY)
+		return socket_id;
+
+	if ((int)socket_id != dev_socket)
+		PMD_DRV_LOG(WARNING, "%s queue %d is setup on socket %u "
+				"but the device is on socket %d, %s\n",
+				type, qid, socket_id, dev_socket,
+				qdma_dev->numa_policy ==
+				QDMA_NUMA_DEVICE_RINGS ?
+				"ring polling crosses sockets" :
+				"device ring accesses cross sockets");
+
+	if (qdma_dev->numa_policy == QDMA_NUMA_DEVICE_RINGS)
+		return dev_socket;
+
+	return socket_id;
+}
+
+/* Same register selection as the access layer for the design */
+static inline int qdma_db_is_cpm(struct qdma_pci_dev *qdma_dev)
+{
+	return !qdma_dev->is_vf &&
+		qdma_dev->device_type == QDMA_DEVICE_VERSAL &&
+		qdma_dev->versal_ip_type == QDMA_VERSAL_HARD_IP;
+}
+
+/**
+ * Config BAR offset of the descriptor PIDX doorbell of a queue.
+ *
+ * @param qdma_dev
+ *   Pointer to QDMA device structure.
+ * @param qid
+ *   Queue index relative to the function.
+ * @param is_c2h
+ *   1 for the C2H ring, 0 for the H2C ring.
+ *
+ * @return
+ *   Register offset, 0 if the doorbell must go through hw_access.
+ */
+uint32_t qdma_pidx_db_offset(struct qdma_pci_dev *qdma_dev, uint16_t qid,
+			uint8_t is_c2h)
+{
+	uint32_t reg_addr;
+
+	if (qdma_dev->device_type == QDMA_DEVICE_VERSAL_CPM5 ||
+			qdma_dev->device_type == QDMA_DEVICE_NONE)
+		return 0;
+
+	if (qdma_dev->is_vf)
+		reg_addr = is_c2h ? QDMA_OFFSET_VF_DMAP_SEL_C2H_DSC_PIDX :
+			QDMA_OFFSET_VF_DMAP_SEL_H2C_DSC_PIDX;
+	else if (qdma_db_is_cpm(qdma_dev))
+		reg_addr = is_c2h ? QDMA_CPM_OFFSET_DMAP_SEL_C2H_DSC_PIDX :
+			QDMA_CPM_OFFSET_DMAP_SEL_H2C_DSC_PIDX;
+	else
+		reg_addr = is_c2h ? QDMA_OFFSET_DMAP_SEL_C2H_DSC_PIDX :
+			QDMA_OFFSET_DMAP_SEL_H2C_DSC_PIDX;
+
+	return reg_addr + qid * QDMA_PIDX_STEP;
+}
+
+/**
+ * Config BAR offset of the CMPT CIDX doorbell of a queue.
+ *
+ * @param qdma_dev
+ *   Pointer to QDMA device structure.
+ * @param qid
+ *   Queue index relative to the function.
+ *
+ * @return
+ *   Register offset, 0 if the doorbell must go through hw_access.
+ */
+uint32_t qdma_cmpt_cidx_db_offset(struct qdma_pci_dev *qdma_dev,
+			uint16_t qid)
+{
+	uint32_t reg_addr;
+
+	if (qdma_dev->device_type == QDMA_DEVICE_VERSAL_CPM5 ||
+			qdma_dev->device_type == QDMA_DEVICE_NONE)
+		return 0;
+
+	if (qdma_dev->is_vf)
+		reg_addr = QDMA_OFFSET_VF_DMAP_SEL_CMPT_CIDX;
+	else if (qdma_db_is_cpm(qdma_dev))
+		reg_addr = QDMA_CPM_OFFSET_DMAP_SEL_CMPT_CIDX;
+	else
+		reg_addr = QDMA_OFFSET_DMAP_SEL_CMPT_CIDX;
+
+	return reg_addr + qid * QDMA_CMPT_CIDX_STEP;
+}
+
+/* BAR resources of a port, from the PCI device or the emulated device */
+struct rte_mem_resource *qdma_mem_resource(struct rte_eth_dev *dev)
+{
+	struct qdma_pci_dev *dma_priv = dev->data->dev_private;
+
+	if (dma_priv->emu)
+		return qdma_emu_mem_resource(dma_priv->emu);
+
+	return RTE_ETH_DEV_TO_PCI(dev)->mem_resource;
+}
+
 int qdma_identify_bars(struct rte_eth_dev *dev)
 {
 	int      bar_len, i, ret;
 	uint8_t  usr_bar;
-	struct rte_pci_device *pci_dev = RTE_ETH_DEV_TO_PCI(dev);
+	struct rte_mem_resource *mem_resource = qdma_mem_resource(dev);
 	struct qdma_pci_dev *dma_priv;
 
 	dma_priv = (struct qdma_pci_dev *)dev->data->dev_private;
 
 	/* Config bar */
-	bar_len = pci_dev->mem_resource[dma_priv->config_bar_idx].len;
+	bar_len = mem_resource[dma_priv->config_bar_idx].len;
 	if (!bar_len) {
 		PMD_DRV_LOG(INFO, "QDMA config BAR index :%d is not enabled",
 					dma_priv->config_bar_idx);
@@ -548,10 +787,10 @@ int qdma_identify_bars(struct rte_eth_dev *dev)
 	ret = dma_priv->hw_access->qdma_get_user_bar(dev,
 			dma_priv->is_vf, &usr_bar);
 	if ((ret != QDMA_SUCCESS) ||
-			(pci_dev->mem_resource[usr_bar].len == 0)) {
+			(mem_resource[usr_bar].len == 0)) {
 		if ((dma_priv->device_type == QDMA_DEVICE_VERSAL) &&
 			(dma_priv->versal_ip_type == QDMA_VERSAL_HARD_IP)) {
-			if (pci_dev->mem_resource[1].len == 0)
+			if (mem_resource[1].len == 0)
 				dma_priv->user_bar_idx = 2;
 			else
 				dma_priv->user_bar_idx = 1;
@@ -564,7 +803,7 @@ int qdma_identify_bars(struct rte_eth_dev *dev)
 
 	/* Find bypass bar*/
 	for (i = 0; i < QDMA_NUM_BARS; i++) {
-		bar_len = pci_dev->mem_resource[i].len;
+		bar_len = mem_resource[i].len;
 		if (!bar_len) /* Bar not enabled ? */
 			continue;
 		if (dma_priv->user_bar_idx != i &&
@@ -612,3 +851,38 @@ int qdma_get_hw_version(struct rte_eth_dev *dev)
 
 	return 0;
 }
+
+/* Fill the process local BAR mappings and access layer function pointers
+ * of a port. The primary calls it once the BARs are identified, secondary
+ * processes at probe time using the BAR indexes the primary stored in the
+ * shared dev_private.
+ */
+int qdma_proc_priv_init(struct rte_eth_dev *dev)
+{
+	struct rte_mem_resource *mem_resource = qdma_mem_resource(dev);
+	struct qdma_pci_dev *dma_priv = dev->data->dev_private;
+	struct qdma_proc_priv *proc_priv = QDMA_PROC_PRIV(dev->data->port_id);
+	int bars[] = { dma_priv->config_bar_idx, dma_priv->user_bar_idx,
+			dma_priv->bypass_bar_idx };
+	unsigned int i;
+	int ret;
+
+	for (i = 0; i < RTE_DIM(bars); i++) {
+		if (bars[i] < 0 || bars[i] >= QDMA_NUM_BARS)
+			continue;
+		if (mem_resource[bars[i]].addr == NULL) {
+			PMD_DRV_LOG(ERR, "QDMA BAR index :%d is not mapped",
+					bars[i]);
+			return -ENODEV;
+		}
+		proc_priv->bar_addr[bars[i]] = mem_resource[bars[i]].addr;
+	}
+
+	proc_priv->config_bar = proc_priv->bar_addr[dma_priv->config_bar_idx];
+
+	ret = qdma_hw_access_init(dev, dma_priv->is_vf, &proc_priv->hw_access);
+	if (ret < 0)
+		return -EINVAL;
+
+	return 0;
+}
@@ -41,7 +41,6 @@
 #include <rte_pci.h>
 #include <rte_ether.h>
 #include <rte_ethdev.h>
-#include <rte_alarm.h>
 #include <rte_cycles.h>
 #include <unistd.h>
 #include <string.h>
@@ -205,6 +204,72 @@ uint8_t qmda_get_desc_sz_idx(enum rte_pmd_qdma_bypass_desc_len size)
 	return ret;
 }
 
+/**
+ * Switch a streaming Rx queue to external buffer mode.
+ *
+ * The tail of every ext_pool element holds the shared info of the
+ * buffer, the whole buf_sz slices in front of it are posted as C2H
+ * buffers.
+ *
+ * @param rxq
+ *   Pointer to Rx queue structure.
+ * @param ext_pool
+ *   Pool of the large buffers.
+ * @param buf_sz
+ *   C2H buffer size, one of the global CSR buffer sizes.
+ * @param socket_id
+ *   NUMA socket of the slot ring.
+ *
+ * @return
+ *   0 on success, negative errno value on failure.
+ */
+static int qdma_rx_extbuf_setup(struct qdma_rx_queue *rxq,
+		struct rte_mempool *ext_pool, uint16_t buf_sz,
+		unsigned int socket_id)
+{
+	uint32_t sz;
+
+	if (!rxq->st_mode) {
+		PMD_DRV_LOG(ERR, "External buffers need a streaming mode "
+				"queue, Qid %d\n", rxq->queue_id);
+		return -EINVAL;
+	}
+	if (buf_sz == 0 || ext_pool->elt_size <
+			sizeof(struct rte_mbuf_ext_shared_info) + buf_sz) {
+		PMD_DRV_LOG(ERR, "External buffer of %u bytes cannot hold a "
+				"%u bytes C2H buffer\n", ext_pool->elt_size,
+				buf_sz);
+		return -EINVAL;
+	}
+
+	rxq->ext_shinfo_off = RTE_ALIGN_FLOOR(ext_pool->elt_size -
+			sizeof(struct rte_mbuf_ext_shared_info),
+			sizeof(uintptr_t));
+	/* C2H buffer sizes need not be a power of two */
+	rxq->ext_len = (rxq->ext_shinfo_off / buf_sz) * buf_sz;
+	if (rxq->ext_len == 0) {
+		PMD_DRV_LOG(ERR, "External buffer of %u bytes cannot hold a "
+				"%u bytes C2H buffer\n", ext_pool->elt_size,
+				buf_sz);
+		return -EINVAL;
+	}
+
+	sz = rxq->nb_rx_desc * sizeof(struct qdma_rx_ext_slot);
+	rxq->ext_ring = rte_zmalloc_socket("RxExtRn", sz, RTE_CACHE_LINE_SIZE,
+			socket_id);
+	if (!rxq->ext_ring) {
+		PMD_DRV_LOG(ERR, "Unable to allocate rxq->ext_ring of size "
+				"%d\n", sz);
+		return -ENOMEM;
+	}
+
+	rxq->ext_pool = ext_pool;
+	rxq->rx_buff_size = buf_sz;
+	rxq->ext_buf = 1;
+
+	return 0;
+}
+
 /**
  * DPDK callback to configure a RX queue.
  *
@@ -215,7 +280,9 @@ uint8_t qmda_get_desc_sz_idx(enum rte_pmd_qdma_bypass_desc_len size)
  * @param nb_rx_desc
  *   Number of descriptors to configure in queue.
  * @param socket_id
- *   NUMA socket on which memory must be allocated.
+ *   NUMA socket of the polling lcore, the software rings are allocated
+ *   there and the hardware rings as well unless the numa_policy devarg
+ *   puts them on the device socket.
  * @param[in] rx_conf
  *   Thresholds parameters.
  * @param mp_pool
@@ -232,9 +299,9 @@ int qdma_dev_rx_queue_setup(struct rte_eth_dev *dev, uint16_t rx_queue_id,
 	struct qdma_pci_dev *qdma_dev = dev->data->dev_private;
 	struct qdma_rx_queue *rxq = NULL;
 	struct qdma_ul_mm_desc *rx_ring_mm;
-	struct rte_pci_device *pci_dev = RTE_ETH_DEV_TO_PCI(dev);
 	uint32_t sz;
 	uint8_t  *rx_ring_bypass;
+	int ring_socket;
 	int err = 0;
 
 	PMD_DRV_LOG(INFO, "Configuring Rx queue id:%d\n", rx_queue_id);
@@ -253,7 +320,8 @@ int qdma_dev_rx_queue_setup(struct rte_eth_dev *dev, uint16_t rx_queue_id,
 	}
 
 	if (!qdma_dev->is_vf) {
-		err = qdma_dev_increment_active_queue(pci_dev->addr.bus,
+		err = qdma_dev_increment_active_queue(
+						qdma_dev->dma_device_index,
 						qdma_dev->func_id,
 						QDMA_DEV_Q_TYPE_C2H);
 		if (err != QDMA_SUCCESS)
@@ -262,14 +330,14 @@ int qdma_dev_rx_queue_setup(struct rte_eth_dev *dev, uint16_t rx_queue_id,
 		if (qdma_dev->q_info[rx_queue_id].queue_mode ==
 				RTE_PMD_QDMA_STREAMING_MODE) {
 			err = qdma_dev_increment_active_queue(
-							pci_dev->addr.bus,
-							qdma_dev->func_id,
-							QDMA_DEV_Q_TYPE_CMPT);
+						qdma_dev->dma_device_index,
+						qdma_dev->func_id,
+						QDMA_DEV_Q_TYPE_CMPT);
 			if (err != QDMA_SUCCESS) {
 				qdma_dev_decrement_active_queue(
-							pci_dev->addr.bus,
-							qdma_dev->func_id,
-							QDMA_DEV_Q_TYPE_C2H);
+						qdma_dev->dma_device_index,
+						qdma_dev->func_id,
+						QDMA_DEV_Q_TYPE_C2H);
 				return -EINVAL;
 			}
 		}
@@ -306,9 +374,12 @@ int qdma_dev_rx_queue_setup(struct rte_eth_dev *dev, uint16_t rx_queue_id,
 		qdma_dev->init_q_range = 1;
 	}
 
+	/* Burst path fields must fit the first 128 bytes of the queue */
+	RTE_BUILD_BUG_ON(offsetof(struct qdma_rx_queue, rx_mz) != 128);
+
 	/* allocate rx queue data structure */
-	rxq = rte_zmalloc("QDMA_RxQ", sizeof(struct qdma_rx_queue),
-						RTE_CACHE_LINE_SIZE);
+	rxq = rte_zmalloc_socket("QDMA_RxQ", sizeof(struct qdma_rx_queue),
+						RTE_CACHE_LINE_SIZE, socket_id);
 	if (!rxq) {
 		PMD_DRV_LOG(ERR, "Unable to allocate structure rxq of "
 				"size %d\n",
@@ -323,6 +394,9 @@ int qdma_dev_rx_queue_setup(struct rte_eth_dev *dev, uint16_t rx_queue_id,
 	rxq->mb_pool = mb_pool;
 	rxq->dev = dev;
 	rxq->st_mode = qdma_dev->q_info[rx_queue_id].queue_mode;
+	rxq->pidx_db = qdma_pidx_db_offset(qdma_dev, rx_queue_id, 1);
+	if (rxq->st_mode)
+		rxq->cmpt_db = qdma_cmpt_cidx_db_offset(qdma_dev, rx_queue_id);
 	rxq->nb_rx_desc = (nb_rx_desc + 1);
 	/* <= 2018.2 IP
 	 * double the cmpl ring size to avoid run out of cmpl entry while
@@ -339,10 +413,30 @@ int qdma_dev_rx_queue_setup(struct rte_eth_dev *dev, uint16_t rx_queue_id,
 	}
 	rxq->triggermode = qdma_dev->q_info[rx_queue_id].trigger_mode;
 	rxq->rx_deferred_start = rx_conf->rx_deferred_start;
+	rxq->rx_free_thresh = (rx_conf->rx_free_thresh) ?
+			rx_conf->rx_free_thresh : DEFAULT_RX_FREE_THRESHOLD;
+	if (rxq->rx_free_thresh >= nb_rx_desc) {
+		PMD_DRV_LOG(ERR, "rx_free_thresh %d must be less than the "
+				"number of Rx descriptors %d\n",
+				rxq->rx_free_thresh, nb_rx_desc);
+		err = -EINVAL;
+		goto rx_setup_err;
+	}
 	rxq->dump_immediate_data =
 			qdma_dev->q_info[rx_queue_id].immediate_data_state;
 	rxq->dis_overflow_check =
 			qdma_dev->q_info[rx_queue_id].dis_cmpt_ovf_chk;
+	rxq->cmpt_ts_off = qdma_dev->q_info[rx_queue_id].cmpt_ts_off;
+	rxq->cmpt_meta_off = qdma_dev->q_info[rx_queue_id].cmpt_meta_off;
+	if (rxq->cmpt_ts_off + (int)sizeof(uint64_t) > rxq->cmpt_desc_len ||
+			rxq->cmpt_meta_off + (int)sizeof(uint32_t) >
+			rxq->cmpt_desc_len) {
+		PMD_DRV_LOG(ERR, "CMPT user field offsets %d/%d exceed the "
+				"%dB completion entry\n", rxq->cmpt_ts_off,
+				rxq->cmpt_meta_off, rxq->cmpt_desc_len);
+		err = -EINVAL;
+		goto rx_setup_err;
+	}
 
 	if (qdma_dev->q_info[rx_queue_id].rx_bypass_mode ==
 				RTE_PMD_QDMA_RX_BYPASS_CACHE ||
@@ -417,6 +511,16 @@ int qdma_dev_rx_queue_setup(struct rte_eth_dev *dev, uint16_t rx_queue_id,
 	rxq->rx_buff_size = (uint16_t)
 				(rte_pktmbuf_data_room_size(rxq->mb_pool) -
 				RTE_PKTMBUF_HEADROOM);
+	ring_socket = qdma_ring_socket(dev, "Rx", rx_queue_id, socket_id);
+	/* mb_pool then only provides the mbufs attached to the buffers */
+	if (qdma_dev->q_info[rx_queue_id].ext_pool) {
+		err = qdma_rx_extbuf_setup(rxq,
+				qdma_dev->q_info[rx_queue_id].ext_pool,
+				qdma_dev->q_info[rx_queue_id].ext_buf_sz,
+				socket_id);
+		if (err < 0)
+			goto rx_setup_err;
+	}
 	/* Allocate memory for Rx descriptor ring */
 	if (rxq->st_mode) {
 		if (!qdma_dev->dev_cap.st_en) {
@@ -444,7 +548,7 @@ int qdma_dev_rx_queue_setup(struct rte_eth_dev *dev, uint16_t rx_queue_id,
 					sizeof(struct qdma_ul_st_c2h_desc);
 
 		rxq->rx_mz = qdma_zone_reserve(dev, "RxHwRn", rx_queue_id,
-						sz, socket_id);
+						sz, ring_socket);
 		if (!rxq->rx_mz) {
 			PMD_DRV_LOG(ERR, "Unable to allocate rxq->rx_mz "
 					"of size %d\n", sz);
@@ -457,7 +561,7 @@ int qdma_dev_rx_queue_setup(struct rte_eth_dev *dev, uint16_t rx_queue_id,
 		/* Allocate memory for Rx completion(CMPT) descriptor ring */
 		sz = (rxq->nb_rx_cmpt_desc) * rxq->cmpt_desc_len;
 		rxq->rx_cmpt_mz = qdma_zone_reserve(dev, "RxHwCmptRn",
-						    rx_queue_id, sz, socket_id);
+						    rx_queue_id, sz, ring_socket);
 		if (!rxq->rx_cmpt_mz) {
 			PMD_DRV_LOG(ERR, "Unable to allocate rxq->rx_cmpt_mz "
 					"of size %d\n", sz);
@@ -486,7 +590,7 @@ int qdma_dev_rx_queue_setup(struct rte_eth_dev *dev, uint16_t rx_queue_id,
 		else
 			sz = (rxq->nb_rx_desc) * sizeof(struct qdma_ul_mm_desc);
 		rxq->rx_mz = qdma_zone_reserve(dev, "RxHwRn",
-						rx_queue_id, sz, socket_id);
+						rx_queue_id, sz, ring_socket);
 		if (!rxq->rx_mz) {
 			PMD_DRV_LOG(ERR, "Unable to allocate rxq->rx_mz "
 					"of size %d\n", sz);
@@ -510,7 +614,8 @@ int qdma_dev_rx_queue_setup(struct rte_eth_dev *dev, uint16_t rx_queue_id,
 
 	/* allocate memory for RX software ring */
 	sz = (rxq->nb_rx_desc) * sizeof(struct rte_mbuf *);
-	rxq->sw_ring = rte_zmalloc("RxSwRn", sz, RTE_CACHE_LINE_SIZE);
+	rxq->sw_ring = rte_zmalloc_socket("RxSwRn", sz, RTE_CACHE_LINE_SIZE,
+					socket_id);
 	if (!rxq->sw_ring) {
 		PMD_DRV_LOG(ERR, "Unable to allocate rxq->sw_ring of size %d\n",
 									sz);
@@ -518,6 +623,10 @@ int qdma_dev_rx_queue_setup(struct rte_eth_dev *dev, uint16_t rx_queue_id,
 		goto rx_setup_err;
 	}
 
+#ifdef RTE_ARCH_X86
+	qdma_rx_vec_setup(rxq);
+#endif
+
 	/* store rx_pkt_burst function pointer */
 	dev->rx_pkt_burst = qdma_recv_pkts;
 	dev->data->rx_queues[rx_queue_id] = rxq;
@@ -526,13 +635,14 @@ int qdma_dev_rx_queue_setup(struct rte_eth_dev *dev, uint16_t rx_queue_id,
 
 rx_setup_err:
 	if (!qdma_dev->is_vf) {
-		qdma_dev_decrement_active_queue(pci_dev->addr.bus,
+		qdma_dev_decrement_active_queue(qdma_dev->dma_device_index,
 						qdma_dev->func_id,
 						QDMA_DEV_Q_TYPE_C2H);
 
 		if (qdma_dev->q_info[rx_queue_id].queue_mode ==
 				RTE_PMD_QDMA_STREAMING_MODE)
-			qdma_dev_decrement_active_queue(pci_dev->addr.bus,
+			qdma_dev_decrement_active_queue(
+						qdma_dev->dma_device_index,
 						qdma_dev->func_id,
 						QDMA_DEV_Q_TYPE_CMPT);
 	} else {
@@ -550,6 +660,8 @@ rx_setup_err:
 			rte_memzone_free(rxq->rx_mz);
 		if (rxq->sw_ring)
 			rte_free(rxq->sw_ring);
+		if (rxq->ext_ring)
+			rte_free(rxq->ext_ring);
 		rte_free(rxq);
 	}
 	return err;
@@ -565,7 +677,9 @@ rx_setup_err:
  * @param nb_tx_desc
  *   Number of descriptors to configure in queue.
  * @param socket_id
- *   NUMA socket on which memory must be allocated.
+ *   NUMA socket of the polling lcore, the software rings are allocated
+ *   there and the hardware rings as well unless the numa_policy devarg
+ *   puts them on the device socket.
  * @param[in] tx_conf
  *   Thresholds parameters.
  *
@@ -580,16 +694,17 @@ int qdma_dev_tx_queue_setup(struct rte_eth_dev *dev, uint16_t tx_queue_id,
 	struct qdma_tx_queue *txq = NULL;
 	struct qdma_ul_mm_desc *tx_ring_mm;
 	struct qdma_ul_st_h2c_desc *tx_ring_st;
-	struct rte_pci_device *pci_dev = RTE_ETH_DEV_TO_PCI(dev);
 	uint32_t sz;
 	uint8_t  *tx_ring_bypass;
+	int ring_socket;
 	int err = 0;
 
 	PMD_DRV_LOG(INFO, "Configuring Tx queue id:%d with %d desc\n",
 		    tx_queue_id, nb_tx_desc);
 
 	if (!qdma_dev->is_vf) {
-		err = qdma_dev_increment_active_queue(pci_dev->addr.bus,
+		err = qdma_dev_increment_active_queue(
+						qdma_dev->dma_device_index,
 						qdma_dev->func_id,
 						QDMA_DEV_Q_TYPE_H2C);
 		if (err != QDMA_SUCCESS)
@@ -617,9 +732,12 @@ int qdma_dev_tx_queue_setup(struct rte_eth_dev *dev, uint16_t tx_queue_id,
 		}
 		qdma_dev->init_q_range = 1;
 	}
+	/* Burst path fields must fit the first 128 bytes of the queue */
+	RTE_BUILD_BUG_ON(offsetof(struct qdma_tx_queue, tx_mz) != 128);
+
 	/* allocate rx queue data structure */
-	txq = rte_zmalloc("QDMA_TxQ", sizeof(struct qdma_tx_queue),
-						RTE_CACHE_LINE_SIZE);
+	txq = rte_zmalloc_socket("QDMA_TxQ", sizeof(struct qdma_tx_queue),
+						RTE_CACHE_LINE_SIZE, socket_id);
 	if (txq == NULL) {
 		PMD_DRV_LOG(ERR, "Memory allocation failed for "
 				"Tx queue SW structure\n");
@@ -636,8 +754,19 @@ int qdma_dev_tx_queue_setup(struct rte_eth_dev *dev, uint16_t tx_queue_id,
 	txq->dev = dev;
 	txq->port_id = dev->data->port_id;
 	txq->func_id = qdma_dev->func_id;
+	txq->pidx_db = qdma_pidx_db_offset(qdma_dev, tx_queue_id, 0);
 	txq->num_queues = dev->data->nb_tx_queues;
 	txq->tx_deferred_start = tx_conf->tx_deferred_start;
+	txq->offloads = tx_conf->offloads | dev->data->dev_conf.txmode.offloads;
+	txq->tx_free_thresh = (tx_conf->tx_free_thresh) ?
+			tx_conf->tx_free_thresh : DEFAULT_TX_FREE_THRESHOLD;
+	if (txq->tx_free_thresh >= (nb_tx_desc - 1)) {
+		PMD_DRV_LOG(ERR, "tx_free_thresh %d must be less than the "
+				"number of descriptors minus 1 (%d)\n",
+				txq->tx_free_thresh, nb_tx_desc - 1);
+		err = -EINVAL;
+		goto tx_setup_err;
+	}
 
 	txq->ringszidx = index_of_array(qdma_dev->g_ring_sz,
 					QDMA_NUM_RING_SIZES, txq->nb_tx_desc);
@@ -648,6 +777,7 @@ int qdma_dev_tx_queue_setup(struct rte_eth_dev *dev, uint16_t tx_queue_id,
 		goto tx_setup_err;
 	}
 
+	ring_socket = qdma_ring_socket(dev, "Tx", tx_queue_id, socket_id);
 	/* Allocate memory for TX descriptor ring */
 	if (txq->st_mode) {
 		if (!qdma_dev->dev_cap.st_en) {
@@ -664,7 +794,7 @@ int qdma_dev_tx_queue_setup(struct rte_eth_dev *dev, uint16_t tx_queue_id,
 			sz = (txq->nb_tx_desc) *
 					sizeof(struct qdma_ul_st_h2c_desc);
 		txq->tx_mz = qdma_zone_reserve(dev, "TxHwRn", tx_queue_id, sz,
-						socket_id);
+						ring_socket);
 		if (!txq->tx_mz) {
 			PMD_DRV_LOG(ERR, "Couldn't reserve memory for "
 					"ST H2C ring of size %d\n", sz);
@@ -699,7 +829,7 @@ int qdma_dev_tx_queue_setup(struct rte_eth_dev *dev, uint16_t tx_queue_id,
 		else
 			sz = (txq->nb_tx_desc) * sizeof(struct qdma_ul_mm_desc);
 		txq->tx_mz = qdma_zone_reserve(dev, "TxHwRn", tx_queue_id,
-						sz, socket_id);
+						sz, ring_socket);
 		if (!txq->tx_mz) {
 			PMD_DRV_LOG(ERR, "Couldn't reserve memory for "
 					"MM H2C ring of size %d\n", sz);
@@ -728,7 +858,8 @@ int qdma_dev_tx_queue_setup(struct rte_eth_dev *dev, uint16_t tx_queue_id,
 
 	/* Allocate memory for TX software ring */
 	sz = txq->nb_tx_desc * sizeof(struct rte_mbuf *);
-	txq->sw_ring = rte_zmalloc("TxSwRn", sz, RTE_CACHE_LINE_SIZE);
+	txq->sw_ring = rte_zmalloc_socket("TxSwRn", sz, RTE_CACHE_LINE_SIZE,
+					socket_id);
 	if (txq->sw_ring == NULL) {
 		PMD_DRV_LOG(ERR, "Memory allocation failed for "
 				 "Tx queue SW ring\n");
@@ -736,7 +867,15 @@ int qdma_dev_tx_queue_setup(struct rte_eth_dev *dev, uint16_t tx_queue_id,
 		goto tx_setup_err;
 	}
 
-	rte_spinlock_init(&txq->pidx_update_lock);
+	txq->tx_pidx_batch = RTE_MIN(qdma_dev->tx_pidx_batch,
+					(uint16_t)(nb_tx_desc / 2));
+	if (!txq->tx_pidx_batch)
+		txq->tx_pidx_batch = 1;
+	txq->tx_pidx_tmo = (rte_get_timer_hz() / US_PER_S) *
+				qdma_dev->tx_pidx_timeout;
+#ifdef RTE_ARCH_X86
+	qdma_tx_vec_setup(txq);
+#endif
 	/* store tx_pkt_burst function pointer */
 	dev->tx_pkt_burst = qdma_xmit_pkts;
 	dev->data->tx_queues[tx_queue_id] = txq;
@@ -746,7 +885,7 @@ int qdma_dev_tx_queue_setup(struct rte_eth_dev *dev, uint16_t tx_queue_id,
 tx_setup_err:
 	PMD_DRV_LOG(ERR, " Tx queue setup failed");
 	if (!qdma_dev->is_vf)
-		qdma_dev_decrement_active_queue(pci_dev->addr.bus,
+		qdma_dev_decrement_active_queue(qdma_dev->dma_device_index,
 						qdma_dev->func_id,
 						QDMA_DEV_Q_TYPE_H2C);
 	else
@@ -762,32 +901,6 @@ tx_setup_err:
 	return err;
 }
 
-#if (MIN_TX_PIDX_UPDATE_THRESHOLD > 1)
-void qdma_txq_pidx_update(void *arg)
-{
-	struct rte_eth_dev *dev = (struct rte_eth_dev *)arg;
-	struct qdma_pci_dev *qdma_dev = dev->data->dev_private;
-	struct qdma_tx_queue *txq;
-	uint32_t qid;
-
-	for (qid = 0; qid < dev->data->nb_tx_queues; qid++) {
-		txq = (struct qdma_tx_queue *)dev->data->tx_queues[qid];
-		if (txq->tx_desc_pend) {
-			rte_spinlock_lock(&txq->pidx_update_lock);
-			if (txq->tx_desc_pend) {
-				qdma_dev->hw_access->qdma_queue_pidx_update(dev,
-					qdma_dev->is_vf,
-					qid, 0, &txq->q_pidx_info);
-
-				txq->tx_desc_pend = 0;
-			}
-			rte_spinlock_unlock(&txq->pidx_update_lock);
-		}
-	}
-	rte_eal_alarm_set(QDMA_TXQ_PIDX_UPDATE_INTERVAL,
-			qdma_txq_pidx_update, (void *)arg);
-}
-#endif
 
 
 
@@ -795,17 +908,16 @@ void qdma_dev_tx_queue_release(void *tqueue)
 {
 	struct qdma_tx_queue *txq = (struct qdma_tx_queue *)tqueue;
 	struct qdma_pci_dev *qdma_dev;
-	struct rte_pci_device *pci_dev;
 
 	if (txq != NULL) {
 		PMD_DRV_LOG(INFO, "Remove H2C queue: %d", txq->queue_id);
 		qdma_dev = txq->dev->data->dev_private;
-		pci_dev = RTE_ETH_DEV_TO_PCI(txq->dev);
 
 		if (!qdma_dev->is_vf)
-			qdma_dev_decrement_active_queue(pci_dev->addr.bus,
-							qdma_dev->func_id,
-							QDMA_DEV_Q_TYPE_H2C);
+			qdma_dev_decrement_active_queue(
+						qdma_dev->dma_device_index,
+						qdma_dev->func_id,
+						QDMA_DEV_Q_TYPE_H2C);
 		else
 			qdma_dev_notify_qdel(txq->dev, txq->queue_id +
 						qdma_dev->queue_base,
@@ -823,20 +935,19 @@ void qdma_dev_rx_queue_release(void *rqueue)
 {
 	struct qdma_rx_queue *rxq = (struct qdma_rx_queue *)rqueue;
 	struct qdma_pci_dev *qdma_dev = NULL;
-	struct rte_pci_device *pci_dev = NULL;
 
 	if (rxq != NULL) {
 		PMD_DRV_LOG(INFO, "Remove C2H queue: %d", rxq->queue_id);
 		qdma_dev = rxq->dev->data->dev_private;
-		pci_dev = RTE_ETH_DEV_TO_PCI(rxq->dev);
 
 		if (!qdma_dev->is_vf) {
-			qdma_dev_decrement_active_queue(pci_dev->addr.bus,
+			qdma_dev_decrement_active_queue(
+					qdma_dev->dma_device_index,
 					qdma_dev->func_id, QDMA_DEV_Q_TYPE_C2H);
 
 			if (rxq->st_mode)
 				qdma_dev_decrement_active_queue(
-					pci_dev->addr.bus,
+					qdma_dev->dma_device_index,
 					qdma_dev->func_id,
 					QDMA_DEV_Q_TYPE_CMPT);
 		} else {
@@ -852,6 +963,8 @@ void qdma_dev_rx_queue_release(void *rqueue)
 
 		if (rxq->sw_ring)
 			rte_free(rxq->sw_ring);
+		if (rxq->ext_ring)
+			rte_free(rxq->ext_ring);
 		if (rxq->st_mode) { /** if ST-mode **/
 			if (rxq->rx_cmpt_mz)
 				rte_memzone_free(rxq->rx_cmpt_mz);
@@ -883,6 +996,10 @@ static int qdma_dev_start(struct rte_eth_dev *dev)
 
 	PMD_DRV_LOG(INFO, "qdma-dev-start: Starting\n");
 
+	err = qdma_dev_rx_intr_setup(dev);
+	if (err != 0)
+		return err;
+
 	/* prepare descriptor rings for operation */
 	for (qid = 0; qid < dev->data->nb_tx_queues; qid++) {
 		txq = (struct qdma_tx_queue *)dev->data->tx_queues[qid];
@@ -891,7 +1008,7 @@ static int qdma_dev_start(struct rte_eth_dev *dev)
 		if (!txq->tx_deferred_start) {
 			err = qdma_dev_tx_queue_start(dev, qid);
 			if (err != 0)
-				return err;
+				goto start_err;
 		}
 	}
 
@@ -902,15 +1019,24 @@ static int qdma_dev_start(struct rte_eth_dev *dev)
 		if (!rxq->rx_deferred_start) {
 			err = qdma_dev_rx_queue_start(dev, qid);
 			if (err != 0)
-				return err;
+				goto start_err;
 		}
 	}
 
-#if (MIN_TX_PIDX_UPDATE_THRESHOLD > 1)
-	rte_eal_alarm_set(QDMA_TXQ_PIDX_UPDATE_INTERVAL,
-			qdma_txq_pidx_update, (void *)dev);
-#endif
 	return 0;
+
+start_err:
+	/* undo what was started so far, so that start can be retried */
+	for (qid = 0; qid < dev->data->nb_tx_queues; qid++)
+		if (dev->data->tx_queue_state[qid] ==
+				RTE_ETH_QUEUE_STATE_STARTED)
+			qdma_dev_tx_queue_stop(dev, qid);
+	for (qid = 0; qid < dev->data->nb_rx_queues; qid++)
+		if (dev->data->rx_queue_state[qid] ==
+				RTE_ETH_QUEUE_STATE_STARTED)
+			qdma_dev_rx_queue_stop(dev, qid);
+	qdma_dev_rx_intr_teardown(dev);
+	return err;
 }
 
 /**
@@ -950,6 +1076,9 @@ static void qdma_dev_infos_get(struct rte_eth_dev *dev,
 	dev_info->min_rx_bufsize = QDMA_MIN_RXBUFF_SIZE;
 	dev_info->max_rx_pktlen = DMA_BRAM_SIZE;
 	dev_info->max_mac_addrs = 1;
+	dev_info->tx_offload_capa = QDMA_TX_OFFLOAD_CAPA;
+	dev_info->default_txconf.tx_free_thresh = DEFAULT_TX_FREE_THRESHOLD;
+	dev_info->default_rxconf.rx_free_thresh = DEFAULT_RX_FREE_THRESHOLD;
 }
 
 /**
@@ -976,11 +1105,7 @@ static void qdma_dev_stop(struct rte_eth_dev *dev)
 	for (qid = 0; qid < dev->data->nb_rx_queues; qid++)
 		qdma_dev_rx_queue_stop(dev, qid);
 
-#if (MIN_TX_PIDX_UPDATE_THRESHOLD > 1)
-	/* Cancel pending PIDX updates */
-	rte_eal_alarm_cancel(qdma_txq_pidx_update, (void *)dev);
-#endif
-
+	qdma_dev_rx_intr_teardown(dev);
 }
 
 /**
@@ -994,7 +1119,6 @@ static void qdma_dev_stop(struct rte_eth_dev *dev)
 void qdma_dev_close(struct rte_eth_dev *dev)
 {
 	struct qdma_pci_dev *qdma_dev = dev->data->dev_private;
-	struct rte_pci_device *pci_dev = RTE_ETH_DEV_TO_PCI(dev);
 	struct qdma_tx_queue *txq;
 	struct qdma_rx_queue *rxq;
 	struct qdma_cmpt_queue *cmptq;
@@ -1018,17 +1142,20 @@ void qdma_dev_close(struct rte_eth_dev *dev)
 
 			if (rxq->sw_ring)
 				rte_free(rxq->sw_ring);
+			if (rxq->ext_ring)
+				rte_free(rxq->ext_ring);
 			if (rxq->st_mode) { /** if ST-mode **/
 				if (rxq->rx_cmpt_mz)
 					rte_memzone_free(rxq->rx_cmpt_mz);
 			}
 
-			qdma_dev_decrement_active_queue(pci_dev->addr.bus,
+			qdma_dev_decrement_active_queue(
+					qdma_dev->dma_device_index,
 					qdma_dev->func_id, QDMA_DEV_Q_TYPE_C2H);
 
 			if (rxq->st_mode)
 				qdma_dev_decrement_active_queue(
-					pci_dev->addr.bus,
+					qdma_dev->dma_device_index,
 					qdma_dev->func_id,
 					QDMA_DEV_Q_TYPE_CMPT);
 
@@ -1052,7 +1179,8 @@ void qdma_dev_close(struct rte_eth_dev *dev)
 			rte_free(txq);
 			PMD_DRV_LOG(INFO, "H2C queue %d removed", qid);
 
-			qdma_dev_decrement_active_queue(pci_dev->addr.bus,
+			qdma_dev_decrement_active_queue(
+					qdma_dev->dma_device_index,
 					qdma_dev->func_id, QDMA_DEV_Q_TYPE_H2C);
 		}
 	}
@@ -1069,7 +1197,7 @@ void qdma_dev_close(struct rte_eth_dev *dev)
 				PMD_DRV_LOG(INFO, "PF-%d(DEVFN) CMPT queue %d removed",
 						qdma_dev->func_id, qid);
 				qdma_dev_decrement_active_queue(
-					pci_dev->addr.bus,
+					qdma_dev->dma_device_index,
 					qdma_dev->func_id,
 					QDMA_DEV_Q_TYPE_CMPT);
 			}
@@ -1081,7 +1209,7 @@ void qdma_dev_close(struct rte_eth_dev *dev)
 		}
 	}
 	qdma_dev->qsets_en = 0;
-	qdma_dev_update(pci_dev->addr.bus, qdma_dev->func_id,
+	qdma_dev_update(qdma_dev->dma_device_index, qdma_dev->func_id,
 			qdma_dev->qsets_en, (int *)&qdma_dev->queue_base);
 	qdma_dev->init_q_range = 0;
 	rte_free(qdma_dev->q_info);
@@ -1102,7 +1230,6 @@ void qdma_dev_close(struct rte_eth_dev *dev)
 static int qdma_dev_configure(struct rte_eth_dev *dev)
 {
 	struct qdma_pci_dev *qdma_dev = dev->data->dev_private;
-	struct rte_pci_device *pci_dev = RTE_ETH_DEV_TO_PCI(dev);
 	uint16_t qid = 0;
 	int ret = 0, queue_base = -1;
 
@@ -1120,7 +1247,7 @@ static int qdma_dev_configure(struct rte_eth_dev *dev)
 	}
 
 	/* Request queue base from the resource manager */
-	ret = qdma_dev_update(pci_dev->addr.bus, qdma_dev->func_id,
+	ret = qdma_dev_update(qdma_dev->dma_device_index, qdma_dev->func_id,
 			qdma_dev->qsets_en, &queue_base);
 	if (ret != QDMA_SUCCESS) {
 		PMD_DRV_LOG(ERR, "PF-%d(DEVFN) queue allocation failed: %d\n",
@@ -1128,7 +1255,7 @@ static int qdma_dev_configure(struct rte_eth_dev *dev)
 		return -1;
 	}
 
-	ret = qdma_dev_qinfo_get(pci_dev->addr.bus, qdma_dev->func_id,
+	ret = qdma_dev_qinfo_get(qdma_dev->dma_device_index, qdma_dev->func_id,
 				(int *)&qdma_dev->queue_base,
 				&qdma_dev->qsets_en);
 	if (ret != QDMA_SUCCESS) {
@@ -1137,7 +1264,8 @@ static int qdma_dev_configure(struct rte_eth_dev *dev)
 		return -1;
 	}
 	PMD_DRV_LOG(INFO, "Bus: 0x%x, PF-%d(DEVFN) queue_base: %d\n",
-		pci_dev->addr.bus, qdma_dev->func_id, qdma_dev->queue_base);
+		qdma_dev->dma_device_index, qdma_dev->func_id,
+		qdma_dev->queue_base);
 
 	qdma_dev->q_info = rte_zmalloc("qinfo", sizeof(struct queue_info) *
 					(qdma_dev->qsets_en), 0);
@@ -1180,6 +1308,9 @@ static int qdma_dev_configure(struct rte_eth_dev *dev)
 						qdma_dev->c2h_bypass_mode;
 		qdma_dev->q_info[qid].en_prefetch = qdma_dev->en_desc_prefetch;
 		qdma_dev->q_info[qid].immediate_data_state = 0;
+		qdma_dev->q_info[qid].cmpt_ts_off = RTE_PMD_QDMA_CMPT_FIELD_NONE;
+		qdma_dev->q_info[qid].cmpt_meta_off =
+						RTE_PMD_QDMA_CMPT_FIELD_NONE;
 	}
 
 	for (qid = 0 ; qid < dev->data->nb_tx_queues; qid++)
@@ -1320,6 +1451,10 @@ int qdma_dev_rx_queue_start(struct rte_eth_dev *dev, uint16_t qid)
 		q_cmpt_ctxt.valid = 1;
 		if (qdma_dev->dev_cap.cmpt_ovf_chk_dis)
 			q_cmpt_ctxt.ovf_chk_dis = rxq->dis_overflow_check;
+		if (rxq->intr_vec) {
+			q_cmpt_ctxt.en_int = 1;
+			q_cmpt_ctxt.vec = rxq->intr_vec;
+		}
 
 
 		q_sw_ctxt.desc_sz = SW_DESC_CNTXT_C2H_STREAM_DMA;
@@ -1329,6 +1464,10 @@ int qdma_dev_rx_queue_start(struct rte_eth_dev *dev, uint16_t qid)
 		q_sw_ctxt.is_mm = 1;
 		q_sw_ctxt.wbi_chk = 1;
 		q_sw_ctxt.wbi_intvl_en = 1;
+		if (rxq->intr_vec) {
+			q_sw_ctxt.irq_en = 1;
+			q_sw_ctxt.vec = rxq->intr_vec;
+		}
 	}
 
 	q_sw_ctxt.fnc_id = rxq->func_id;
@@ -1432,6 +1571,12 @@ int qdma_dev_rx_queue_stop(struct rte_eth_dev *dev, uint16_t qid)
 			rte_mempool_avail_count(rxq->mb_pool),
 			rte_mempool_in_use_count(rxq->mb_pool));
 #endif //DUMP_MEMPOOL_USAGE_STATS
+	} else {
+		/* Free buffers still posted to the MM descriptor ring */
+		for (i = 0; i < rxq->nb_rx_desc - 1; i++) {
+			rte_pktmbuf_free(rxq->sw_ring[i]);
+			rxq->sw_ring[i] = NULL;
+		}
 	}
 
 	qdma_reset_rx_queue(rxq);
@@ -1452,6 +1597,8 @@ int qdma_dev_tx_queue_stop(struct rte_eth_dev *dev, uint16_t qid)
 	txq = (struct qdma_tx_queue *)dev->data->tx_queues[qid];
 
 	txq->status = RTE_ETH_QUEUE_STATE_STOPPED;
+	/* Hand over descriptors still held back by doorbell coalescing */
+	qdma_tx_pidx_flush(txq);
 	/* Wait for TXQ to send out all packets. */
 	while (txq->wb_status->cidx != txq->q_pidx_info.pidx) {
 		usleep(10);
@@ -1482,6 +1629,8 @@ int qdma_dev_stats_get(struct rte_eth_dev *dev,
 	for (i = 0; i < dev->data->nb_rx_queues; i++) {
 		struct qdma_rx_queue *rxq =
 			(struct qdma_rx_queue *)dev->data->rx_queues[i];
+		if (rxq == NULL)
+			continue;
 		if (i < RTE_ETHDEV_QUEUE_STAT_CNTRS) {
 			eth_stats->q_ipackets[i] = rxq->stats.pkts;
 			eth_stats->q_ibytes[i] = rxq->stats.bytes;
@@ -1493,6 +1642,8 @@ int qdma_dev_stats_get(struct rte_eth_dev *dev,
 	for (i = 0; i < dev->data->nb_tx_queues; i++) {
 		struct qdma_tx_queue *txq =
 			(struct qdma_tx_queue *)dev->data->tx_queues[i];
+		if (txq == NULL)
+			continue;
 		if (i < RTE_ETHDEV_QUEUE_STAT_CNTRS) {
 			eth_stats->q_opackets[i] = txq->stats.pkts;
 			eth_stats->q_obytes[i] = txq->stats.bytes;
@@ -1503,6 +1654,430 @@ int qdma_dev_stats_get(struct rte_eth_dev *dev,
 	return 0;
 }
 
+/**
+ * DPDK callback to reset the basic device statistics.
+ *
+ * @param dev
+ *   Pointer to Ethernet device structure.
+ */
+void qdma_dev_stats_reset(struct rte_eth_dev *dev)
+{
+	struct qdma_rx_queue *rxq;
+	struct qdma_tx_queue *txq;
+	unsigned int i;
+
+	for (i = 0; i < dev->data->nb_rx_queues; i++) {
+		rxq = (struct qdma_rx_queue *)dev->data->rx_queues[i];
+		if (rxq != NULL)
+			memset(&rxq->stats, 0, sizeof(rxq->stats));
+	}
+
+	for (i = 0; i < dev->data->nb_tx_queues; i++) {
+		txq = (struct qdma_tx_queue *)dev->data->tx_queues[i];
+		if (txq != NULL)
+			memset(&txq->stats, 0, sizeof(txq->stats));
+	}
+}
+
+struct qdma_xstats_name_off {
+	char name[RTE_ETH_XSTATS_NAME_SIZE];
+	unsigned int offset;
+};
+
+#define QDMA_XSTATS_BURST_SIZE_NAMES \
+	{"burst_size_0", offsetof(struct qdma_q_xstats, burst_size[0])}, \
+	{"burst_size_1", offsetof(struct qdma_q_xstats, burst_size[1])}, \
+	{"burst_size_2_3", offsetof(struct qdma_q_xstats, burst_size[2])}, \
+	{"burst_size_4_7", offsetof(struct qdma_q_xstats, burst_size[3])}, \
+	{"burst_size_8_15", offsetof(struct qdma_q_xstats, burst_size[4])}, \
+	{"burst_size_16_31", offsetof(struct qdma_q_xstats, burst_size[5])}, \
+	{"burst_size_32_63", offsetof(struct qdma_q_xstats, burst_size[6])}, \
+	{"burst_size_64_127", offsetof(struct qdma_q_xstats, burst_size[7])}, \
+	{"burst_size_128_plus", offsetof(struct qdma_q_xstats, burst_size[8])}
+
+static const struct qdma_xstats_name_off qdma_rxq_xstats_strings[] = {
+	{"bursts", offsetof(struct qdma_q_xstats, bursts)},
+	{"mbuf_alloc_failed", offsetof(struct qdma_q_xstats,
+					mbuf_alloc_failed)},
+	{"cmpt_err_drops", offsetof(struct qdma_q_xstats, cmpt_err)},
+	{"pidx_updates", offsetof(struct qdma_q_xstats, pidx_updates)},
+	{"cidx_updates", offsetof(struct qdma_q_xstats, cidx_updates)},
+	QDMA_XSTATS_BURST_SIZE_NAMES,
+};
+
+static const struct qdma_xstats_name_off qdma_txq_xstats_strings[] = {
+	{"bursts", offsetof(struct qdma_q_xstats, bursts)},
+	{"queue_full", offsetof(struct qdma_q_xstats, queue_full)},
+	{"pidx_updates", offsetof(struct qdma_q_xstats, pidx_updates)},
+	QDMA_XSTATS_BURST_SIZE_NAMES,
+};
+
+/* Device wide hardware error counters, indexed by enum qdma_hw_err_aggr */
+static const char * const qdma_hw_err_xstats_strings[] = {
+	"hw_err_dsc",
+	"hw_err_trq",
+	"hw_err_st_c2h",
+	"hw_err_st_fatal",
+	"hw_err_st_h2c",
+	"hw_err_ram_sbe",
+	"hw_err_ram_dbe",
+};
+
+/* Each queue also reports avg_ring_occupancy after its counters */
+#define QDMA_NB_RXQ_XSTATS	(RTE_DIM(qdma_rxq_xstats_strings) + 1)
+#define QDMA_NB_TXQ_XSTATS	(RTE_DIM(qdma_txq_xstats_strings) + 1)
+
+/* Only the master PF processes hardware errors */
+static unsigned int qdma_hw_err_xstats_count(struct rte_eth_dev *dev)
+{
+	struct qdma_pci_dev *qdma_dev = dev->data->dev_private;
+
+	RTE_BUILD_BUG_ON(RTE_DIM(qdma_hw_err_xstats_strings) !=
+			QDMA_HW_ERR_AGGR_MAX);
+
+	return qdma_dev->is_master ? RTE_DIM(qdma_hw_err_xstats_strings) : 0;
+}
+
+static unsigned int qdma_xstats_count(struct rte_eth_dev *dev)
+{
+	return dev->data->nb_rx_queues * QDMA_NB_RXQ_XSTATS +
+		dev->data->nb_tx_queues * QDMA_NB_TXQ_XSTATS +
+		qdma_hw_err_xstats_count(dev);
+}
+
+/* Fill the values of one queue, returns the number of entries written */
+static unsigned int qdma_xstats_fill(const struct qdma_q_xstats *qxs,
+			const struct qdma_xstats_name_off *strings,
+			unsigned int nb_strings, struct rte_eth_xstat *xstats,
+			unsigned int idx)
+{
+	unsigned int i;
+
+	for (i = 0; i < nb_strings; i++) {
+		xstats[idx + i].id = idx + i;
+		xstats[idx + i].value = *(const uint64_t *)
+				((const char *)qxs + strings[i].offset);
+	}
+
+	xstats[idx + i].id = idx + i;
+	xstats[idx + i].value = qxs->bursts ?
+			qxs->ring_occupancy / qxs->bursts : 0;
+
+	return nb_strings + 1;
+}
+
+/**
+ * DPDK callback to get the extended per queue and hardware error
+ * statistics.
+ *
+ * @param dev
+ *   Pointer to Ethernet device structure.
+ * @param[out] xstats
+ *   Array to store the statistics.
+ * @param n
+ *   Number of entries in the array.
+ *
+ * @return
+ *   Number of statistics of the device, array is only filled if
+ *   it is large enough.
+ */
+int qdma_dev_xstats_get(struct rte_eth_dev *dev, struct rte_eth_xstat *xstats,
+			unsigned int n)
+{
+	/* reported for queues not set up, keeps the ids of the others */
+	static const struct qdma_q_xstats zero_xstats;
+	struct qdma_pci_dev *qdma_dev = dev->data->dev_private;
+	unsigned int count = qdma_xstats_count(dev);
+	unsigned int idx = 0, i;
+	struct qdma_rx_queue *rxq;
+	struct qdma_tx_queue *txq;
+
+	if (xstats == NULL || n < count)
+		return count;
+
+	for (i = 0; i < dev->data->nb_rx_queues; i++) {
+		rxq = (struct qdma_rx_queue *)dev->data->rx_queues[i];
+		idx += qdma_xstats_fill(rxq ? &rxq->xstats : &zero_xstats,
+				qdma_rxq_xstats_strings,
+				RTE_DIM(qdma_rxq_xstats_strings), xstats, idx);
+	}
+
+	for (i = 0; i < dev->data->nb_tx_queues; i++) {
+		txq = (struct qdma_tx_queue *)dev->data->tx_queues[i];
+		idx += qdma_xstats_fill(txq ? &txq->xstats : &zero_xstats,
+				qdma_txq_xstats_strings,
+				RTE_DIM(qdma_txq_xstats_strings), xstats, idx);
+	}
+
+	for (i = 0; i < qdma_hw_err_xstats_count(dev); i++, idx++) {
+		xstats[idx].id = idx;
+		xstats[idx].value = qdma_dev->hw_err_cnt[i];
+	}
+
+	return count;
+}
+
+/**
+ * DPDK callback to get the names of the extended statistics.
+ *
+ * @param dev
+ *   Pointer to Ethernet device structure.
+ * @param[out] xstats_names
+ *   Array to store the names, may be NULL to query the count.
+ * @param size
+ *   Number of entries in the array.
+ *
+ * @return
+ *   Number of statistics of the device.
+ */
+int qdma_dev_xstats_get_names(struct rte_eth_dev *dev,
+			struct rte_eth_xstat_name *xstats_names,
+			unsigned int size)
+{
+	unsigned int count = qdma_xstats_count(dev);
+	unsigned int idx = 0, i, j;
+
+	if (xstats_names == NULL || size < count)
+		return count;
+
+	for (i = 0; i < dev->data->nb_rx_queues; i++) {
+		for (j = 0; j < RTE_DIM(qdma_rxq_xstats_strings); j++)
+			snprintf(xstats_names[idx++].name,
+				sizeof(xstats_names[0].name), "rx_q%u_%s",
+				i, qdma_rxq_xstats_strings[j].name);
+		snprintf(xstats_names[idx++].name,
+			sizeof(xstats_names[0].name),
+			"rx_q%u_avg_ring_occupancy", i);
+	}
+
+	for (i = 0; i < dev->data->nb_tx_queues; i++) {
+		for (j = 0; j < RTE_DIM(qdma_txq_xstats_strings); j++)
+			snprintf(xstats_names[idx++].name,
+				sizeof(xstats_names[0].name), "tx_q%u_%s",
+				i, qdma_txq_xstats_strings[j].name);
+		snprintf(xstats_names[idx++].name,
+			sizeof(xstats_names[0].name),
+			"tx_q%u_avg_ring_occupancy", i);
+	}
+
+	for (i = 0; i < qdma_hw_err_xstats_count(dev); i++)
+		snprintf(xstats_names[idx++].name,
+			sizeof(xstats_names[0].name), "%s",
+			qdma_hw_err_xstats_strings[i]);
+
+	return count;
+}
+
+/**
+ * DPDK callback to reset the extended and basic statistics.
+ *
+ * @param dev
+ *   Pointer to Ethernet device structure.
+ */
+void qdma_dev_xstats_reset(struct rte_eth_dev *dev)
+{
+	struct qdma_pci_dev *qdma_dev = dev->data->dev_private;
+	struct qdma_rx_queue *rxq;
+	struct qdma_tx_queue *txq;
+	unsigned int i;
+
+	for (i = 0; i < dev->data->nb_rx_queues; i++) {
+		rxq = (struct qdma_rx_queue *)dev->data->rx_queues[i];
+		if (rxq != NULL)
+			memset(&rxq->xstats, 0, sizeof(rxq->xstats));
+	}
+
+	for (i = 0; i < dev->data->nb_tx_queues; i++) {
+		txq = (struct qdma_tx_queue *)dev->data->tx_queues[i];
+		if (txq != NULL)
+			memset(&txq->xstats, 0, sizeof(txq->xstats));
+	}
+
+	memset(qdma_dev->hw_err_cnt, 0, sizeof(qdma_dev->hw_err_cnt));
+
+	qdma_dev_stats_reset(dev);
+}
+
+/**
+ * Bind the Rx queues to MSI-X vectors when Rx interrupts are requested
+ * through intr_conf.rxq. Vector 0 stays with the mailbox, each Rx queue
+ * gets its own eventfd from RTE_INTR_VEC_RXTX_OFFSET on and the queues
+ * beyond the available eventfds share the last one.
+ *
+ * @param dev
+ *   Pointer to Ethernet device structure.
+ *
+ * @return
+ *   0 on success, negative errno value on failure.
+ */
+int qdma_dev_rx_intr_setup(struct rte_eth_dev *dev)
+{
+	struct qdma_pci_dev *qdma_dev = dev->data->dev_private;
+	struct rte_intr_handle *intr_handle;
+	struct qdma_rx_queue *rxq;
+	uint32_t nb_vec, qid;
+	int err;
+
+	if (!dev->data->dev_conf.intr_conf.rxq || !dev->data->nb_rx_queues)
+		return 0;
+
+	if (qdma_dev->emu) {
+		PMD_DRV_LOG(ERR, "Rx interrupts are not emulated\n");
+		return -ENOTSUP;
+	}
+
+	intr_handle = &RTE_ETH_DEV_TO_PCI(dev)->intr_handle;
+	if (!rte_intr_cap_multiple(intr_handle)) {
+		PMD_DRV_LOG(ERR, "Rx interrupts need MSI-X through vfio-pci\n");
+		return -ENOTSUP;
+	}
+
+	nb_vec = RTE_MIN((uint32_t)dev->data->nb_rx_queues,
+			(uint32_t)RTE_MAX_RXTX_INTR_VEC_ID);
+
+	/* MSI-X is reprogrammed below with the mailbox and queue vectors */
+	rte_intr_disable(intr_handle);
+
+	err = rte_intr_efd_enable(intr_handle, nb_vec);
+	if (err != 0) {
+		PMD_DRV_LOG(ERR, "Failed to create %d Rx interrupt eventfds\n",
+				nb_vec);
+		goto intr_setup_err;
+	}
+
+	intr_handle->intr_vec = rte_zmalloc("qdma_intr_vec",
+			dev->data->nb_rx_queues * sizeof(int), 0);
+	if (intr_handle->intr_vec == NULL) {
+		PMD_DRV_LOG(ERR, "Failed to allocate Rx interrupt vector map\n");
+		err = -ENOMEM;
+		goto intr_setup_err;
+	}
+
+	for (qid = 0; qid < dev->data->nb_rx_queues; qid++) {
+		rxq = (struct qdma_rx_queue *)dev->data->rx_queues[qid];
+		rxq->intr_vec = RTE_INTR_VEC_RXTX_OFFSET +
+				RTE_MIN(qid, intr_handle->nb_efd - 1);
+		intr_handle->intr_vec[qid] = rxq->intr_vec;
+	}
+
+	err = rte_intr_enable(intr_handle);
+	if (err != 0) {
+		PMD_DRV_LOG(ERR, "Failed to enable %d MSI-X vectors\n",
+				intr_handle->nb_efd + 1);
+		goto intr_setup_err;
+	}
+	qdma_error_intr_resume(dev);
+
+	return 0;
+
+intr_setup_err:
+	qdma_dev_rx_intr_teardown(dev);
+	return err;
+}
+
+/**
+ * Release the Rx queue interrupt vectors set up by
+ * qdma_dev_rx_intr_setup() and restore the mailbox and error interrupts.
+ *
+ * @param dev
+ *   Pointer to Ethernet device structure.
+ */
+void qdma_dev_rx_intr_teardown(struct rte_eth_dev *dev)
+{
+	struct qdma_pci_dev *qdma_dev = dev->data->dev_private;
+	struct rte_intr_handle *intr_handle;
+	struct qdma_rx_queue *rxq;
+	uint32_t qid;
+
+	if (!dev->data->dev_conf.intr_conf.rxq || qdma_dev->emu)
+		return;
+
+	intr_handle = &RTE_ETH_DEV_TO_PCI(dev)->intr_handle;
+	rte_intr_disable(intr_handle);
+	rte_intr_efd_disable(intr_handle);
+	rte_free(intr_handle->intr_vec);
+	intr_handle->intr_vec = NULL;
+
+	for (qid = 0; qid < dev->data->nb_rx_queues; qid++) {
+		rxq = (struct qdma_rx_queue *)dev->data->rx_queues[qid];
+		if (rxq != NULL)
+			rxq->intr_vec = 0;
+	}
+
+	if (qdma_dev->dev_cap.mailbox_intr || qdma_dev->err_intr_en) {
+		rte_intr_enable(intr_handle);
+		qdma_error_intr_resume(dev);
+	}
+}
+
+/**
+ * DPDK callback to arm the interrupt of an Rx queue.
+ *
+ * The interrupt fires once, on the next completion of the queue, and has
+ * to be armed again after it was taken.
+ *
+ * @param dev
+ *   Pointer to Ethernet device structure.
+ * @param qid
+ *   Rx queue index.
+ *
+ * @return
+ *   0 on success, negative errno value on failure.
+ */
+int qdma_dev_rx_queue_intr_enable(struct rte_eth_dev *dev, uint16_t qid)
+{
+	struct qdma_pci_dev *qdma_dev = dev->data->dev_private;
+	struct qdma_hw_access *hw_access =
+			&QDMA_PROC_PRIV(dev->data->port_id)->hw_access;
+	struct qdma_rx_queue *rxq;
+
+	rxq = (struct qdma_rx_queue *)dev->data->rx_queues[qid];
+	if (!rxq->intr_vec || rxq->status != RTE_ETH_QUEUE_STATE_STARTED)
+		return -EINVAL;
+
+	if (rxq->st_mode) {
+		if (rxq->cmpt_moder_upd)
+			qdma_rx_cmpt_moder_update(rxq);
+		rxq->cmpt_cidx_info.irq_en = 1;
+		hw_access->qdma_queue_cmpt_cidx_update(dev,
+				qdma_dev->is_vf, qid, &rxq->cmpt_cidx_info);
+	} else {
+		rxq->q_pidx_info.irq_en = 1;
+		hw_access->qdma_queue_pidx_update(dev,
+				qdma_dev->is_vf, qid, 1, &rxq->q_pidx_info);
+	}
+
+	return 0;
+}
+
+/**
+ * DPDK callback to stop arming the interrupt of an Rx queue.
+ *
+ * The data path leaves the interrupt unarmed from the next CIDX/PIDX
+ * update on, so no register access is needed here.
+ *
+ * @param dev
+ *   Pointer to Ethernet device structure.
+ * @param qid
+ *   Rx queue index.
+ *
+ * @return
+ *   0 on success, negative errno value on failure.
+ */
+int qdma_dev_rx_queue_intr_disable(struct rte_eth_dev *dev, uint16_t qid)
+{
+	struct qdma_rx_queue *rxq;
+
+	rxq = (struct qdma_rx_queue *)dev->data->rx_queues[qid];
+	if (!rxq->intr_vec)
+		return -EINVAL;
+
+	rxq->cmpt_cidx_info.irq_en = 0;
+	rxq->q_pidx_info.irq_en = 0;
+
+	return 0;
+}
+
 static struct eth_dev_ops qdma_eth_dev_ops = {
 	.dev_configure        = qdma_dev_configure,
 	.dev_infos_get        = qdma_dev_infos_get,
@@ -1518,14 +2093,24 @@ static struct eth_dev_ops qdma_eth_dev_ops = {
 	.rx_queue_stop	  = qdma_dev_rx_queue_stop,
 	.tx_queue_start	  = qdma_dev_tx_queue_start,
 	.tx_queue_stop	  = qdma_dev_tx_queue_stop,
+	.rx_queue_intr_enable = qdma_dev_rx_queue_intr_enable,
+	.rx_queue_intr_disable = qdma_dev_rx_queue_intr_disable,
 	.stats_get		  = qdma_dev_stats_get,
+	.stats_reset          = qdma_dev_stats_reset,
+	.xstats_get           = qdma_dev_xstats_get,
+	.xstats_get_names     = qdma_dev_xstats_get_names,
+	.xstats_reset         = qdma_dev_xstats_reset,
+	.rx_queue_count       = qdma_dev_rx_queue_count,
+	.rx_descriptor_status = qdma_dev_rx_descriptor_status,
+	.tx_descriptor_status = qdma_dev_tx_descriptor_status,
 };
 
 void qdma_dev_ops_init(struct rte_eth_dev *dev)
 {
 	dev->dev_ops = &qdma_eth_dev_ops;
-	if (rte_eal_process_type() == RTE_PROC_PRIMARY) {
-		dev->rx_pkt_burst = &qdma_recv_pkts;
-		dev->tx_pkt_burst = &qdma_xmit_pkts;
-	}
+	/* Burst functions only touch shared queue memory and the process
+	 * local state of struct qdma_proc_priv, so secondaries get them too
+	 */
+	dev->rx_pkt_burst = &qdma_recv_pkts;
+	dev->tx_pkt_burst = &qdma_xmit_pkts;
 }
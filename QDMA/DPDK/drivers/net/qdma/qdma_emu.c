@@ -0,0 +1,790 @@
+/*-
+ * BSD LICENSE
+ *
+ * Copyright(c) 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <rte_malloc.h>
+#include <rte_memcpy.h>
+#include <rte_memory.h>
+#include <rte_eal.h>
+#include <rte_service.h>
+#include <rte_service_component.h>
+#include <rte_spinlock.h>
+
+#include "qdma.h"
+#include "qdma_emu.h"
+
+#define QDMA_EMU_CONFIG_BAR		(0)
+#define QDMA_EMU_CONFIG_BAR_SIZE	(0x20000)
+#define QDMA_EMU_USER_BAR		(2)
+#define QDMA_EMU_USER_BAR_SIZE		(0x1000)
+
+/* Example design user logic registers, as driven by the testapp */
+#define QDMA_EMU_UL_C2H_ST_QID		0x0
+#define QDMA_EMU_UL_C2H_ST_LEN		0x4
+#define QDMA_EMU_UL_C2H_CONTROL		0x8
+#define     QDMA_EMU_UL_LOOPBACK_EN	BIT(0)
+#define     QDMA_EMU_UL_C2H_START	BIT(1)
+#define QDMA_EMU_UL_H2C_CONTROL		0xC
+#define     QDMA_EMU_UL_H2C_CLEAR	BIT(0)
+#define QDMA_EMU_UL_H2C_STATUS		0x10
+#define QDMA_EMU_UL_C2H_PKT_COUNT	0x20
+
+/* Indirect context command register fields */
+#define QDMA_EMU_CTXT_CMD_SEL_MASK	GENMASK(4, 1)
+#define QDMA_EMU_CTXT_CMD_OP_MASK	GENMASK(6, 5)
+#define QDMA_EMU_CTXT_CMD_QID_MASK	GENMASK(17, 7)
+
+#define QDMA_EMU_NUM_CTXT_SEL		(QDMA_CTXT_SEL_FMAP + 1)
+#define QDMA_EMU_QUEUES			QDMA_QUEUES_NUM_MAX
+/* Descriptors or packets a queue moves per service call */
+#define QDMA_EMU_BUDGET			(64)
+#define QDMA_EMU_MAX_PKT_LEN		QDMA_UL_ST_CMPT_LEN_MASK
+
+struct qdma_emu_ring {
+	uint8_t		*base;
+	uint32_t	size;	/* usable entries, writeback status excluded */
+	uint32_t	entry_sz;
+	uint32_t	idx;	/* CIDX of descriptor rings, PIDX of CMPT */
+	uint8_t		color;
+	uint8_t		en;
+	uint8_t		is_mm;
+	uint8_t		wbk;
+};
+
+struct qdma_emu_queue {
+	struct qdma_emu_ring	h2c;
+	struct qdma_emu_ring	c2h;
+	struct qdma_emu_ring	cmpt;
+	uint32_t		c2h_buf_sz;
+	uint8_t			c2h_done; /* C2H writeback pending */
+};
+
+struct qdma_emu {
+	struct rte_mem_resource	mem_resource[QDMA_NUM_BARS];
+	uint32_t		device_index;
+	uint32_t		service_id;
+	rte_spinlock_t		lock;
+	uint8_t			*bram;
+	uint16_t		qbase;
+	uint16_t		nb_active;
+	/* hw queues with a ring the service has to poll */
+	uint16_t		active[QDMA_EMU_QUEUES];
+	struct qdma_emu_queue	q[QDMA_EMU_QUEUES];
+	uint32_t		ctxt[QDMA_EMU_NUM_CTXT_SEL][QDMA_EMU_QUEUES]
+				    [QDMA_IND_CTXT_DATA_NUM_REGS];
+};
+
+static uint32_t qdma_emu_count;
+
+static inline volatile uint32_t *qdma_emu_reg(struct qdma_emu *emu,
+		int bar, uint32_t reg_offst)
+{
+	return (volatile uint32_t *)
+		((uint8_t *)emu->mem_resource[bar].addr + reg_offst);
+}
+
+static inline uint32_t qdma_emu_rd(struct qdma_emu *emu, int bar,
+		uint32_t reg_offst)
+{
+	return *qdma_emu_reg(emu, bar, reg_offst);
+}
+
+static inline void qdma_emu_wr(struct qdma_emu *emu, int bar,
+		uint32_t reg_offst, uint32_t val)
+{
+	*qdma_emu_reg(emu, bar, reg_offst) = val;
+}
+
+/* Queue doorbells are indexed by the function relative queue id */
+static inline uint32_t qdma_emu_db_offst(struct qdma_emu *emu,
+		uint32_t reg_offst, uint16_t qid)
+{
+	return reg_offst + (qid - emu->qbase) * QDMA_PIDX_STEP;
+}
+
+/*
+ * Queue state is indexed by the absolute hw qid, the doorbells need it
+ * to belong to the function as well
+ */
+static inline int qdma_emu_qid_valid(struct qdma_emu *emu, uint32_t qid)
+{
+	return qid >= emu->qbase && qid < QDMA_EMU_QUEUES;
+}
+
+static void *qdma_emu_iova2virt(uint64_t iova)
+{
+	if (rte_eal_iova_mode() == RTE_IOVA_VA)
+		return (void *)(uintptr_t)iova;
+
+	return rte_mem_iova2virt(iova);
+}
+
+static inline uint8_t *qdma_emu_ring_entry(struct qdma_emu_ring *ring)
+{
+	return ring->base + ring->idx * ring->entry_sz;
+}
+
+static inline void qdma_emu_ring_next(struct qdma_emu_ring *ring)
+{
+	if (++ring->idx == ring->size) {
+		ring->idx = 0;
+		ring->color ^= 1;
+	}
+}
+
+/* Entries from the device index up to the index written by the driver */
+static inline uint32_t qdma_emu_ring_avail(struct qdma_emu_ring *ring,
+		uint32_t drv_idx)
+{
+	if (drv_idx >= ring->size)
+		return 0;
+
+	return (drv_idx + ring->size - ring->idx) % ring->size;
+}
+
+static void qdma_emu_ring_wb(struct qdma_emu_ring *ring, int is_pidx)
+{
+	struct wb_status *wb_status;
+
+	if (!ring->wbk)
+		return;
+
+	wb_status = (struct wb_status *)(ring->base +
+			ring->size * ring->entry_sz);
+	/* data and ring entries are visible before the status */
+	rte_wmb();
+	if (is_pidx)
+		wb_status->pidx = ring->idx;
+	else
+		wb_status->cidx = ring->idx;
+}
+
+static void qdma_emu_ring_error(struct qdma_emu_ring *ring, uint16_t qid,
+		const char *what)
+{
+	PMD_DRV_LOG(ERR, "hw qid %u: %s, ring stopped", qid, what);
+	ring->en = 0;
+}
+
+static int qdma_emu_ring_init(struct qdma_emu *emu,
+		struct qdma_emu_ring *ring, uint16_t qid, uint64_t base,
+		uint32_t rng_sz_idx, uint32_t entry_sz)
+{
+	uint32_t nb_entries;
+
+	if (!qdma_emu_qid_valid(emu, qid)) {
+		PMD_DRV_LOG(ERR, "hw qid %u is outside of the function", qid);
+		return -EINVAL;
+	}
+
+	nb_entries = qdma_emu_rd(emu, QDMA_EMU_CONFIG_BAR,
+			QDMA_OFFSET_GLBL_RNG_SZ + rng_sz_idx * 4);
+	if (nb_entries < 2) {
+		PMD_DRV_LOG(ERR, "hw qid %u: invalid ring size %u",
+				qid, nb_entries);
+		return -EINVAL;
+	}
+
+	ring->base = qdma_emu_iova2virt(base);
+	if (ring->base == NULL) {
+		PMD_DRV_LOG(ERR, "hw qid %u: ring address 0x%" PRIx64
+				" is not mapped", qid, base);
+		return -EFAULT;
+	}
+
+	ring->size = nb_entries - 1;
+	ring->entry_sz = entry_sz;
+	ring->idx = 0;
+	ring->en = 1;
+
+	return 0;
+}
+
+static void qdma_emu_sw_ctxt_load(struct qdma_emu *emu, uint16_t qid,
+		struct qdma_emu_ring *ring, const uint32_t *ctxt,
+		uint32_t pidx_reg)
+{
+	uint32_t w0 = ctxt[0], w1 = ctxt[1];
+	uint64_t base = ((uint64_t)ctxt[3] << 32) | ctxt[2];
+	uint32_t pidx;
+
+	ring->en = 0;
+	if (!FIELD_GET(QDMA_SW_CTXT_W1_QEN_MASK, w1))
+		return;
+
+	if (FIELD_GET(QDMA_SW_CTXT_W1_BYP_MASK, w1)) {
+		PMD_DRV_LOG(ERR, "hw qid %u: descriptor bypass is not "
+				"emulated", qid);
+		return;
+	}
+
+	if (qdma_emu_ring_init(emu, ring, qid, base,
+			FIELD_GET(QDMA_SW_CTXT_W1_RNG_SZ_MASK, w1),
+			8 << FIELD_GET(QDMA_SW_CTXT_W1_DSC_SZ_MASK, w1)))
+		return;
+
+	ring->is_mm = FIELD_GET(QDMA_SW_CTXT_W1_IS_MM_MASK, w1);
+	ring->wbk = FIELD_GET(QDMA_SW_CTXT_W1_WBK_EN_MASK, w1);
+
+	pidx = FIELD_GET(QDMA_SW_CTXT_W0_PIDX, w0);
+	qdma_emu_wr(emu, QDMA_EMU_CONFIG_BAR,
+			qdma_emu_db_offst(emu, pidx_reg, qid), pidx);
+}
+
+static void qdma_emu_cmpt_ctxt_load(struct qdma_emu *emu, uint16_t qid,
+		const uint32_t *ctxt)
+{
+	struct qdma_emu_ring *ring = &emu->q[qid].cmpt;
+	uint32_t w0 = ctxt[0], w1 = ctxt[1], w2 = ctxt[2], w3 = ctxt[3];
+	uint64_t base;
+	uint32_t cidx;
+
+	ring->en = 0;
+	if (!FIELD_GET(QDMA_COMPL_CTXT_W3_VALID_MASK, w3))
+		return;
+
+	base = ((uint64_t)FIELD_GET(QDMA_COMPL_CTXT_W1_BADDR_64_L_MASK, w1)
+			<< 12) |
+		((uint64_t)FIELD_GET(QDMA_COMPL_CTXT_W2_BADDR_64_H_MASK, w2)
+			<< 38);
+	if (qdma_emu_ring_init(emu, ring, qid, base,
+			FIELD_GET(QDMA_COMPL_CTXT_W0_RING_SZ_MASK, w0),
+			8 << FIELD_GET(QDMA_COMPL_CTXT_W2_DESC_SIZE_MASK, w2)))
+		return;
+
+	ring->color = FIELD_GET(QDMA_COMPL_CTXT_W0_COLOR_MASK, w0);
+	ring->wbk = FIELD_GET(QDMA_COMPL_CTXT_W0_EN_STAT_DESC_MASK, w0);
+
+	cidx = FIELD_GET(QDMA_COMPL_CTXT_W3_CIDX_MASK, w3);
+	qdma_emu_wr(emu, QDMA_EMU_CONFIG_BAR,
+			qdma_emu_db_offst(emu, QDMA_OFFSET_DMAP_SEL_CMPT_CIDX,
+			qid), cidx);
+}
+
+static inline int qdma_emu_queue_active(struct qdma_emu_queue *q)
+{
+	return q->h2c.en || (q->c2h.en && q->c2h.is_mm);
+}
+
+static void qdma_emu_update_active(struct qdma_emu *emu)
+{
+	uint16_t qid;
+
+	emu->nb_active = 0;
+	for (qid = 0; qid < QDMA_EMU_QUEUES; qid++)
+		if (qdma_emu_queue_active(&emu->q[qid]))
+			emu->active[emu->nb_active++] = qid;
+}
+
+/* Side effects of a context update on the queue state of the device */
+static void qdma_emu_ctxt_apply(struct qdma_emu *emu, uint32_t sel,
+		uint16_t qid)
+{
+	struct qdma_emu_queue *q = &emu->q[qid];
+	uint32_t *ctxt = emu->ctxt[sel][qid];
+	int was_active = qdma_emu_queue_active(q);
+	uint32_t val;
+
+	switch (sel) {
+	case QDMA_CTXT_SEL_SW_C2H:
+		qdma_emu_sw_ctxt_load(emu, qid, &q->c2h, ctxt,
+				QDMA_OFFSET_DMAP_SEL_C2H_DSC_PIDX);
+		break;
+	case QDMA_CTXT_SEL_SW_H2C:
+		qdma_emu_sw_ctxt_load(emu, qid, &q->h2c, ctxt,
+				QDMA_OFFSET_DMAP_SEL_H2C_DSC_PIDX);
+		break;
+	case QDMA_CTXT_SEL_CMPT:
+		qdma_emu_cmpt_ctxt_load(emu, qid, ctxt);
+		break;
+	case QDMA_CTXT_SEL_PFTCH:
+		val = ctxt[0];
+		val = FIELD_GET(QDMA_PFTCH_CTXT_W0_BUF_SIZE_IDX_MASK, val);
+		q->c2h_buf_sz = qdma_emu_rd(emu, QDMA_EMU_CONFIG_BAR,
+				QDMA_OFFSET_C2H_BUF_SZ + val * 4);
+		break;
+	case QDMA_CTXT_SEL_FMAP:
+		/* indexed by function, only PF0 is emulated */
+		if (qid == 0) {
+			val = ctxt[0];
+			emu->qbase = FIELD_GET(QDMA_FMAP_CTXT_W0_QID_MASK, val);
+		}
+		break;
+	default:
+		break;
+	}
+
+	if (qdma_emu_queue_active(q) != was_active)
+		qdma_emu_update_active(emu);
+}
+
+static void qdma_emu_ctxt_cmd(struct qdma_emu *emu, uint32_t cmd)
+{
+	uint32_t sel = FIELD_GET(QDMA_EMU_CTXT_CMD_SEL_MASK, cmd);
+	uint32_t op = FIELD_GET(QDMA_EMU_CTXT_CMD_OP_MASK, cmd);
+	uint32_t qid = FIELD_GET(QDMA_EMU_CTXT_CMD_QID_MASK, cmd);
+	uint32_t data, mask, *ctxt;
+	struct qdma_emu_ring *ring;
+	int i;
+
+	if (sel >= QDMA_EMU_NUM_CTXT_SEL)
+		return;
+
+	ctxt = emu->ctxt[sel][qid];
+	switch (op) {
+	case QDMA_CTXT_CMD_WR:
+		for (i = 0; i < QDMA_IND_CTXT_DATA_NUM_REGS; i++) {
+			data = qdma_emu_rd(emu, QDMA_EMU_CONFIG_BAR,
+					QDMA_OFFSET_IND_CTXT_DATA + i * 4);
+			mask = qdma_emu_rd(emu, QDMA_EMU_CONFIG_BAR,
+					QDMA_OFFSET_IND_CTXT_MASK + i * 4);
+			ctxt[i] = (ctxt[i] & ~mask) | (data & mask);
+		}
+		break;
+	case QDMA_CTXT_CMD_RD:
+		for (i = 0; i < QDMA_IND_CTXT_DATA_NUM_REGS; i++)
+			qdma_emu_wr(emu, QDMA_EMU_CONFIG_BAR,
+					QDMA_OFFSET_IND_CTXT_DATA + i * 4,
+					ctxt[i]);
+		/* the HW context reports the consumer index of the ring */
+		if (sel == QDMA_CTXT_SEL_HW_C2H ||
+				sel == QDMA_CTXT_SEL_HW_H2C) {
+			ring = (sel == QDMA_CTXT_SEL_HW_C2H) ?
+				&emu->q[qid].c2h : &emu->q[qid].h2c;
+			data = (ctxt[0] & ~QDMA_HW_CTXT_W0_CIDX_MASK) |
+				ring->idx;
+			qdma_emu_wr(emu, QDMA_EMU_CONFIG_BAR,
+					QDMA_OFFSET_IND_CTXT_DATA, data);
+		}
+		return;
+	default:
+		/* clear and invalidate */
+		memset(ctxt, 0, sizeof(emu->ctxt[sel][qid]));
+		break;
+	}
+
+	qdma_emu_ctxt_apply(emu, sel, qid);
+}
+
+static void qdma_emu_fill_pattern(uint8_t *buf, uint32_t off, uint32_t len)
+{
+	uint32_t i;
+	uint16_t val;
+
+	/* 16-bit little endian counter starting at 0 for every packet */
+	for (i = 0; i < len; i++) {
+		val = (off + i) / 2;
+		buf[i] = ((off + i) & 1) ? (val >> 8) : (val & 0xFF);
+	}
+}
+
+/*
+ * Write one packet to the C2H ST queue. The data comes from an H2C
+ * descriptor in loopback mode, or from the pattern generator when NULL.
+ * Returns -EAGAIN while the queue is not started or has no room.
+ */
+static int qdma_emu_c2h_st_pkt(struct qdma_emu *emu, uint16_t qid,
+		const uint8_t *data, uint32_t len)
+{
+	struct qdma_emu_queue *q;
+	struct qdma_emu_ring *ring, *cmpt;
+	struct qdma_ul_st_c2h_desc *desc;
+	uint32_t reg, pidx, cidx, nb_desc, off, chunk, word0;
+	uint8_t *entry, *buf;
+
+	if (!qdma_emu_qid_valid(emu, qid))
+		return -EINVAL;
+
+	q = &emu->q[qid];
+	ring = &q->c2h;
+	cmpt = &q->cmpt;
+	if (!ring->en || ring->is_mm || !cmpt->en || q->c2h_buf_sz == 0)
+		return -EAGAIN;
+
+	nb_desc = (len + q->c2h_buf_sz - 1) / q->c2h_buf_sz;
+	reg = qdma_emu_rd(emu, QDMA_EMU_CONFIG_BAR,
+			qdma_emu_db_offst(emu,
+			QDMA_OFFSET_DMAP_SEL_C2H_DSC_PIDX, qid));
+	pidx = FIELD_GET(QDMA_DMA_SEL_DESC_PIDX_MASK, reg);
+	if (qdma_emu_ring_avail(ring, pidx) < nb_desc)
+		return -EAGAIN;
+
+	/* one CMPT entry stays free to tell a full ring from an empty one */
+	reg = qdma_emu_rd(emu, QDMA_EMU_CONFIG_BAR,
+			qdma_emu_db_offst(emu,
+			QDMA_OFFSET_DMAP_SEL_CMPT_CIDX, qid));
+	cidx = FIELD_GET(QDMA_DMAP_SEL_CMPT_WRB_CIDX_MASK, reg);
+	if (cidx >= cmpt->size ||
+			(qdma_emu_ring_avail(cmpt, cidx) + cmpt->size - 1) %
+			cmpt->size == 0)
+		return -EAGAIN;
+
+	/* descriptors are read only after the PIDX that published them */
+	rte_rmb();
+	for (off = 0; off < len; off += chunk) {
+		desc = (struct qdma_ul_st_c2h_desc *)qdma_emu_ring_entry(ring);
+		chunk = RTE_MIN(len - off, q->c2h_buf_sz);
+		buf = qdma_emu_iova2virt(desc->dst_addr);
+		if (buf == NULL) {
+			qdma_emu_ring_error(ring, qid,
+					"C2H buffer is not mapped");
+			return -EFAULT;
+		}
+		if (data)
+			rte_memcpy(buf, data + off, chunk);
+		else
+			qdma_emu_fill_pattern(buf, off, chunk);
+		qdma_emu_ring_next(ring);
+	}
+
+	entry = qdma_emu_ring_entry(cmpt);
+	memset(entry + sizeof(word0), 0, cmpt->entry_sz - sizeof(word0));
+	word0 = (len << QDMA_UL_ST_CMPT_LEN_SHIFT) |
+		(nb_desc ? QDMA_UL_ST_CMPT_DESC_USED_F : 0) |
+		(cmpt->color ? QDMA_UL_ST_CMPT_COLOR_F : 0);
+	*(volatile uint32_t *)entry = rte_cpu_to_le_32(word0);
+	qdma_emu_ring_next(cmpt);
+	q->c2h_done = 1;
+
+	return 0;
+}
+
+static void qdma_emu_c2h_st_wb(struct qdma_emu *emu, uint16_t qid)
+{
+	struct qdma_emu_queue *q = &emu->q[qid];
+
+	if (!q->c2h_done)
+		return;
+
+	qdma_emu_ring_wb(&q->c2h, 0);
+	qdma_emu_ring_wb(&q->cmpt, 1);
+	q->c2h_done = 0;
+}
+
+static void qdma_emu_h2c_st_run(struct qdma_emu *emu, uint16_t qid)
+{
+	struct qdma_emu_ring *ring = &emu->q[qid].h2c;
+	struct qdma_ul_st_h2c_desc *desc;
+	uint32_t reg, pidx, n, loopback;
+	uint8_t *src;
+
+	reg = qdma_emu_rd(emu, QDMA_EMU_CONFIG_BAR,
+			qdma_emu_db_offst(emu,
+			QDMA_OFFSET_DMAP_SEL_H2C_DSC_PIDX, qid));
+	pidx = FIELD_GET(QDMA_DMA_SEL_DESC_PIDX_MASK, reg);
+	n = RTE_MIN(qdma_emu_ring_avail(ring, pidx), QDMA_EMU_BUDGET);
+	if (n == 0)
+		return;
+	rte_rmb();
+
+	loopback = qdma_emu_rd(emu, QDMA_EMU_USER_BAR,
+			QDMA_EMU_UL_C2H_CONTROL) & QDMA_EMU_UL_LOOPBACK_EN;
+	for (; n; n--) {
+		desc = (struct qdma_ul_st_h2c_desc *)qdma_emu_ring_entry(ring);
+		src = qdma_emu_iova2virt(desc->src_addr);
+		if (src == NULL && desc->len) {
+			qdma_emu_ring_error(ring, qid,
+					"H2C buffer is not mapped");
+			break;
+		}
+		/* a full C2H queue back-pressures the H2C queue */
+		if (loopback) {
+			if (qdma_emu_c2h_st_pkt(emu, qid, src, desc->len))
+				break;
+		} else {
+			qdma_emu_wr(emu, QDMA_EMU_USER_BAR,
+					QDMA_EMU_UL_H2C_STATUS, 1);
+		}
+		qdma_emu_ring_next(ring);
+	}
+
+	qdma_emu_ring_wb(ring, 0);
+	if (loopback)
+		qdma_emu_c2h_st_wb(emu, qid);
+}
+
+static void qdma_emu_mm_run(struct qdma_emu *emu, uint16_t qid,
+		struct qdma_emu_ring *ring, int is_c2h)
+{
+	struct qdma_ul_mm_desc *desc;
+	uint32_t reg, pidx, n, len;
+	uint64_t card, host;
+	uint8_t *buf;
+
+	reg = qdma_emu_rd(emu, QDMA_EMU_CONFIG_BAR,
+			qdma_emu_db_offst(emu, is_c2h ?
+			QDMA_OFFSET_DMAP_SEL_C2H_DSC_PIDX :
+			QDMA_OFFSET_DMAP_SEL_H2C_DSC_PIDX, qid));
+	pidx = FIELD_GET(QDMA_DMA_SEL_DESC_PIDX_MASK, reg);
+	n = RTE_MIN(qdma_emu_ring_avail(ring, pidx), QDMA_EMU_BUDGET);
+	if (n == 0)
+		return;
+	rte_rmb();
+
+	for (; n; n--) {
+		desc = (struct qdma_ul_mm_desc *)qdma_emu_ring_entry(ring);
+		len = desc->len;
+		card = is_c2h ? desc->src_addr : desc->dst_addr;
+		host = is_c2h ? desc->dst_addr : desc->src_addr;
+		if (card > DMA_BRAM_SIZE || len > DMA_BRAM_SIZE - card) {
+			qdma_emu_ring_error(ring, qid,
+					"card address is outside of the BRAM");
+			break;
+		}
+		buf = qdma_emu_iova2virt(host);
+		if (buf == NULL && len) {
+			qdma_emu_ring_error(ring, qid,
+					"host buffer is not mapped");
+			break;
+		}
+		if (is_c2h)
+			rte_memcpy(buf, emu->bram + card, len);
+		else
+			rte_memcpy(emu->bram + card, buf, len);
+		qdma_emu_ring_next(ring);
+	}
+
+	qdma_emu_ring_wb(ring, 0);
+}
+
+/* ST C2H packet generator and H2C checker of the example design */
+static void qdma_emu_user_logic(struct qdma_emu *emu)
+{
+	uint32_t ctrl, count, qid, len, n;
+
+	if (qdma_emu_rd(emu, QDMA_EMU_USER_BAR, QDMA_EMU_UL_H2C_CONTROL) &
+			QDMA_EMU_UL_H2C_CLEAR) {
+		qdma_emu_wr(emu, QDMA_EMU_USER_BAR, QDMA_EMU_UL_H2C_STATUS, 0);
+		qdma_emu_wr(emu, QDMA_EMU_USER_BAR, QDMA_EMU_UL_H2C_CONTROL, 0);
+	}
+
+	ctrl = qdma_emu_rd(emu, QDMA_EMU_USER_BAR, QDMA_EMU_UL_C2H_CONTROL);
+	if (!(ctrl & QDMA_EMU_UL_C2H_START))
+		return;
+
+	count = qdma_emu_rd(emu, QDMA_EMU_USER_BAR, QDMA_EMU_UL_C2H_PKT_COUNT);
+	if (count == 0)
+		return;
+
+	qid = qdma_emu_rd(emu, QDMA_EMU_USER_BAR, QDMA_EMU_UL_C2H_ST_QID);
+	len = qdma_emu_rd(emu, QDMA_EMU_USER_BAR, QDMA_EMU_UL_C2H_ST_LEN) &
+		QDMA_EMU_MAX_PKT_LEN;
+	for (n = 0; count && n < QDMA_EMU_BUDGET; n++, count--)
+		if (qdma_emu_c2h_st_pkt(emu, qid, NULL, len))
+			break;
+
+	qdma_emu_wr(emu, QDMA_EMU_USER_BAR, QDMA_EMU_UL_C2H_PKT_COUNT, count);
+	if (n && qdma_emu_qid_valid(emu, qid))
+		qdma_emu_c2h_st_wb(emu, qid);
+}
+
+/* Service callback, the data path of the device */
+static int32_t qdma_emu_service(void *args)
+{
+	struct qdma_emu *emu = args;
+	struct qdma_emu_queue *q;
+	uint16_t i, qid;
+
+	rte_spinlock_lock(&emu->lock);
+	qdma_emu_user_logic(emu);
+	for (i = 0; i < emu->nb_active; i++) {
+		qid = emu->active[i];
+		q = &emu->q[qid];
+		if (q->h2c.en) {
+			if (q->h2c.is_mm)
+				qdma_emu_mm_run(emu, qid, &q->h2c, 0);
+			else
+				qdma_emu_h2c_st_run(emu, qid);
+		}
+		if (q->c2h.en && q->c2h.is_mm)
+			qdma_emu_mm_run(emu, qid, &q->c2h, 1);
+	}
+	rte_spinlock_unlock(&emu->lock);
+
+	return 0;
+}
+
+/*
+ * Called after every config BAR write of the driver. Only the indirect
+ * context command has an immediate effect, doorbells and the user logic
+ * registers are polled by the service.
+ */
+void qdma_emu_reg_write(struct qdma_emu *emu, uint32_t reg_offst,
+			uint32_t val)
+{
+	if (reg_offst != QDMA_OFFSET_IND_CTXT_CMD)
+		return;
+
+	rte_spinlock_lock(&emu->lock);
+	qdma_emu_ctxt_cmd(emu, val);
+	rte_spinlock_unlock(&emu->lock);
+}
+
+struct rte_mem_resource *qdma_emu_mem_resource(struct qdma_emu *emu)
+{
+	return emu->mem_resource;
+}
+
+uint32_t qdma_emu_device_index(struct qdma_emu *emu)
+{
+	return emu->device_index;
+}
+
+static int qdma_emu_bar_alloc(struct qdma_emu *emu, int bar, uint64_t len,
+		int socket_id)
+{
+	void *addr;
+
+	addr = rte_zmalloc_socket(NULL, len, QDMA_ALIGN, socket_id);
+	if (addr == NULL)
+		return -ENOMEM;
+
+	emu->mem_resource[bar].addr = addr;
+	emu->mem_resource[bar].len = len;
+	emu->mem_resource[bar].phys_addr = rte_malloc_virt2iova(addr);
+
+	return 0;
+}
+
+/* Identification and capability registers read at device init */
+static void qdma_emu_reg_init(struct qdma_emu *emu)
+{
+	qdma_emu_wr(emu, QDMA_EMU_CONFIG_BAR, QDMA_OFFSET_CONFIG_BLOCK_ID,
+			FIELD_SET(QDMA_CONFIG_BLOCK_ID_MASK,
+			QDMA_MAGIC_NUMBER));
+	qdma_emu_wr(emu, QDMA_EMU_CONFIG_BAR,
+			QDMA_OFFSET_GLBL2_PF_BARLITE_INT,
+			FIELD_SET(QDMA_GLBL2_PF0_BAR_MAP_MASK,
+			BIT(QDMA_EMU_CONFIG_BAR)));
+	qdma_emu_wr(emu, QDMA_EMU_CONFIG_BAR,
+			QDMA_OFFSET_GLBL2_PF_BARLITE_EXT,
+			BIT(QDMA_EMU_USER_BAR));
+	qdma_emu_wr(emu, QDMA_EMU_CONFIG_BAR,
+			QDMA_OFFSET_GLBL2_CHANNEL_MDMA,
+			QDMA_GLBL2_ST_C2H_MASK | QDMA_GLBL2_ST_H2C_MASK |
+			QDMA_GLBL2_MM_C2H_MASK | QDMA_GLBL2_MM_H2C_MASK);
+	qdma_emu_wr(emu, QDMA_EMU_CONFIG_BAR,
+			QDMA_OFFSET_GLBL2_CHANNEL_QDMA_CAP,
+			FIELD_SET(QDMA_GLBL2_MULTQ_MAX_MASK, QDMA_EMU_QUEUES));
+	/* PF_VERSION, FUNC_RET and MISC_CAP read as 0: a soft IP PF0
+	 * without mailbox, FLR or MM completions
+	 */
+}
+
+/**
+ * Create the software model of a QDMA PF.
+ *
+ * The state lives in hugepage memory so secondary processes can map the
+ * BARs, the data path is registered as an EAL service that has to be
+ * mapped to a service core (EAL option -s).
+ *
+ * @param name
+ *   Name of the device, also used as service name.
+ * @param socket_id
+ *   NUMA socket of the device memory.
+ *
+ * @return
+ *   The device on success, NULL on failure.
+ */
+struct qdma_emu *qdma_emu_create(const char *name, int socket_id)
+{
+	struct rte_service_spec spec;
+	struct qdma_emu *emu;
+
+	emu = rte_zmalloc_socket(name, sizeof(struct qdma_emu),
+			RTE_CACHE_LINE_SIZE, socket_id);
+	if (emu == NULL) {
+		PMD_DRV_LOG(ERR, "%s: cannot allocate the device", name);
+		return NULL;
+	}
+
+	emu->bram = rte_zmalloc_socket(NULL, DMA_BRAM_SIZE,
+			RTE_CACHE_LINE_SIZE, socket_id);
+	if (emu->bram == NULL ||
+			qdma_emu_bar_alloc(emu, QDMA_EMU_CONFIG_BAR,
+				QDMA_EMU_CONFIG_BAR_SIZE, socket_id) ||
+			qdma_emu_bar_alloc(emu, QDMA_EMU_USER_BAR,
+				QDMA_EMU_USER_BAR_SIZE, socket_id)) {
+		PMD_DRV_LOG(ERR, "%s: cannot allocate the device memory",
+				name);
+		goto fail;
+	}
+
+	qdma_emu_reg_init(emu);
+	rte_spinlock_init(&emu->lock);
+	emu->device_index = QDMA_EMU_DEVICE_INDEX_BASE + qdma_emu_count++;
+
+	memset(&spec, 0, sizeof(spec));
+	snprintf(spec.name, sizeof(spec.name), "%s", name);
+	spec.callback = qdma_emu_service;
+	spec.callback_userdata = emu;
+	spec.socket_id = socket_id;
+	if (rte_service_component_register(&spec, &emu->service_id)) {
+		PMD_DRV_LOG(ERR, "%s: cannot register the service", name);
+		goto fail;
+	}
+	rte_service_component_runstate_set(emu->service_id, 1);
+	rte_service_runstate_set(emu->service_id, 1);
+
+	if (rte_service_lcore_count() == 0)
+		PMD_DRV_LOG(WARNING, "%s: no service core, the device will "
+				"not process any queue", name);
+
+	return emu;
+
+fail:
+	rte_free(emu->mem_resource[QDMA_EMU_USER_BAR].addr);
+	rte_free(emu->mem_resource[QDMA_EMU_CONFIG_BAR].addr);
+	rte_free(emu->bram);
+	rte_free(emu);
+	return NULL;
+}
+
+void qdma_emu_destroy(struct qdma_emu *emu)
+{
+	if (emu == NULL)
+		return;
+
+	rte_service_runstate_set(emu->service_id, 0);
+	rte_service_component_runstate_set(emu->service_id, 0);
+	/* wait for a service call in flight */
+	rte_spinlock_lock(&emu->lock);
+	rte_spinlock_unlock(&emu->lock);
+	rte_service_component_unregister(emu->service_id);
+
+	rte_free(emu->mem_resource[QDMA_EMU_USER_BAR].addr);
+	rte_free(emu->mem_resource[QDMA_EMU_CONFIG_BAR].addr);
+	rte_free(emu->bram);
+	rte_free(emu);
+}
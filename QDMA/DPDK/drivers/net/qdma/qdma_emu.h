@@ -0,0 +1,57 @@
+/*-
+ * BSD LICENSE
+ *
+ * Copyright(c) 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef QDMA_DPDK_EMU_H_
+#define QDMA_DPDK_EMU_H_
+
+/*
+ * Software model of a QDMA PF with the example design user logic, backing
+ * the net_qdma_emu virtual device. Register writes of the control path are
+ * handled synchronously, the data path of the device runs as a service
+ * on an EAL service core.
+ */
+
+#include <stdint.h>
+#include <rte_pci.h>
+
+/* Queue resource manager keys of emulated devices, above any PCI bus */
+#define QDMA_EMU_DEVICE_INDEX_BASE	(0x100)
+
+struct qdma_emu;
+
+struct qdma_emu *qdma_emu_create(const char *name, int socket_id);
+void qdma_emu_destroy(struct qdma_emu *emu);
+struct rte_mem_resource *qdma_emu_mem_resource(struct qdma_emu *emu);
+uint32_t qdma_emu_device_index(struct qdma_emu *emu);
+void qdma_emu_reg_write(struct qdma_emu *emu, uint32_t reg_offst,
+			uint32_t val);
+
+#endif /* QDMA_DPDK_EMU_H_ */
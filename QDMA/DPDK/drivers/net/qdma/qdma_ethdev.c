@@ -37,6 +37,7 @@
 #include <rte_memzone.h>
 #include <rte_string_fns.h>
 #include <rte_ethdev_pci.h>
+#include <rte_bus_vdev.h>
 #include <rte_malloc.h>
 #include <rte_dev.h>
 #include <rte_pci.h>
@@ -52,9 +53,12 @@
 #include "qdma_access.h"
 #include "qdma_access_export.h"
 #include "qdma_mbox.h"
+#include "qdma_emu.h"
 
 /* Poll for QDMA errors every 1 second */
 #define QDMA_ERROR_POLL_FRQ (1000000)
+/* MSI-X vector of the error interrupt, shared with the mailbox */
+#define QDMA_ERROR_INTR_VEC (0)
 
 static void qdma_device_attributes_get(struct rte_eth_dev *dev);
 
@@ -67,6 +71,93 @@ static void qdma_check_errors(void *arg)
 	rte_eal_alarm_set(QDMA_ERROR_POLL_FRQ, qdma_check_errors, arg);
 }
 
+/* Error interrupt handler, also called on every mailbox interrupt */
+static void qdma_error_intr_handler(void *arg)
+{
+	struct qdma_pci_dev *qdma_dev;
+	qdma_dev = ((struct rte_eth_dev *)arg)->data->dev_private;
+
+	/* The hardware disarms the interrupt once it has fired */
+	if (qdma_dev->hw_access->qdma_hw_error_process(arg) ==
+			QDMA_SUCCESS)
+		qdma_dev->hw_access->qdma_hw_error_intr_rearm(arg);
+}
+
+/*
+ * Route the global error interrupt of the master PF to MSI-X vector 0.
+ * Only vfio-pci in MSI-X mode is known to deliver that vector, MSI and
+ * UIO may run on a single vector or INTx; the caller then keeps
+ * polling with qdma_check_errors().
+ */
+static int qdma_error_intr_setup(struct rte_eth_dev *dev)
+{
+	struct qdma_pci_dev *qdma_dev = dev->data->dev_private;
+	struct rte_intr_handle *intr_handle;
+	int ret;
+
+	/* the emulated device has no interrupts */
+	if (qdma_dev->emu)
+		return -ENOTSUP;
+
+	intr_handle = &RTE_ETH_DEV_TO_PCI(dev)->intr_handle;
+	if (intr_handle->type != RTE_INTR_HANDLE_VFIO_MSIX)
+		return -ENOTSUP;
+
+	ret = rte_intr_callback_register(intr_handle,
+			qdma_error_intr_handler, dev);
+	if (ret < 0)
+		return ret;
+
+	ret = rte_intr_enable(intr_handle);
+	if (ret < 0) {
+		rte_intr_callback_unregister(intr_handle,
+				qdma_error_intr_handler, dev);
+		return ret;
+	}
+
+	qdma_dev->hw_access->qdma_hw_error_intr_setup(dev,
+			qdma_dev->func_id, QDMA_ERROR_INTR_VEC);
+	qdma_dev->hw_access->qdma_hw_error_intr_rearm(dev);
+	qdma_dev->err_intr_en = 1;
+
+	/* pick up errors latched before the interrupt was armed */
+	qdma_error_intr_handler(dev);
+
+	return 0;
+}
+
+/*
+ * MSI-X vector 0 was masked while the Rx queue vectors were set up or
+ * released. The callback stays registered on the handle, but an error
+ * raised meanwhile left the hardware interrupt disarmed.
+ */
+void qdma_error_intr_resume(struct rte_eth_dev *dev)
+{
+	struct qdma_pci_dev *qdma_dev = dev->data->dev_private;
+
+	if (qdma_dev->err_intr_en)
+		qdma_error_intr_handler(dev);
+}
+
+static void qdma_error_intr_teardown(struct rte_eth_dev *dev)
+{
+	struct qdma_pci_dev *qdma_dev = dev->data->dev_private;
+	struct rte_pci_device *pci_dev = RTE_ETH_DEV_TO_PCI(dev);
+
+	if (!qdma_dev->err_intr_en) {
+		rte_eal_alarm_cancel(qdma_check_errors, (void *)dev);
+		return;
+	}
+
+	/* leave the interrupt disarmed */
+	qdma_dev->hw_access->qdma_hw_error_intr_setup(dev,
+			qdma_dev->func_id, QDMA_ERROR_INTR_VEC);
+	rte_intr_disable(&pci_dev->intr_handle);
+	rte_intr_callback_unregister(&pci_dev->intr_handle,
+			qdma_error_intr_handler, dev);
+	qdma_dev->err_intr_en = 0;
+}
+
 /*
  * The set of PCI devices this driver supports
  */
@@ -347,9 +438,9 @@ static int eth_qdma_dev_init(struct rte_eth_dev *dev)
 	struct qdma_pci_dev *dma_priv;
 	uint8_t *baseaddr;
 	int i, idx, ret, qbase;
-	struct rte_pci_device *pci_dev;
+	struct rte_pci_device *pci_dev = NULL;
 	uint32_t total_q;
-	uint16_t num_vfs;
+	uint16_t num_vfs = 0;
 
 	/* sanity checks */
 	if (dev == NULL)
@@ -359,14 +450,22 @@ static int eth_qdma_dev_init(struct rte_eth_dev *dev)
 	if (dev->data->dev_private == NULL)
 		return -EINVAL;
 
-	pci_dev = RTE_ETH_DEV_TO_PCI(dev);
-	if (pci_dev == NULL)
-		return -EINVAL;
+	/* an emulated device is set up by eth_qdma_emu_probe() */
+	dma_priv = (struct qdma_pci_dev *)dev->data->dev_private;
+	if (dma_priv->emu == NULL) {
+		pci_dev = RTE_ETH_DEV_TO_PCI(dev);
+		if (pci_dev == NULL)
+			return -EINVAL;
+	}
 
 	/* for secondary processes, we don't initialise any further as primary
 	 * has already done this work.
 	 */
 	if (rte_eal_process_type() != RTE_PROC_PRIMARY) {
+		/* BARs and access layer function pointers are process local */
+		ret = qdma_proc_priv_init(dev);
+		if (ret < 0)
+			return ret;
 		qdma_dev_ops_init(dev);
 		return 0;
 	}
@@ -383,7 +482,6 @@ static int eth_qdma_dev_init(struct rte_eth_dev *dev)
 		dev->data->mac_addrs[0].addr_bytes[i] = 0x15 + i;
 
 	/* Init system & device */
-	dma_priv = (struct qdma_pci_dev *)dev->data->dev_private;
 	dma_priv->is_vf = 0;
 	dma_priv->is_master = 0;
 	dma_priv->vf_online_count = 0;
@@ -406,6 +504,8 @@ static int eth_qdma_dev_init(struct rte_eth_dev *dev)
 	dma_priv->cmpt_desc_len = DEFAULT_QDMA_CMPT_DESC_LEN;
 	dma_priv->c2h_bypass_mode = RTE_PMD_QDMA_RX_BYPASS_NONE;
 	dma_priv->h2c_bypass_mode = 0;
+	dma_priv->tx_pidx_batch = MIN_TX_PIDX_UPDATE_THRESHOLD;
+	dma_priv->tx_pidx_timeout = QDMA_TXQ_PIDX_UPDATE_INTERVAL;
 
 	dma_priv->config_bar_idx = DEFAULT_PF_CONFIG_BAR;
 	dma_priv->bypass_bar_idx = BAR_ID_INVALID;
@@ -418,10 +518,17 @@ static int eth_qdma_dev_init(struct rte_eth_dev *dev)
 		return -EINVAL;
 	}
 
+	if (pci_dev != NULL)
+		dma_priv->dma_device_index = pci_dev->addr.bus;
+	else
+		dma_priv->dma_device_index =
+				qdma_emu_device_index(dma_priv->emu);
+
 	/* Store BAR address and length of Config BAR */
 	baseaddr = (uint8_t *)
-			pci_dev->mem_resource[dma_priv->config_bar_idx].addr;
-	dma_priv->bar_addr[dma_priv->config_bar_idx] = baseaddr;
+			qdma_mem_resource(dev)[dma_priv->config_bar_idx].addr;
+	QDMA_PROC_PRIV(dev->data->port_id)->bar_addr[dma_priv->config_bar_idx] =
+								baseaddr;
 
 	/*Assigning QDMA access layer function pointers based on the HW design*/
 	dma_priv->hw_access = rte_zmalloc("hwaccess",
@@ -451,11 +558,12 @@ static int eth_qdma_dev_init(struct rte_eth_dev *dev)
 		return -EINVAL;
 	}
 
-	/* Store BAR address and length of User BAR */
-	if (dma_priv->user_bar_idx >= 0) {
-		baseaddr = (uint8_t *)
-			    pci_dev->mem_resource[dma_priv->user_bar_idx].addr;
-		dma_priv->bar_addr[dma_priv->user_bar_idx] = baseaddr;
+	/* Store BAR addresses and the data path access layer of this process */
+	idx = qdma_proc_priv_init(dev);
+	if (idx < 0) {
+		rte_free(dma_priv->hw_access);
+		rte_free(dev->data->mac_addrs);
+		return idx;
 	}
 
 	PMD_DRV_LOG(INFO, "QDMA device driver probe:");
@@ -471,7 +579,7 @@ static int eth_qdma_dev_init(struct rte_eth_dev *dev)
 	qbase = DEFAULT_QUEUE_BASE;
 	total_q = QDMA_QUEUES_NUM_MAX;
 
-	ret = qdma_master_resource_create(pci_dev->addr.bus, qbase,
+	ret = qdma_master_resource_create(dma_priv->dma_device_index, qbase,
 				    total_q);
 	if (ret == -QDMA_ERR_NO_MEM) {
 		rte_free(dma_priv->hw_access);
@@ -509,8 +617,12 @@ static int eth_qdma_dev_init(struct rte_eth_dev *dev)
 
 		dma_priv->hw_access->qdma_init_ctxt_memory(dev);
 		dma_priv->hw_access->qdma_hw_error_enable(dev, QDMA_ERRS_ALL);
-		rte_eal_alarm_set(QDMA_ERROR_POLL_FRQ, qdma_check_errors,
-							(void *)dev);
+		if (qdma_error_intr_setup(dev) != 0) {
+			PMD_DRV_LOG(INFO, "PF-%d(DEVFN) polling for errors\n",
+					dma_priv->func_id);
+			rte_eal_alarm_set(QDMA_ERROR_POLL_FRQ,
+					qdma_check_errors, (void *)dev);
+		}
 		dma_priv->is_master = 1;
 	}
 
@@ -518,7 +630,8 @@ static int eth_qdma_dev_init(struct rte_eth_dev *dev)
 	 * Create an entry for the device in board list if not already
 	 * created
 	 */
-	ret = qdma_dev_entry_create(pci_dev->addr.bus, dma_priv->func_id);
+	ret = qdma_dev_entry_create(dma_priv->dma_device_index,
+			dma_priv->func_id);
 	if ((ret != QDMA_SUCCESS) &&
 		(ret != -QDMA_ERR_RM_DEV_EXISTS)) {
 		PMD_DRV_LOG(ERR, "PF-%d(DEVFN) qdma_dev_entry_create failed: %d\n",
@@ -528,11 +641,13 @@ static int eth_qdma_dev_init(struct rte_eth_dev *dev)
 		return -ENOMEM;
 	}
 
-	pcie_perf_enable(pci_dev);
-	if (dma_priv->dev_cap.mailbox_en && pci_dev->max_vfs)
+	if (pci_dev != NULL) {
+		pcie_perf_enable(pci_dev);
+		num_vfs = pci_dev->max_vfs;
+	}
+	if (dma_priv->dev_cap.mailbox_en && num_vfs)
 		qdma_mbox_init(dev);
 
-	num_vfs = pci_dev->max_vfs;
 	if (num_vfs) {
 		dma_priv->vfinfo = rte_zmalloc("vfinfo",
 				sizeof(struct qdma_vf_info) * num_vfs, 0);
@@ -559,16 +674,19 @@ static int eth_qdma_dev_init(struct rte_eth_dev *dev)
 static int eth_qdma_dev_uninit(struct rte_eth_dev *dev)
 {
 	struct qdma_pci_dev *qdma_dev = dev->data->dev_private;
-	struct rte_pci_device *pci_dev = RTE_ETH_DEV_TO_PCI(dev);
 	struct qdma_mbox_msg *m = NULL;
+	uint16_t num_vfs = 0;
 	int i, rv;
 
 	/* only uninitialize in the primary process */
 	if (rte_eal_process_type() != RTE_PROC_PRIMARY)
 		return -EPERM;
 
+	if (qdma_dev->emu == NULL)
+		num_vfs = RTE_ETH_DEV_TO_PCI(dev)->max_vfs;
+
 	if (qdma_dev->vf_online_count) {
-		for (i = 0; i < pci_dev->max_vfs; i++) {
+		for (i = 0; i < num_vfs; i++) {
 			if (qdma_dev->vfinfo[i].func_id == QDMA_FUNC_ID_INVALID)
 				continue;
 
@@ -611,16 +729,16 @@ static int eth_qdma_dev_uninit(struct rte_eth_dev *dev)
 	if (qdma_dev->dev_configured)
 		qdma_dev_close(dev);
 
-	if (qdma_dev->dev_cap.mailbox_en && pci_dev->max_vfs)
+	if (qdma_dev->dev_cap.mailbox_en && num_vfs)
 		qdma_mbox_uninit(dev);
 
-	/* cancel pending polls*/
+	/* cancel pending polls or the error interrupt */
 	if (qdma_dev->is_master)
-		rte_eal_alarm_cancel(qdma_check_errors, (void *)dev);
+		qdma_error_intr_teardown(dev);
 
 	/* Remove the device node from the board list */
-	qdma_dev_entry_destroy(pci_dev->addr.bus, qdma_dev->func_id);
-	qdma_master_resource_destroy(pci_dev->addr.bus);
+	qdma_dev_entry_destroy(qdma_dev->dma_device_index, qdma_dev->func_id);
+	qdma_master_resource_destroy(qdma_dev->dma_device_index);
 
 	dev->dev_ops = NULL;
 	dev->rx_pkt_burst = NULL;
@@ -671,10 +789,96 @@ static struct rte_pci_driver rte_qdma_pmd = {
 	.remove = eth_qdma_pci_remove,
 };
 
+/**
+ * DPDK callback to register an emulated QDMA device.
+ *
+ * The primary process creates the software model of the device, which
+ * then goes through the same initialization as a PCI function.
+ *
+ * @param[in] vdev
+ *   Pointer to the virtual device.
+ *
+ * @return
+ *   0 on success, negative errno value on failure.
+ */
+static int eth_qdma_emu_probe(struct rte_vdev_device *vdev)
+{
+	const char *name = rte_vdev_device_name(vdev);
+	struct qdma_pci_dev *dma_priv;
+	struct rte_eth_dev *dev;
+	int ret;
+
+	PMD_DRV_LOG(INFO, "Probing emulated QDMA device %s\n", name);
+
+	if (rte_eal_process_type() != RTE_PROC_PRIMARY) {
+		dev = rte_eth_dev_attach_secondary(name);
+		if (dev == NULL)
+			return -ENODEV;
+		dev->device = &vdev->device;
+		ret = eth_qdma_dev_init(dev);
+		if (ret < 0) {
+			rte_eth_dev_release_port(dev);
+			return ret;
+		}
+		rte_eth_dev_probing_finish(dev);
+		return 0;
+	}
+
+	dev = rte_eth_vdev_allocate(vdev, sizeof(struct qdma_pci_dev));
+	if (dev == NULL)
+		return -ENOMEM;
+
+	dma_priv = dev->data->dev_private;
+	dma_priv->emu = qdma_emu_create(name, vdev->device.numa_node);
+	if (dma_priv->emu == NULL) {
+		rte_eth_dev_release_port(dev);
+		return -ENOMEM;
+	}
+
+	ret = eth_qdma_dev_init(dev);
+	if (ret < 0) {
+		qdma_emu_destroy(dma_priv->emu);
+		rte_eth_dev_release_port(dev);
+		return ret;
+	}
+
+	rte_eth_dev_probing_finish(dev);
+	return 0;
+}
+
+/* Detach an emulated device */
+static int eth_qdma_emu_remove(struct rte_vdev_device *vdev)
+{
+	struct qdma_pci_dev *dma_priv;
+	struct rte_eth_dev *dev;
+	struct qdma_emu *emu;
+
+	dev = rte_eth_dev_allocated(rte_vdev_device_name(vdev));
+	if (dev == NULL)
+		return 0;
+
+	if (rte_eal_process_type() == RTE_PROC_PRIMARY) {
+		dma_priv = dev->data->dev_private;
+		emu = dma_priv->emu;
+		eth_qdma_dev_uninit(dev);
+		qdma_emu_destroy(emu);
+	}
+
+	rte_eth_dev_release_port(dev);
+	return 0;
+}
+
+static struct rte_vdev_driver rte_qdma_emu_pmd = {
+	.probe = eth_qdma_emu_probe,
+	.remove = eth_qdma_emu_remove,
+};
+
 bool
 is_pf_device_supported(struct rte_eth_dev *dev)
 {
-	if (strcmp(dev->device->driver->name, rte_qdma_pmd.driver.name))
+	if (strcmp(dev->device->driver->name, rte_qdma_pmd.driver.name) &&
+		strcmp(dev->device->driver->name,
+				rte_qdma_emu_pmd.driver.name))
 		return false;
 
 	return true;
@@ -695,3 +899,15 @@ bool is_qdma_supported(struct rte_eth_dev *dev)
 
 RTE_PMD_REGISTER_PCI(net_qdma, rte_qdma_pmd);
 RTE_PMD_REGISTER_PCI_TABLE(net_qdma, qdma_pci_id_tbl);
+RTE_PMD_REGISTER_VDEV(net_qdma_emu, rte_qdma_emu_pmd);
+
+#ifdef QDMA_TRACE
+int qdma_trace_logtype;
+
+RTE_INIT(qdma_trace_init_log)
+{
+	qdma_trace_logtype = rte_log_register("pmd.net.qdma.trace");
+	if (qdma_trace_logtype >= 0)
+		rte_log_set_level(qdma_trace_logtype, RTE_LOG_NOTICE);
+}
+#endif
@@ -36,6 +36,7 @@
 #include <rte_malloc.h>
 #include <rte_spinlock.h>
 #include <rte_alarm.h>
+#include <rte_cycles.h>
 
 /*
  * Get index from VF info array of PF device for a given VF funcion id.
@@ -266,19 +267,32 @@ static void qdma_mbox_rcv_task(void *arg)
 		rte_eal_alarm_set(MBOX_POLL_FRQ, qdma_mbox_rcv_task, arg);
 }
 
+/*
+ * Send the queued messages. The todo list is a FIFO per destination
+ * function: once the mailbox of a function is busy its later messages
+ * wait for the next pass, while messages to other functions still go out.
+ */
 static void qdma_mbox_send_task(void *arg)
 {
 	struct rte_eth_dev *dev = (struct rte_eth_dev *)arg;
 	struct qdma_pci_dev *qdma_dev = dev->data->dev_private;
 	struct qdma_list_head *entry, *tmp;
+	uint8_t busy[(QDMA_FUNC_ID_INVALID + 7) / 8] = {0};
+	uint8_t dst;
 	int rv;
 
 	rte_spinlock_lock(&qdma_dev->mbox.list_lock);
 	qdma_list_for_each_safe(entry, tmp, &qdma_dev->mbox.tx_todo_list) {
 		struct qdma_mbox_msg *msg = QDMA_LIST_GET_DATA(entry);
 
+		/* destination function of an outgoing message */
+		dst = qdma_mbox_vf_func_id_get(msg->raw_data, 1);
+		if (busy[dst / 8] & (1 << (dst % 8)))
+			continue;
+
 		rv = qdma_mbox_send(dev, qdma_dev->is_vf, msg->raw_data);
 		if (rv < 0) {
+			busy[dst / 8] |= 1 << (dst % 8);
 			msg->retry_cnt--;
 			if (!msg->retry_cnt) {
 				qdma_list_del(entry);
@@ -299,39 +313,96 @@ static void qdma_mbox_send_task(void *arg)
 	rte_spinlock_unlock(&qdma_dev->mbox.list_lock);
 }
 
-int qdma_mbox_msg_send(struct rte_eth_dev *dev, struct qdma_mbox_msg *msg,
-		       unsigned int timeout_ms)
+/*
+ * Drop a message the caller gives up on from whichever list still holds
+ * it, so that the caller can free it.
+ */
+static void qdma_mbox_msg_cancel(struct qdma_pci_dev *qdma_dev,
+				 struct qdma_mbox_msg *msg)
+{
+	struct qdma_list_head *lists[] = { &qdma_dev->mbox.tx_todo_list,
+					   &qdma_dev->mbox.rx_pend_list };
+	struct qdma_list_head *entry, *tmp;
+	unsigned int i;
+
+	rte_spinlock_lock(&qdma_dev->mbox.list_lock);
+	for (i = 0; i < RTE_DIM(lists); i++) {
+		qdma_list_for_each_safe(entry, tmp, lists[i]) {
+			if (QDMA_LIST_GET_DATA(entry) == msg) {
+				qdma_list_del(entry);
+				break;
+			}
+		}
+	}
+	rte_spinlock_unlock(&qdma_dev->mbox.list_lock);
+}
+
+int qdma_mbox_msg_post(struct rte_eth_dev *dev, struct qdma_mbox_msg *msg,
+		       unsigned int timeout_us)
 {
 	struct qdma_pci_dev *qdma_dev = dev->data->dev_private;
 
 	if (!msg)
 		return -EINVAL;
 
-	msg->retry_cnt = timeout_ms ? ((timeout_ms / MBOX_POLL_FRQ) + 1) :
+	msg->retry_cnt = timeout_us ? ((timeout_us / MBOX_POLL_FRQ) + 1) :
 			MBOX_SEND_RETRY_COUNT;
+	msg->rsp_rcvd = 0;
+	msg->rsp_wait = (!timeout_us) ? QDMA_MBOX_RSP_NO_WAIT :
+			QDMA_MBOX_RSP_WAIT;
 	QDMA_LIST_SET_DATA(&msg->node, msg);
 
 	rte_spinlock_lock(&qdma_dev->mbox.list_lock);
 	qdma_list_add_tail(&msg->node, &qdma_dev->mbox.tx_todo_list);
 	rte_spinlock_unlock(&qdma_dev->mbox.list_lock);
 
-	msg->rsp_wait = (!timeout_ms) ? QDMA_MBOX_RSP_NO_WAIT :
-			QDMA_MBOX_RSP_WAIT;
-	rte_eal_alarm_set(MBOX_POLL_FRQ, qdma_mbox_send_task, dev);
+	/* Send right away, the alarm only retries a busy mailbox. A no wait
+	 * message may already be freed when this returns.
+	 */
+	qdma_mbox_send_task(dev);
 
-	if (!timeout_ms)
-		return 0;
+	return 0;
+}
 
-	/* if code reached here, caller should free the buffer */
-	while (msg->retry_cnt && !msg->rsp_rcvd)
-		rte_delay_ms(1);
+int qdma_mbox_msg_wait(struct rte_eth_dev *dev, struct qdma_mbox_msg *msg,
+		       unsigned int timeout_us)
+{
+	struct qdma_pci_dev *qdma_dev = dev->data->dev_private;
+	uint64_t deadline;
+
+	/* The response is picked up by the mailbox interrupt, or by the
+	 * receive poll alarm without one. Check for it in short steps
+	 * rather than whole poll periods.
+	 */
+	deadline = rte_get_timer_cycles() +
+			(rte_get_timer_hz() * timeout_us) / US_PER_S;
+	while (msg->retry_cnt && !msg->rsp_rcvd &&
+			rte_get_timer_cycles() < deadline)
+		rte_delay_us(MBOX_RSP_POLL_US);
 
-	if (!msg->rsp_rcvd)
-		return  -EPIPE;
+	/* if code reached here, caller should free the buffer */
+	if (!msg->rsp_rcvd) {
+		qdma_mbox_msg_cancel(qdma_dev, msg);
+		/* the response may have raced with the cancel */
+		if (!msg->rsp_rcvd)
+			return  -EPIPE;
+	}
 
 	return 0;
 }
 
+int qdma_mbox_msg_send(struct rte_eth_dev *dev, struct qdma_mbox_msg *msg,
+		       unsigned int timeout_us)
+{
+	int rv;
+
+	rv = qdma_mbox_msg_post(dev, msg, timeout_us);
+	if (rv < 0 || !timeout_us)
+		return rv;
+
+	return qdma_mbox_msg_wait(dev, msg, timeout_us);
+}
+
 void *qdma_mbox_msg_alloc(void)
 {
 	return rte_zmalloc(NULL, sizeof(struct qdma_mbox_msg), 0);
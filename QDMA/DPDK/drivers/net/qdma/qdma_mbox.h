@@ -39,6 +39,7 @@
 #define MBOX_POLL_FRQ 1000
 #define MBOX_OP_RSP_TIMEOUT (10000 * MBOX_POLL_FRQ) /* 10 sec */
 #define MBOX_SEND_RETRY_COUNT (MBOX_OP_RSP_TIMEOUT/MBOX_POLL_FRQ)
+#define MBOX_RSP_POLL_US 10 /* response check step of a blocking send */
 
 enum qdma_mbox_rsp_state {
 	QDMA_MBOX_RSP_NO_WAIT,
@@ -65,7 +66,15 @@ void qdma_mbox_uninit(struct rte_eth_dev *dev);
 void *qdma_mbox_msg_alloc(void);
 void qdma_mbox_msg_free(void *buffer);
 int qdma_mbox_msg_send(struct rte_eth_dev *dev, struct qdma_mbox_msg *buf,
-		       unsigned int timeout_ms);
+		       unsigned int timeout_us);
+/* Split form of qdma_mbox_msg_send(), lets a caller keep several requests
+ * in flight and collect the responses afterwards. Messages to one function
+ * are sent in posting order.
+ */
+int qdma_mbox_msg_post(struct rte_eth_dev *dev, struct qdma_mbox_msg *buf,
+		       unsigned int timeout_us);
+int qdma_mbox_msg_wait(struct rte_eth_dev *dev, struct qdma_mbox_msg *buf,
+		       unsigned int timeout_us);
 int qdma_dev_notify_qadd(struct rte_eth_dev *dev, uint32_t qidx_hw,
 						enum qdma_dev_q_type q_type);
 int qdma_dev_notify_qdel(struct rte_eth_dev *dev, uint32_t qidx_hw,
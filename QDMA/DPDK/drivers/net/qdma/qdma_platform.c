@@ -129,12 +129,17 @@ void qdma_resource_lock_give(void)
  *****************************************************************************/
 void qdma_reg_write(void *dev_hndl, uint32_t reg_offst, uint32_t val)
 {
-	struct qdma_pci_dev *qdma_dev;
+	struct rte_eth_dev *dev = dev_hndl;
+	struct qdma_pci_dev *qdma_dev = dev->data->dev_private;
 	uint64_t bar_addr;
 
-	qdma_dev = ((struct rte_eth_dev *)dev_hndl)->data->dev_private;
-	bar_addr = (uint64_t)qdma_dev->bar_addr[qdma_dev->config_bar_idx];
+	bar_addr = (uint64_t)QDMA_PROC_PRIV(dev->data->port_id)->
+					bar_addr[qdma_dev->config_bar_idx];
 	*((volatile uint32_t *)(bar_addr + reg_offst)) = val;
+
+	/* let the emulated device act on the write */
+	if (qdma_dev->emu)
+		qdma_emu_reg_write(qdma_dev->emu, reg_offst, val);
 }
 
 /*****************************************************************************/
@@ -148,12 +153,13 @@ void qdma_reg_write(void *dev_hndl, uint32_t reg_offst, uint32_t val)
  *****************************************************************************/
 uint32_t qdma_reg_read(void *dev_hndl, uint32_t reg_offst)
 {
-	struct qdma_pci_dev *qdma_dev;
+	struct rte_eth_dev *dev = dev_hndl;
+	struct qdma_pci_dev *qdma_dev = dev->data->dev_private;
 	uint64_t bar_addr;
 	uint32_t val;
 
-	qdma_dev = ((struct rte_eth_dev *)dev_hndl)->data->dev_private;
-	bar_addr = (uint64_t)qdma_dev->bar_addr[qdma_dev->config_bar_idx];
+	bar_addr = (uint64_t)QDMA_PROC_PRIV(dev->data->port_id)->
+					bar_addr[qdma_dev->config_bar_idx];
 	val = *((volatile uint32_t *)(bar_addr + reg_offst));
 
 	return val;
@@ -213,9 +219,27 @@ void qdma_udelay(uint32_t delay_usec)
  *****************************************************************************/
 void qdma_hw_error_handler(void *dev_hndl, enum qdma_error_idx err_idx)
 {
+	/* last error index of each aggregator, see enum qdma_hw_err_aggr */
+	static const enum qdma_error_idx aggr_last[QDMA_HW_ERR_AGGR_MAX] = {
+		QDMA_DSC_ERR_ALL,
+		QDMA_TRQ_ERR_ALL,
+		QDMA_ST_C2H_ERR_ALL,
+		QDMA_ST_FATAL_ERR_ALL,
+		QDMA_ST_H2C_ERR_ALL,
+		QDMA_SBE_ERR_ALL,
+		QDMA_DBE_ERR_ALL
+	};
 	struct qdma_pci_dev *qdma_dev;
+	unsigned int aggr;
 	qdma_dev = ((struct rte_eth_dev *)dev_hndl)->data->dev_private;
 
+	for (aggr = 0; aggr < QDMA_HW_ERR_AGGR_MAX; aggr++) {
+		if (err_idx <= aggr_last[aggr]) {
+			qdma_dev->hw_err_cnt[aggr]++;
+			break;
+		}
+	}
+
 	rte_log(RTE_LOG_ERR, RTE_LOGTYPE_PMD,
 		"%s(): Detected %s\n", __func__,
 		qdma_dev->hw_access->qdma_hw_get_error_name(err_idx));
@@ -39,87 +39,62 @@
 #include <unistd.h>
 #include "qdma_rxtx.h"
 
-int dma_wb_monitor(void *xq, uint8_t dir, uint16_t expected_count);
+/* Account one burst of nb packets with in_use ring descriptors */
+static inline void qdma_xstats_burst(struct qdma_q_xstats *xstats,
+			uint16_t nb, int in_use)
+{
+	uint32_t bin = 0;
 
-/**
- * Poll the QDMA engine for transfer completion.
- *
- * @param txq
- *   Generic pointer to either Rx/Tx queue structure based on the DMA direction.
- * @param expected_count
- *   expected transfer count.
- *
- * @return
- *   Number of packets transferred successfully by the engine.
- */
-int dma_wb_monitor(void *xq, uint8_t dir, uint16_t expected_count)
+	if (nb)
+		bin = RTE_MIN(32 - __builtin_clz(nb),
+				QDMA_XSTATS_BURST_BINS - 1);
+
+	xstats->bursts++;
+	xstats->ring_occupancy += in_use;
+	xstats->burst_size[bin]++;
+}
+
+/* Account the cycles of one burst of nb packets started at tsc */
+static inline void qdma_cycles_burst(struct rte_pmd_qdma_q_cycles *cycles,
+			uint64_t tsc, uint16_t nb)
 {
-	struct wb_status *wb_status;
-	uint16_t mode, wb_tail;
-	uint32_t i = 0;
-
-	if (dir == DMA_TO_DEVICE) {
-		struct qdma_tx_queue *txq = (struct qdma_tx_queue *)xq;
-		wb_status = txq->wb_status;
-
-		while (i < WB_TIMEOUT) {
-			if (expected_count == wb_status->cidx) {
-				PMD_DRV_LOG(DEBUG, "Poll writeback count "
-					    "matches to the expected count :%d",
-					    expected_count);
-				return 0;
-			}
-			PMD_DRV_LOG(DEBUG, "poll wait on wb-count:%d and "
-					"expected-count:%d\n",
-					wb_status->cidx, expected_count);
-			rte_delay_us(2);
-			i++;
-		}
-		PMD_DRV_LOG(DEBUG, "DMA Engine write-back monitor "
-				"timeout error occurred\n");
-		return -1;
+	tsc = rte_rdtsc() - tsc;
+	if (nb) {
+		cycles->bursts++;
+		cycles->pkts += nb;
+		cycles->cycles += tsc;
+	} else {
+		cycles->idle_bursts++;
+		cycles->idle_cycles += tsc;
 	}
-	/* dir == DMA_FROM_DEVICE */
-	struct qdma_rx_queue *rxq = (struct qdma_rx_queue *)xq;
-	wb_status = rxq->wb_status;
-	mode = rxq->st_mode;
+}
 
-	/* Poll the writeback location until timeout Or, the expected
-	 * count matches to the writeback count
-	 */
-	while (i < WB_TIMEOUT) {
-		if (mode) {
-			wb_tail =
-			(rxq->cmpt_cidx_info.wrb_cidx + expected_count) %
-			(rxq->nb_rx_cmpt_desc - 1);
-			if (wb_tail == wb_status->pidx) {
-				PMD_DRV_LOG(DEBUG, "ST: Poll cmpt count matches"
-						" to the expected count :%d",
-						expected_count);
-				return 0;
-			}
-			PMD_DRV_LOG(DEBUG, "ST: poll wait on wb-count:%d and"
-					" expected-count:%d\n",
-					wb_status->pidx, expected_count);
-		} else {
-			if (expected_count == wb_status->cidx) {
-				PMD_DRV_LOG(DEBUG, "MM: Poll writeback count "
-						"matches to the expected count"
-						" :%d", expected_count);
-				return 0;
-			}
-			PMD_DRV_LOG(DEBUG, "MM: poll wait on wb-count:%d "
-					"and expected-count:%d\n",
-					wb_status->cidx, expected_count);
-		}
-		rte_delay_us(2);
-		i++;
-	}
-	return -1;
+/* Return a chunk of mbufs that all belong to the same mempool */
+static inline void qdma_tx_free_chunk(struct rte_mbuf **free, uint16_t nb_free)
+{
+	if (nb_free)
+		rte_mempool_put_bulk(free[0]->pool, (void **)free, nb_free);
 }
 
-static void reclaim_tx_mbuf(struct qdma_tx_queue *txq, uint16_t cidx)
+/**
+ * Free transmitted mbufs back to their pool, in chunks.
+ *
+ * Nothing is done until at least tx_free_thresh descriptors have been
+ * completed by the hardware. With DEV_TX_OFFLOAD_MBUF_FAST_FREE all
+ * mbufs are known to come from one pool with a reference count of 1 and
+ * are put back directly; otherwise each segment goes through
+ * rte_pktmbuf_prefree_seg() and is batched per mempool.
+ *
+ * @param txq
+ *   Pointer to Tx queue structure.
+ * @param cidx
+ *   Consumer index reported by the hardware.
+ */
+void reclaim_tx_mbuf(struct qdma_tx_queue *txq, uint16_t cidx)
 {
+	struct rte_mbuf *free[QDMA_TX_FREE_BULK_SIZE];
+	struct rte_mbuf *mb, *seg, *next;
+	uint16_t nb_free = 0;
 	int fl_desc = 0;
 	uint16_t count;
 	int id;
@@ -129,15 +104,45 @@ static void reclaim_tx_mbuf(struct qdma_tx_queue *txq, uint16_t cidx)
 	if (fl_desc < 0)
 		fl_desc += (txq->nb_tx_desc - 1);
 
+	if (fl_desc < txq->tx_free_thresh)
+		return;
+
+	qdma_trace_tx_reclaim(txq, fl_desc);
+
 	for (count = 0; count < fl_desc; count++) {
-		if (txq->sw_ring[id]) {
-			rte_pktmbuf_free(txq->sw_ring[id]);
-			txq->sw_ring[id] = NULL;
-		}
+		mb = txq->sw_ring[id];
+		txq->sw_ring[id] = NULL;
 		id++;
 		if (unlikely(id >= (txq->nb_tx_desc - 1)))
 			id -= (txq->nb_tx_desc - 1);
+		if (!mb)
+			continue;
+
+		for (seg = mb; seg; seg = next) {
+			next = seg->next;
+			if (txq->offloads & DEV_TX_OFFLOAD_MBUF_FAST_FREE) {
+				if (unlikely(next)) {
+					seg->next = NULL;
+					seg->nb_segs = 1;
+				}
+			} else {
+				seg = rte_pktmbuf_prefree_seg(seg);
+				if (!seg)
+					continue;
+				if (nb_free && seg->pool != free[0]->pool) {
+					qdma_tx_free_chunk(free, nb_free);
+					nb_free = 0;
+				}
+			}
+
+			free[nb_free++] = seg;
+			if (nb_free == QDMA_TX_FREE_BULK_SIZE) {
+				qdma_tx_free_chunk(free, nb_free);
+				nb_free = 0;
+			}
+		}
 	}
+	qdma_tx_free_chunk(free, nb_free);
 	txq->tx_fl_tail = id;
 }
 
@@ -149,7 +154,6 @@ static uint16_t qdma_xmit_64B_desc_bypass(struct qdma_tx_queue *txq,
 	uint8_t *tx_ring_st_bypass = NULL;
 	int ofd = -1, ret = 0;
 	char fln[50];
-	struct qdma_pci_dev *qdma_dev = txq->dev->data->dev_private;
 
 	id = txq->q_pidx_info.pidx;
 
@@ -191,8 +195,7 @@ static uint16_t qdma_xmit_64B_desc_bypass(struct qdma_tx_queue *txq,
 	rte_wmb();
 
 	txq->q_pidx_info.pidx = id;
-	qdma_dev->hw_access->qdma_queue_pidx_update(txq->dev, qdma_dev->is_vf,
-		txq->queue_id, 0, &txq->q_pidx_info);
+	qdma_txq_pidx_db(txq);
 
 	PMD_DRV_LOG(DEBUG, " xmit completed with count:%d\n", count);
 
@@ -212,7 +215,8 @@ void qdma_get_device_info(void *queue_hndl,
 		enum qdma_versal_ip_type *ip_type)
 {
 	struct qdma_rx_queue *rxq = (struct qdma_rx_queue *)queue_hndl;
-	struct qdma_pci_dev *qdma_dev = rxq->dev->data->dev_private;
+	struct qdma_pci_dev *qdma_dev =
+			rte_eth_devices[rxq->port_id].data->dev_private;
 
 	*device_type = (enum qdma_device_type)qdma_dev->device_type;
 	*ip_type = (enum qdma_versal_ip_type)qdma_dev->versal_ip_type;
@@ -276,51 +280,370 @@ uint32_t get_mm_h2c_ep_addr(void *queue_hndl)
 	return txq->ep_addr;
 }
 
+/* shinfo free callback, the last reference on a large buffer is gone */
+static void qdma_rx_extbuf_free(void *addr __rte_unused, void *opaque)
+{
+	rte_mempool_put(rte_mempool_from_obj(opaque), opaque);
+}
+
+/* Drop the reference held on a large buffer outside of an mbuf */
+static inline void qdma_rx_extbuf_put(struct qdma_rx_queue *rxq, void *buf)
+{
+	struct rte_mbuf_ext_shared_info *shinfo =
+			RTE_PTR_ADD(buf, rxq->ext_shinfo_off);
+
+	if (rte_mbuf_ext_refcnt_update(shinfo, -1) == 0)
+		qdma_rx_extbuf_free(NULL, buf);
+}
+
+/**
+ * Post slices of the external buffers to consecutive ST C2H descriptors.
+ *
+ * A new buffer is taken from the external pool whenever the current one
+ * has been carved completely, its shared info at the buffer tail starts
+ * with the single queue reference.
+ *
+ * @param rxq
+ *   Pointer to Rx queue structure.
+ * @param id
+ *   First descriptor to post, id + nb_desc must not cross the ring end.
+ * @param nb_desc
+ *   Number of descriptors to post.
+ *
+ * @return
+ *   Number of descriptors posted, less than nb_desc if the external pool
+ *   ran out of buffers.
+ */
+uint16_t qdma_rx_extbuf_post(struct qdma_rx_queue *rxq, uint16_t id,
+		uint16_t nb_desc)
+{
+	struct qdma_ul_st_c2h_desc *rx_ring_st =
+			(struct qdma_ul_st_c2h_desc *)rxq->rx_ring;
+	struct rte_mbuf_ext_shared_info *shinfo;
+	struct qdma_rx_ext_slot *slot;
+	uint16_t i;
+
+	for (i = 0; i < nb_desc; i++) {
+		if (rxq->ext_cur == NULL) {
+			if (rte_mempool_get(rxq->ext_pool,
+					&rxq->ext_cur) != 0) {
+				rxq->ext_cur = NULL;
+				rxq->xstats.mbuf_alloc_failed++;
+				break;
+			}
+			shinfo = RTE_PTR_ADD(rxq->ext_cur,
+					rxq->ext_shinfo_off);
+			shinfo->free_cb = qdma_rx_extbuf_free;
+			shinfo->fcb_opaque = rxq->ext_cur;
+			rte_mbuf_ext_refcnt_set(shinfo, 1);
+			rxq->ext_off = 0;
+		}
+
+		slot = &rxq->ext_ring[id + i];
+		slot->buf = rxq->ext_cur;
+		slot->off = rxq->ext_off;
+		rx_ring_st[id + i].dst_addr =
+				rte_mempool_virt2iova(rxq->ext_cur) +
+				rxq->ext_off;
+
+		rxq->ext_off += rxq->rx_buff_size;
+		slot->last = (rxq->ext_off >= rxq->ext_len);
+		if (slot->last)
+			rxq->ext_cur = NULL;
+	}
+
+	return i;
+}
+
+/**
+ * Give back the external buffers still owned by a stopped Rx queue.
+ *
+ * @param rxq
+ *   Pointer to Rx queue structure.
+ */
+void qdma_rx_extbuf_release(struct qdma_rx_queue *rxq)
+{
+	uint16_t i;
+
+	for (i = 0; i < rxq->nb_rx_desc - 1; i++) {
+		if (rxq->ext_ring[i].buf != NULL && rxq->ext_ring[i].last)
+			qdma_rx_extbuf_put(rxq, rxq->ext_ring[i].buf);
+		rxq->ext_ring[i].buf = NULL;
+	}
+	if (rxq->ext_cur != NULL)
+		qdma_rx_extbuf_put(rxq, rxq->ext_cur);
+	rxq->ext_cur = NULL;
+}
+
+/**
+ * Build the mbuf of a packet received in external buffer mode.
+ *
+ * The completion length is 16 bits, so the slices of a packet that lie
+ * in one large buffer always fit a single mbuf attached to them; only a
+ * packet straddling two buffers takes a second segment.
+ *
+ * @param rxq
+ *   Pointer to Rx queue structure.
+ * @param[in,out] tail
+ *   Descriptor the packet starts at, advanced past the packet.
+ * @param pkt_length
+ *   Packet length from the completion entry.
+ *
+ * @return
+ *   First mbuf of the packet, NULL if it was dropped for lack of mbufs.
+ */
+static struct rte_mbuf *qdma_rx_extbuf_pkt(struct qdma_rx_queue *rxq,
+		uint16_t *tail, uint32_t pkt_length)
+{
+	struct rte_mbuf *first_seg = NULL;
+	struct rte_mbuf *last_seg = NULL;
+	struct rte_mbuf *mb;
+	struct rte_mbuf_ext_shared_info *shinfo;
+	struct qdma_rx_ext_slot *slot;
+	uint16_t nb_desc = rxq->nb_rx_desc - 1;
+	uint16_t id = *tail;
+	uint32_t off, seg_len, len;
+	uint32_t last;
+	int drop = 0;
+	void *buf;
+
+	while (pkt_length) {
+		buf = rxq->ext_ring[id].buf;
+		off = rxq->ext_ring[id].off;
+		seg_len = 0;
+		/* slices up to the last one of the buffer are adjacent */
+		do {
+			slot = &rxq->ext_ring[id];
+			len = RTE_MIN(pkt_length, (uint32_t)rxq->rx_buff_size);
+			seg_len += len;
+			pkt_length -= len;
+			last = slot->last;
+			slot->buf = NULL;
+			if (unlikely(++id >= nb_desc))
+				id = 0;
+		} while (pkt_length && !last);
+
+		mb = drop ? NULL : rte_mbuf_raw_alloc(rxq->mb_pool);
+		if (unlikely(mb == NULL)) {
+			drop = 1;
+			if (last)
+				qdma_rx_extbuf_put(rxq, buf);
+			continue;
+		}
+
+		/* the queue reference moves to the mbuf of the last slice */
+		shinfo = RTE_PTR_ADD(buf, rxq->ext_shinfo_off);
+		if (!last)
+			rte_mbuf_ext_refcnt_update(shinfo, 1);
+		mb->ol_flags = 0;
+		rte_pktmbuf_attach_extbuf(mb, RTE_PTR_ADD(buf, off),
+				rte_mempool_virt2iova(buf) + off,
+				(uint16_t)seg_len, shinfo);
+		rte_pktmbuf_data_len(mb) = (uint16_t)seg_len;
+
+		if (first_seg == NULL) {
+			first_seg = mb;
+		} else {
+			first_seg->nb_segs++;
+			last_seg->next = mb;
+		}
+		last_seg = mb;
+	}
+	*tail = id;
+
+	if (unlikely(drop)) {
+		rte_pktmbuf_free(first_seg);
+		rxq->xstats.mbuf_alloc_failed++;
+		return NULL;
+	}
+
+	return first_seg;
+}
+
+/* Receive fields of the first mbuf of a packet */
+static inline void qdma_rx_pkt_init(struct qdma_rx_queue *rxq,
+		struct rte_mbuf *first_seg, uint32_t pkt_len,
+		const uint64_t *ts, const uint32_t *meta)
+{
+	first_seg->pkt_len = pkt_len;
+	first_seg->packet_type = 0;
+	first_seg->port = rxq->port_id;
+	first_seg->vlan_tci = 0;
+	first_seg->hash.rss = 0;
+	if (unlikely(rxq->cmpt_ts_off >= 0)) {
+		first_seg->timestamp = *ts;
+		first_seg->ol_flags |= PKT_RX_TIMESTAMP;
+	}
+	if (unlikely(rxq->cmpt_meta_off >= 0)) {
+		first_seg->hash.fdir.hi = *meta;
+		first_seg->ol_flags |= PKT_RX_FDIR | PKT_RX_FDIR_ID;
+	}
+}
+
+/**
+ * Replenish the ST C2H descriptor ring with fresh mbufs and update the
+ * PIDX.
+ *
+ * Nothing is done until rx_free_thresh descriptors have been consumed,
+ * the ring is then refilled in multiples of rx_free_thresh with mbufs
+ * taken from the pool straight into the software ring and a single
+ * doorbell.
+ *
+ * @param rxq
+ *   Pointer to Rx queue structure.
+ *
+ * @return
+ *   0 on success, negative errno value on mbuf allocation failure.
+ */
+int qdma_rx_refill_st(struct qdma_rx_queue *rxq)
+{
+	struct qdma_ul_st_c2h_desc *rx_ring_st =
+			(struct qdma_ul_st_c2h_desc *)rxq->rx_ring;
+	uint16_t nb_desc = rxq->nb_rx_desc - 1;
+	struct rte_mbuf *mb;
+	uint16_t c2h_pidx, pending_desc, id, n, i;
+	int ret = 0;
+
+	c2h_pidx = rxq->q_pidx_info.pidx;
+
+	pending_desc = rxq->rx_tail - c2h_pidx - 1;
+	if (rxq->rx_tail < (c2h_pidx + 1))
+		pending_desc = rxq->nb_rx_desc - 2 + rxq->rx_tail -
+				c2h_pidx;
+
+	/* Batch the PIDX updates, this minimizes overhead on
+	 * descriptor engine
+	 */
+	if (pending_desc < rxq->rx_free_thresh)
+		return 0;
+	pending_desc -= pending_desc % rxq->rx_free_thresh;
+
+	id = c2h_pidx;
+	while (pending_desc) {
+		/* contiguous run up to the end of the ring */
+		n = RTE_MIN(pending_desc, (uint16_t)(nb_desc - id));
+		if (rxq->ext_buf) {
+			i = qdma_rx_extbuf_post(rxq, id, n);
+			id += i;
+			if (id >= nb_desc)
+				id -= nb_desc;
+			if (i < n) {
+				ret = -ENOMEM;
+				break;
+			}
+			pending_desc -= n;
+			continue;
+		}
+		if (rte_mempool_get_bulk(rxq->mb_pool,
+				(void **)&rxq->sw_ring[id], n) != 0) {
+			PMD_DRV_LOG(ERR, "%s(): %d: No MBUFS, queue id = %d,"
+			"mbuf_avail_count = %d,"
+			" mbuf_in_use_count = %d, pending_desc = %d\n",
+			__func__, __LINE__, rxq->queue_id,
+			rte_mempool_avail_count(rxq->mb_pool),
+			rte_mempool_in_use_count(rxq->mb_pool), pending_desc);
+			rxq->xstats.mbuf_alloc_failed++;
+			ret = -ENOMEM;
+			break;
+		}
+
+		for (i = 0; i < n; i++) {
+			mb = rxq->sw_ring[id + i];
+
+			/* make it so the data pointer starts there too... */
+			mb->data_off = RTE_PKTMBUF_HEADROOM;
+
+			/* rearm descriptor */
+			qdma_ul_update_st_c2h_desc(mb, &rx_ring_st[id + i]);
+		}
+
+		pending_desc -= n;
+		id += n;
+		if (id >= nb_desc)
+			id -= nb_desc;
+	}
+
+	if (id == c2h_pidx)
+		return ret;
+
+	qdma_trace_rx_refill(rxq, id >= c2h_pidx ? id - c2h_pidx :
+				nb_desc - c2h_pidx + id);
+
+	/* Make sure writes to the C2H descriptors are
+	 * synchronized before updating PIDX
+	 */
+	rte_wmb();
+
+	rxq->q_pidx_info.pidx = id;
+	qdma_rxq_pidx_db(rxq);
+	rxq->xstats.pidx_updates++;
+
+	return ret;
+}
+
+/**
+ * Scalar ST receive burst.
+ *
+ * Completion entries are handled QDMA_MAX_BURST_SIZE at a time, the
+ * lengths and user fields of a chunk are copied out before its mbufs
+ * are chained, so that bursts of any size are served in one call. The
+ * CMPT CIDX and the C2H PIDX are written once, after the last chunk.
+ *
+ * @param rxq
+ *   Pointer to Rx queue structure.
+ * @param[out] rx_pkts
+ *   Array to store received packets.
+ * @param nb_pkts
+ *   Maximum number of packets in array.
+ * @param nb_pend
+ *   Completion entries consumed by the caller whose CIDX is still to be
+ *   written, the vector path hands the rest of a burst over this way.
+ *
+ * @return
+ *   Number of packets successfully received (<= nb_pkts).
+ */
 uint16_t qdma_recv_pkts_st(struct qdma_rx_queue *rxq, struct rte_mbuf **rx_pkts,
-				uint16_t nb_pkts)
+				uint16_t nb_pkts, uint16_t nb_pend)
 {
 	struct rte_mbuf *mb;
 	struct rte_mbuf *first_seg = NULL;
 	struct rte_mbuf *last_seg = NULL;
-	struct qdma_ul_st_c2h_desc *rx_ring_st = NULL;
-	uint32_t count = 0, count_pkts = 0;
+	uint32_t count, count_pkts = 0;
+	uint32_t nb_cmpt = 0, nb_chunk, i;
 	uint16_t id;
 	struct c2h_cmpt_info cmpt_desc;
 	struct qdma_ul_st_cmpt_ring *user_cmpt_entry;
 	struct wb_status *wb_status;
 	uint32_t pkt_length;
 	uint16_t nb_pkts_avail = 0;
-	uint16_t rx_cmpt_tail = 0;
-	uint16_t mbuf_index = 0;
+	uint16_t rx_cmpt_tail;
 	uint16_t pkt_len[QDMA_MAX_BURST_SIZE];
+	/* CMPT user fields, copied out before the entries are released */
+	uint64_t pkt_ts[QDMA_MAX_BURST_SIZE];
+	uint32_t pkt_meta[QDMA_MAX_BURST_SIZE];
 	uint16_t rx_buff_size;
-	uint16_t cmpt_pidx, c2h_pidx;
-	uint16_t pending_desc;
-	struct qdma_pci_dev *qdma_dev = rxq->dev->data->dev_private;
+	uint16_t cmpt_pidx;
 	int ret = 0;
 #ifdef TEST_64B_DESC_BYPASS
 	int bypass_desc_sz_idx = qmda_get_desc_sz_idx(rxq->bypass_desc_sz);
 #endif
 
-	if (unlikely(rxq->err))
-		return 0;
-
-	PMD_DRV_LOG(DEBUG, "recv start on rx queue-id :%d, on "
-			"tail index:%d number of pkts %d",
-			rxq->queue_id, rxq->rx_tail, nb_pkts);
 	wb_status = rxq->wb_status;
 	rx_cmpt_tail = rxq->cmpt_cidx_info.wrb_cidx;
 	rx_buff_size = rxq->rx_buff_size;
+	id = rxq->rx_tail;
+
+	if (unlikely(rxq->err))
+		goto update;
 
 #ifdef TEST_64B_DESC_BYPASS
 	if (unlikely(rxq->en_bypass &&
 			bypass_desc_sz_idx == SW_DESC_CNTXT_64B_BYPASS_DMA)) {
 		PMD_DRV_LOG(DEBUG, "For  RX ST-mode, example"
 				" design doesn't support 64byte descriptor\n");
-		return 0;
+		goto update;
 	}
 #endif
-	rx_ring_st = (struct qdma_ul_st_c2h_desc *)rxq->rx_ring;
 	cmpt_pidx = wb_status->pidx;
 
 	if (rx_cmpt_tail < cmpt_pidx)
@@ -332,12 +655,9 @@ uint16_t qdma_recv_pkts_st(struct qdma_rx_queue *rxq, struct rte_mbuf **rx_pkts,
 	if (nb_pkts_avail == 0) {
 		PMD_DRV_LOG(DEBUG, "%s(): %d: nb_pkts_avail = 0\n",
 				__func__, __LINE__);
-		return 0;
+		goto update;
 	}
 
-	if (nb_pkts > QDMA_MAX_BURST_SIZE)
-		nb_pkts = QDMA_MAX_BURST_SIZE;
-
 	if (nb_pkts > nb_pkts_avail)
 		nb_pkts = nb_pkts_avail;
 
@@ -353,151 +673,143 @@ uint16_t qdma_recv_pkts_st(struct qdma_rx_queue *rxq, struct rte_mbuf **rx_pkts,
 	 */
 	rte_rmb();
 
-	while (count < nb_pkts) {
-		memset(&cmpt_desc, 0, sizeof(struct c2h_cmpt_info));
-		user_cmpt_entry =
-		(struct qdma_ul_st_cmpt_ring *)((uint64_t)rxq->cmpt_ring +
-		((uint64_t)rx_cmpt_tail *
-		rxq->cmpt_desc_len));
-		qdma_ul_extract_st_cmpt_info(user_cmpt_entry, &cmpt_desc);
-
-		if (unlikely(cmpt_desc.err || cmpt_desc.data_frmt)) {
-			PMD_DRV_LOG(ERR, "Error detected on CMPT ring at index %d, "
-					 "len = %d, queue_id = %d\n",
-					 rx_cmpt_tail, cmpt_desc.length,
-					 rxq->queue_id);
-			rxq->err = 1;
-			return 0;
-		}
+	while (nb_cmpt < nb_pkts) {
+		nb_chunk = RTE_MIN(nb_pkts - nb_cmpt,
+				(uint32_t)QDMA_MAX_BURST_SIZE);
+
+		for (count = 0; count < nb_chunk; count++) {
+			memset(&cmpt_desc, 0, sizeof(struct c2h_cmpt_info));
+			user_cmpt_entry = (struct qdma_ul_st_cmpt_ring *)
+				((uint64_t)rxq->cmpt_ring +
+				((uint64_t)rx_cmpt_tail *
+				rxq->cmpt_desc_len));
+			qdma_ul_extract_st_cmpt_info(user_cmpt_entry,
+					&cmpt_desc);
+
+			if (unlikely(cmpt_desc.err || cmpt_desc.data_frmt)) {
+				PMD_DRV_LOG(ERR, "Error detected on CMPT ring "
+						"at index %d, len = %d, "
+						"queue_id = %d\n",
+						rx_cmpt_tail, cmpt_desc.length,
+						rxq->queue_id);
+				rxq->err = 1;
+				rxq->xstats.cmpt_err++;
+				break;
+			}
 
-		if (unlikely(rxq->dump_immediate_data)) {
-			ret = qdma_ul_process_immediate_data_st((void *)rxq,
-					user_cmpt_entry, rxq->cmpt_desc_len);
-			if (ret < 0)
-				return 0;
+			if (unlikely(rxq->dump_immediate_data)) {
+				ret = qdma_ul_process_immediate_data_st(
+						(void *)rxq, user_cmpt_entry,
+						rxq->cmpt_desc_len);
+				if (ret < 0)
+					break;
+			}
+			if (unlikely(rxq->cmpt_ts_off >= 0))
+				pkt_ts[count] = rte_le_to_cpu_64(
+					*(unaligned_uint64_t *)
+					((uint8_t *)user_cmpt_entry +
+					rxq->cmpt_ts_off));
+			if (unlikely(rxq->cmpt_meta_off >= 0))
+				pkt_meta[count] = rte_le_to_cpu_32(
+					*(unaligned_uint32_t *)
+					((uint8_t *)user_cmpt_entry +
+					rxq->cmpt_meta_off));
+			pkt_len[count] = cmpt_desc.length;
+			rx_cmpt_tail++;
+			if (unlikely(rx_cmpt_tail >=
+					(rxq->nb_rx_cmpt_desc - 1)))
+				rx_cmpt_tail -= (rxq->nb_rx_cmpt_desc - 1);
 		}
-		pkt_len[count] = cmpt_desc.length;
-		rx_cmpt_tail++;
-		if (unlikely(rx_cmpt_tail >= (rxq->nb_rx_cmpt_desc - 1)))
-			rx_cmpt_tail -= (rxq->nb_rx_cmpt_desc - 1);
-		count++;
-	}
-	// Update the CPMT CIDX
-	rxq->cmpt_cidx_info.wrb_cidx = rx_cmpt_tail;
-	qdma_dev->hw_access->qdma_queue_cmpt_cidx_update(rxq->dev,
-		qdma_dev->is_vf,
-		rxq->queue_id, &rxq->cmpt_cidx_info);
-
-	if (rxq->status != RTE_ETH_QUEUE_STATE_STARTED) {
-		PMD_DRV_LOG(DEBUG, "%s(): %d: rxq->status = %d\n",
-				__func__, __LINE__, rxq->status);
-		return 0;
-	}
-
-	count = 0;
-	mbuf_index = 0;
-	id = rxq->rx_tail;
-	while (count < nb_pkts) {
-		pkt_length = pkt_len[count];
+		nb_cmpt += count;
 
-		if (unlikely(!pkt_length)) {
-			count++;
+		/* A stopped queue only releases its completions */
+		if (unlikely(rxq->status != RTE_ETH_QUEUE_STATE_STARTED)) {
+			if (count < nb_chunk)
+				break;
 			continue;
 		}
 
-		do {
-			mb = rxq->sw_ring[id];
-			rxq->sw_ring[id++] = NULL;
-
-			if (unlikely(id >= (rxq->nb_rx_desc - 1)))
-				id -= (rxq->nb_rx_desc - 1);
-			if (pkt_length > rx_buff_size) {
-				rte_pktmbuf_data_len(mb) = rx_buff_size;
-				pkt_length -= rx_buff_size;
-			} else {
-				rte_pktmbuf_data_len(mb) = pkt_length;
-				pkt_length = 0;
-			}
-			rte_mbuf_refcnt_set(mb, 1);
-
-			if (first_seg == NULL) {
-				first_seg = mb;
-				first_seg->nb_segs = 1;
-				first_seg->pkt_len = pkt_len[count];
-				first_seg->packet_type = 0;
-				first_seg->ol_flags = 0;
-				first_seg->port = rxq->port_id;
-				first_seg->vlan_tci = 0;
-				first_seg->hash.rss = 0;
-			} else {
-				first_seg->nb_segs++;
-				last_seg->next = mb;
+		for (i = 0; i < count; i++) {
+			pkt_length = pkt_len[i];
+
+			if (unlikely(!pkt_length))
+				continue;
+
+			if (unlikely(rxq->ext_buf)) {
+				first_seg = qdma_rx_extbuf_pkt(rxq, &id,
+						pkt_length);
+				if (unlikely(first_seg == NULL))
+					continue;
+				qdma_rx_pkt_init(rxq, first_seg, pkt_length,
+						&pkt_ts[i], &pkt_meta[i]);
+				rxq->stats.pkts++;
+				rxq->stats.bytes += pkt_len[i];
+				rx_pkts[count_pkts++] = first_seg;
+				first_seg = NULL;
+				continue;
 			}
 
-			last_seg = mb;
-			mb->next = NULL;
-		} while (pkt_length);
-		rxq->stats.pkts++;
-		rxq->stats.bytes += pkt_len[count++];
-		rx_pkts[count_pkts++] = first_seg;
-		first_seg = NULL;
-	}
-
-	rxq->rx_tail = id;
-	c2h_pidx = rxq->q_pidx_info.pidx;
-
-	pending_desc = rxq->rx_tail - c2h_pidx - 1;
-	if (rxq->rx_tail < (c2h_pidx + 1))
-		pending_desc = rxq->nb_rx_desc - 2 + rxq->rx_tail -
-				c2h_pidx;
-
-	/* Batch the PIDX updates, this minimizes overhead on
-	 * descriptor engine
-	 */
-	if (pending_desc >= MIN_RX_PIDX_UPDATE_THRESHOLD) {
-		struct rte_mbuf *tmp_sw_ring[pending_desc];
-		/* allocate new buffer */
-		if (rte_mempool_get_bulk(rxq->mb_pool, (void *)tmp_sw_ring,
-						pending_desc) != 0){
-			PMD_DRV_LOG(ERR, "%s(): %d: No MBUFS, queue id = %d,"
-			"mbuf_avail_count = %d,"
-			" mbuf_in_use_count = %d, pending_desc = %d\n",
-			__func__, __LINE__, rxq->queue_id,
-			rte_mempool_avail_count(rxq->mb_pool),
-			rte_mempool_in_use_count(rxq->mb_pool), pending_desc);
-			return count_pkts;
+			do {
+				mb = rxq->sw_ring[id];
+				rxq->sw_ring[id++] = NULL;
+
+				if (unlikely(id >= (rxq->nb_rx_desc - 1)))
+					id -= (rxq->nb_rx_desc - 1);
+				if (pkt_length > rx_buff_size) {
+					rte_pktmbuf_data_len(mb) =
+							rx_buff_size;
+					pkt_length -= rx_buff_size;
+				} else {
+					rte_pktmbuf_data_len(mb) = pkt_length;
+					pkt_length = 0;
+				}
+				rte_mbuf_refcnt_set(mb, 1);
+
+				if (first_seg == NULL) {
+					first_seg = mb;
+					first_seg->nb_segs = 1;
+					first_seg->ol_flags = 0;
+					qdma_rx_pkt_init(rxq, first_seg,
+							pkt_len[i], &pkt_ts[i],
+							&pkt_meta[i]);
+				} else {
+					first_seg->nb_segs++;
+					last_seg->next = mb;
+				}
+
+				last_seg = mb;
+				mb->next = NULL;
+			} while (pkt_length);
+			rxq->stats.pkts++;
+			rxq->stats.bytes += pkt_len[i];
+			rx_pkts[count_pkts++] = first_seg;
+			first_seg = NULL;
 		}
 
-		id = c2h_pidx;
-		for (mbuf_index = 0; mbuf_index < pending_desc; mbuf_index++) {
-			mb = tmp_sw_ring[mbuf_index];
-
-			/* make it so the data pointer starts there too... */
-			mb->data_off = RTE_PKTMBUF_HEADROOM;
-
-			/* rearm descriptor */
-			qdma_ul_update_st_c2h_desc(mb, &rx_ring_st[id]);
-			rxq->sw_ring[id++] = mb;
-			if (unlikely(id >= (rxq->nb_rx_desc - 1)))
-				id -= (rxq->nb_rx_desc - 1);
-		}
+		if (count < nb_chunk)
+			break;
+	}
 
-		PMD_DRV_LOG(DEBUG, "%s(): %d: PIDX Update: queue id = %d, "
-					"pending_desc = %d",
-					__func__, __LINE__, rxq->queue_id,
-					pending_desc);
+update:
+	nb_cmpt += nb_pend;
+	if (nb_cmpt == 0)
+		return 0;
 
-		/* Make sure writes to the C2H descriptors are
-		 * synchronized before updating PIDX
-		 */
-		rte_wmb();
+	// Update the CPMT CIDX
+	qdma_trace_rx_cmpt_batch(rxq, nb_cmpt);
+	rxq->cmpt_cidx_info.wrb_cidx = rx_cmpt_tail;
+	qdma_rxq_cmpt_cidx_db(rxq);
+	rxq->xstats.cidx_updates++;
 
-		rxq->q_pidx_info.pidx = id;
-		qdma_dev->hw_access->qdma_queue_pidx_update(rxq->dev,
-			qdma_dev->is_vf,
-			rxq->queue_id, 1, &rxq->q_pidx_info);
+	if (rxq->status != RTE_ETH_QUEUE_STATE_STARTED) {
+		PMD_DRV_LOG(DEBUG, "%s(): %d: rxq->status = %d\n",
+				__func__, __LINE__, rxq->status);
+		return 0;
 	}
 
+	rxq->rx_tail = id;
+	qdma_rx_refill_st(rxq);
+
 #ifdef DUMP_MEMPOOL_USAGE_STATS
 	PMD_DRV_LOG(DEBUG, "%s(): %d: queue id = %d, mbuf_avail_count = %d,"
 			" mbuf_in_use_count = %d, count_pkts = %d",
@@ -506,23 +818,36 @@ uint16_t qdma_recv_pkts_st(struct qdma_rx_queue *rxq, struct rte_mbuf **rx_pkts,
 		rte_mempool_in_use_count(rxq->mb_pool), count_pkts);
 #endif //DUMP_MEMPOOL_USAGE_STATS
 
-	PMD_DRV_LOG(DEBUG, " Recv complete with hw cidx :%d",
-				rxq->wb_status->cidx);
-	PMD_DRV_LOG(DEBUG, " Recv complete with hw pidx :%d\n",
-				rxq->wb_status->pidx);
-
 	return count_pkts;
 }
 
+/**
+ * Memory mapped receive burst.
+ *
+ * Buffers whose DMA was completed by the hardware (up to the writeback
+ * CIDX) are returned to the caller. New descriptors are then posted so
+ * that nb_pkts transfers are outstanding; the burst never waits for the
+ * engine, data for the posted descriptors is returned by later calls.
+ *
+ * @param rxq
+ *   Pointer to Rx queue structure.
+ * @param[out] rx_pkts
+ *   Array to store received packets.
+ * @param nb_pkts
+ *   Maximum number of packets in array.
+ *
+ * @return
+ *   Number of packets successfully received (<= nb_pkts).
+ */
 uint16_t qdma_recv_pkts_mm(struct qdma_rx_queue *rxq, struct rte_mbuf **rx_pkts,
 			uint16_t nb_pkts)
 {
 	struct rte_mbuf *mb;
-	uint32_t count, id;
+	uint32_t count, id, i, n;
 	struct qdma_ul_mm_desc *desc;
 	uint32_t len;
-	int ret;
-	struct qdma_pci_dev *qdma_dev = rxq->dev->data->dev_private;
+	int nb_done, in_flight, nb_post, posted = 0;
+	uint16_t nb_desc = rxq->nb_rx_desc - 1;
 #ifdef TEST_64B_DESC_BYPASS
 	int bypass_desc_sz_idx = qmda_get_desc_sz_idx(rxq->bypass_desc_sz);
 #endif
@@ -530,11 +855,6 @@ uint16_t qdma_recv_pkts_mm(struct qdma_rx_queue *rxq, struct rte_mbuf **rx_pkts,
 	if (rxq->status != RTE_ETH_QUEUE_STATE_STARTED)
 		return 0;
 
-	id = rxq->q_pidx_info.pidx; /* Descriptor index */
-
-	PMD_DRV_LOG(DEBUG, "recv start on rx queue-id :%d, on tail index:%d\n",
-			rxq->queue_id, id);
-
 #ifdef TEST_64B_DESC_BYPASS
 	if (unlikely(rxq->en_bypass &&
 			bypass_desc_sz_idx == SW_DESC_CNTXT_64B_BYPASS_DMA)) {
@@ -543,72 +863,167 @@ uint16_t qdma_recv_pkts_mm(struct qdma_rx_queue *rxq, struct rte_mbuf **rx_pkts,
 		return 0;
 	}
 #endif
-	/* Make 1 less available, otherwise if we allow all descriptors
+	/* Harvest the buffers completed by the engine */
+	id = rxq->rx_tail;
+	nb_done = (int)rxq->wb_status->cidx - id;
+	if (nb_done < 0)
+		nb_done += nb_desc;
+	if (nb_done > nb_pkts)
+		nb_done = nb_pkts;
+
+	/* Make sure reads to the buffers are not done before the
+	 * writeback CIDX is read
+	 */
+	rte_rmb();
+
+	for (count = 0; count < (uint32_t)nb_done; count++) {
+		rx_pkts[count] = rxq->sw_ring[id];
+		rxq->sw_ring[id] = NULL;
+		id++;
+		if (unlikely(id >= nb_desc))
+			id -= nb_desc;
+	}
+	rxq->rx_tail = id;
+
+	/* Post as many descriptors as needed to have the remainder of the
+	 * request outstanding.
+	 * Make 1 less available, otherwise if we allow all descriptors
 	 * to be filled,when nb_pkts = nb_tx_desc - 1, pidx will be same
 	 * as old pidx and HW will treat this as no new descriptors were added.
 	 * Hence, DMA won't happen with new descriptors.
 	 */
-	if (nb_pkts > rxq->nb_rx_desc - 2)
-		nb_pkts = rxq->nb_rx_desc - 2;
-
-	for (count = 0; count < nb_pkts; count++) {
-		/* allocate new buffer */
-		if (rte_mempool_get(rxq->mb_pool, (void *)&mb) != 0) {
+	id = rxq->q_pidx_info.pidx;
+	in_flight = (int)id - rxq->rx_tail;
+	if (in_flight < 0)
+		in_flight += nb_desc;
+	nb_post = (int)nb_pkts - (int)count - in_flight;
+	if (nb_post > (nb_desc - 1 - in_flight))
+		nb_post = nb_desc - 1 - in_flight;
+
+	len = rxq->rx_buff_size;
+	while (posted < nb_post) {
+		/* contiguous run up to the end of the ring */
+		n = RTE_MIN((uint32_t)(nb_post - posted), nb_desc - id);
+		if (rte_mempool_get_bulk(rxq->mb_pool,
+				(void **)&rxq->sw_ring[id], n) != 0) {
 			PMD_DRV_LOG(ERR, "%s(): %d: No MBUFS, queue id = %d,"
 			"mbuf_avail_count = %d,"
 			" mbuf_in_use_count = %d\n",
 			__func__, __LINE__, rxq->queue_id,
 			rte_mempool_avail_count(rxq->mb_pool),
 			rte_mempool_in_use_count(rxq->mb_pool));
-			return 0;
+			rxq->xstats.mbuf_alloc_failed++;
+			break;
 		}
 
-		desc = (struct qdma_ul_mm_desc *)rxq->rx_ring;
-		desc += id;
-		qdma_ul_update_mm_c2h_desc(rxq, mb, desc);
+		for (i = 0; i < n; i++) {
+			mb = rxq->sw_ring[id + i];
+			desc = (struct qdma_ul_mm_desc *)rxq->rx_ring;
+			desc += id + i;
+			qdma_ul_update_mm_c2h_desc(rxq, mb, desc);
 
-		len = (int)rxq->rx_buff_size;
-		rte_pktmbuf_pkt_len(mb) = len;
+			rte_pktmbuf_pkt_len(mb) = len;
+			rte_pktmbuf_data_len(mb) = len;
+			rte_mbuf_refcnt_set(mb, 1);
+			mb->packet_type = 0;
+			mb->ol_flags = 0;
+			mb->next = 0;
+			mb->nb_segs = 1;
+			mb->port = rxq->port_id;
+			mb->vlan_tci = 0;
+			mb->hash.rss = 0;
+
+			rxq->ep_addr = (rxq->ep_addr + len) % DMA_BRAM_SIZE;
+		}
 
-		rte_mbuf_refcnt_set(mb, 1);
-		mb->packet_type = 0;
-		mb->ol_flags = 0;
-		mb->next = 0;
-		mb->nb_segs = 1;
-		mb->port = rxq->port_id;
-		mb->vlan_tci = 0;
-		mb->hash.rss = 0;
+		posted += n;
+		id += n;
+		if (id >= nb_desc)
+			id -= nb_desc;
+	}
 
-		rx_pkts[count] = mb;
+	/* update pidx pointer for MM-mode*/
+	if (posted > 0) {
+		/* Make sure writes to the C2H descriptors are synchronized
+		 * before updating PIDX
+		 */
+		rte_wmb();
 
-		rxq->ep_addr = (rxq->ep_addr + len) % DMA_BRAM_SIZE;
-		id = (id + 1) % (rxq->nb_rx_desc - 1);
+		rxq->q_pidx_info.pidx = id;
+		qdma_rxq_pidx_db(rxq);
+		rxq->xstats.pidx_updates++;
 	}
 
-	/* Make sure writes to the C2H descriptors are synchronized
-	 * before updating PIDX
-	 */
-	rte_wmb();
+	return count;
+}
 
-	/* update pidx pointer for MM-mode*/
-	if (count > 0) {
-		rxq->q_pidx_info.pidx = id;
-		qdma_dev->hw_access->qdma_queue_pidx_update(rxq->dev,
-			qdma_dev->is_vf,
-			rxq->queue_id, 1, &rxq->q_pidx_info);
+/* Bursts between two picks of the adaptive counter threshold */
+#define QDMA_CNTR_ADAPT_INTERVAL	(16)
+
+/*
+ * Load the trigger mode, timer and counter set by
+ * rte_pmd_qdma_set_cmpt_moderation() into the CIDX register fields. Runs
+ * on the lcore polling the queue, the next CIDX update applies them.
+ */
+void qdma_rx_cmpt_moder_update(struct qdma_rx_queue *rxq)
+{
+	rxq->cmpt_moder_upd = 0;
+	rte_smp_rmb();
+
+	rxq->cmpt_cidx_info.trig_mode = rxq->triggermode;
+	rxq->cmpt_cidx_info.timer_idx = rxq->timeridx;
+	rxq->cmpt_cidx_info.counter_idx = rxq->threshidx;
+}
+
+/*
+ * Pick the counter threshold closest to the moving average of the
+ * completion backlog seen at the start of each burst, bounded by half of
+ * the completion ring. Bulk phases get fewer status writes and
+ * interrupts, sparse traffic a low threshold and low latency.
+ */
+static void qdma_rx_cntr_adapt(struct qdma_rx_queue *rxq, int in_use)
+{
+	struct qdma_pci_dev *qdma_dev;
+	uint32_t th, diff, best_diff = UINT32_MAX;
+	uint32_t max_th = rxq->nb_rx_cmpt_desc >> 1;
+	uint8_t i, best = rxq->cmpt_cidx_info.counter_idx;
+
+	rxq->cntr_avg = (rxq->cntr_avg + in_use) >> 1;
+	if (++rxq->cntr_adapt_cnt < QDMA_CNTR_ADAPT_INTERVAL)
+		return;
+	rxq->cntr_adapt_cnt = 0;
+
+	qdma_dev = rte_eth_devices[rxq->port_id].data->dev_private;
+	for (i = 0; i < QDMA_NUM_C2H_COUNTERS; i++) {
+		th = qdma_dev->g_c2h_cnt_th[i];
+		if (!th || th > max_th)
+			continue;
+		diff = (th > rxq->cntr_avg) ? th - rxq->cntr_avg :
+				rxq->cntr_avg - th;
+		if (diff < best_diff) {
+			best_diff = diff;
+			best = i;
+		}
 	}
 
-	ret = dma_wb_monitor(rxq, DMA_FROM_DEVICE, id);
-	if (ret) {//Error
-		PMD_DRV_LOG(ERR, "DMA Engine write-back monitor "
-				"timeout error occurred, wb-count:%d "
-				"and expected-count:%d\n",
-				rxq->wb_status->cidx, id);
+	/* carried to the hardware by the next CIDX update */
+	rxq->cmpt_cidx_info.counter_idx = best;
+}
 
-		return 0;
+static void qdma_rx_cmpt_moderate(struct qdma_rx_queue *rxq, int in_use)
+{
+	if (rxq->cmpt_moder_upd) {
+		qdma_rx_cmpt_moder_update(rxq);
+
+		/* write it right away, an idle queue has no CIDX update */
+		qdma_rxq_cmpt_cidx_db(rxq);
+		rxq->xstats.cidx_updates++;
 	}
-	return count;
+
+	if (rxq->cntr_adaptive)
+		qdma_rx_cntr_adapt(rxq, in_use);
 }
+
 /**
  * DPDK callback for receiving packets in burst.
  *
@@ -626,16 +1041,184 @@ uint16_t qdma_recv_pkts(void *rx_queue, struct rte_mbuf **rx_pkts,
 			uint16_t nb_pkts)
 {
 	struct qdma_rx_queue *rxq = rx_queue;
+	uint64_t tsc = 0;
 	uint32_t count;
+	int in_use;
+
+	if (unlikely(rxq->cycles_en))
+		tsc = rte_rdtsc();
+	qdma_trace_rx_burst_entry(rxq, nb_pkts);
 
-	if (rxq->st_mode)
-		count = qdma_recv_pkts_st(rxq, rx_pkts, nb_pkts);
-	else
+	/* Ring occupancy is sampled before the burst: completions waiting
+	 * on ST queues, descriptors posted to the engine on MM queues
+	 */
+	if (rxq->st_mode) {
+		in_use = (int)rxq->wb_status->pidx -
+				rxq->cmpt_cidx_info.wrb_cidx;
+		if (in_use < 0)
+			in_use += rxq->nb_rx_cmpt_desc - 1;
+		if (unlikely(rxq->cmpt_moder_upd | rxq->cntr_adaptive))
+			qdma_rx_cmpt_moderate(rxq, in_use);
+#ifdef RTE_ARCH_X86
+		if (rxq->rx_vec_path != QDMA_RX_VEC_NONE)
+			count = qdma_recv_pkts_st_vec(rxq, rx_pkts, nb_pkts);
+		else
+#endif
+		count = qdma_recv_pkts_st(rxq, rx_pkts, nb_pkts, 0);
+	} else {
+		in_use = (int)rxq->q_pidx_info.pidx - rxq->rx_tail;
+		if (in_use < 0)
+			in_use += rxq->nb_rx_desc - 1;
 		count = qdma_recv_pkts_mm(rxq, rx_pkts, nb_pkts);
+	}
+
+	qdma_xstats_burst(&rxq->xstats, count, in_use);
+	qdma_trace_rx_burst_exit(rxq, count);
+	if (unlikely(rxq->cycles_en))
+		qdma_cycles_burst(&rxq->cycles, tsc, count);
 
 	return count;
 }
 
+/* Descriptors completed by the engine and not yet received */
+static inline uint32_t qdma_rx_done_count(struct qdma_rx_queue *rxq)
+{
+	int nb_done;
+
+	if (rxq->st_mode) {
+		/* a completion entry stands for at least one descriptor */
+		nb_done = (int)rxq->wb_status->pidx -
+				rxq->cmpt_cidx_info.wrb_cidx;
+		if (nb_done < 0)
+			nb_done += rxq->nb_rx_cmpt_desc - 1;
+	} else {
+		nb_done = (int)rxq->wb_status->cidx - rxq->rx_tail;
+		if (nb_done < 0)
+			nb_done += rxq->nb_rx_desc - 1;
+	}
+
+	return nb_done;
+}
+
+/**
+ * DPDK callback to get the number of used descriptors of a Rx queue.
+ *
+ * Computed from the writeback status and the software indexes only,
+ * no register is read. On ST queues the completion entries waiting to
+ * be received are counted, i.e. packets rather than C2H buffers.
+ *
+ * @param dev
+ *   Pointer to Ethernet device structure.
+ * @param rx_queue_id
+ *   Rx queue index.
+ *
+ * @return
+ *   Number of descriptors holding received data.
+ */
+uint32_t qdma_dev_rx_queue_count(struct rte_eth_dev *dev,
+			uint16_t rx_queue_id)
+{
+	struct qdma_rx_queue *rxq = dev->data->rx_queues[rx_queue_id];
+
+	if (rxq == NULL || rxq->status != RTE_ETH_QUEUE_STATE_STARTED)
+		return 0;
+
+	return qdma_rx_done_count(rxq);
+}
+
+/**
+ * DPDK callback to check the status of a Rx descriptor.
+ *
+ * @param rx_queue
+ *   Generic pointer to Rx queue structure.
+ * @param offset
+ *   Offset of the descriptor from the next one to be received.
+ *
+ * @return
+ *   RTE_ETH_RX_DESC_DONE if it holds received data,
+ *   RTE_ETH_RX_DESC_AVAIL if it is posted to the engine,
+ *   RTE_ETH_RX_DESC_UNAVAIL otherwise, -EINVAL on a bad offset.
+ */
+int qdma_dev_rx_descriptor_status(void *rx_queue, uint16_t offset)
+{
+	struct qdma_rx_queue *rxq = rx_queue;
+	int nb_posted;
+
+	if (unlikely(offset >= rxq->nb_rx_desc - 1))
+		return -EINVAL;
+
+	if (rxq->status != RTE_ETH_QUEUE_STATE_STARTED)
+		return RTE_ETH_RX_DESC_UNAVAIL;
+
+	if (offset < qdma_rx_done_count(rxq))
+		return RTE_ETH_RX_DESC_DONE;
+
+	nb_posted = (int)rxq->q_pidx_info.pidx - rxq->rx_tail;
+	if (nb_posted < 0)
+		nb_posted += rxq->nb_rx_desc - 1;
+	if (offset < nb_posted)
+		return RTE_ETH_RX_DESC_AVAIL;
+
+	return RTE_ETH_RX_DESC_UNAVAIL;
+}
+
+/**
+ * Write all pending H2C descriptors to the PIDX register.
+ *
+ * Only the lcore owning the queue, or the control path while the
+ * queue is stopped, may call this; no locking is done.
+ *
+ * @param txq
+ *   Pointer to Tx queue structure.
+ */
+void qdma_tx_pidx_flush(struct qdma_tx_queue *txq)
+{
+
+	if (!txq->tx_desc_pend)
+		return;
+
+	/* Make sure writes to the H2C descriptors are synchronized
+	 * before updating PIDX
+	 */
+	rte_wmb();
+
+	qdma_txq_pidx_db(txq);
+	txq->xstats.pidx_updates++;
+
+	txq->tx_desc_pend = 0;
+}
+
+/**
+ * Account newly written ST H2C descriptors and ring the doorbell once
+ * the per queue descriptor or time budget is used up. Called with
+ * nb_desc = 0 from bursts that add nothing, so that the time budget
+ * is also honoured on an idle queue.
+ *
+ * @param txq
+ *   Pointer to Tx queue structure.
+ * @param nb_desc
+ *   Number of descriptors added since the last call.
+ */
+void qdma_tx_pidx_update_st(struct qdma_tx_queue *txq, uint16_t nb_desc)
+{
+	uint64_t now;
+
+	txq->tx_desc_pend += nb_desc;
+	if (!txq->tx_desc_pend)
+		return;
+
+	/* Send PIDX update only if pending desc is more than threshold
+	 * or the time budget is over. Saves frequent Hardware transactions
+	 */
+	now = rte_get_timer_cycles();
+	if (txq->tx_desc_pend < txq->tx_pidx_batch &&
+			(now - txq->tx_pidx_tsc) < txq->tx_pidx_tmo)
+		return;
+
+	qdma_tx_pidx_flush(txq);
+	txq->tx_pidx_tsc = now;
+}
+
 uint16_t qdma_xmit_pkts_st(struct qdma_tx_queue *txq, struct rte_mbuf **tx_pkts,
 			uint16_t nb_pkts)
 {
@@ -644,7 +1227,6 @@ uint16_t qdma_xmit_pkts_st(struct qdma_tx_queue *txq, struct rte_mbuf **tx_pkts,
 	int avail, in_use, ret, nsegs;
 	uint16_t pkt_len;
 	uint16_t cidx = 0;
-	struct qdma_pci_dev *qdma_dev = txq->dev->data->dev_private;
 #ifdef TEST_64B_DESC_BYPASS
 	int bypass_desc_sz_idx = qmda_get_desc_sz_idx(txq->bypass_desc_sz);
 
@@ -656,13 +1238,12 @@ uint16_t qdma_xmit_pkts_st(struct qdma_tx_queue *txq, struct rte_mbuf **tx_pkts,
 
 	id = txq->q_pidx_info.pidx;
 	cidx = txq->wb_status->cidx;
-	PMD_DRV_LOG(DEBUG, "Xmit start on tx queue-id:%d, tail index:%d\n",
-			txq->queue_id, id);
 
 	/* Free transmitted mbufs back to pool */
 	reclaim_tx_mbuf(txq, cidx);
 
-	in_use = (int)id - cidx;
+	/* Descriptors stay in use until their mbufs are reclaimed */
+	in_use = (int)id - txq->tx_fl_tail;
 	if (in_use < 0)
 		in_use += (txq->nb_tx_desc - 1);
 
@@ -673,7 +1254,9 @@ uint16_t qdma_xmit_pkts_st(struct qdma_tx_queue *txq, struct rte_mbuf **tx_pkts,
 	 */
 	avail = txq->nb_tx_desc - 2 - in_use;
 	if (!avail) {
-		PMD_DRV_LOG(DEBUG, "Tx queue full, in_use = %d", in_use);
+		qdma_trace_tx_queue_full(txq, in_use);
+		txq->xstats.queue_full++;
+		qdma_tx_pidx_update_st(txq, 0);
 		return 0;
 	}
 
@@ -702,27 +1285,7 @@ uint16_t qdma_xmit_pkts_st(struct qdma_tx_queue *txq, struct rte_mbuf **tx_pkts,
 		txq->stats.bytes += pkt_len;
 	}
 
-	/* Make sure writes to the H2C descriptors are synchronized
-	 * before updating PIDX
-	 */
-	rte_wmb();
-
-	rte_spinlock_lock(&txq->pidx_update_lock);
-	txq->tx_desc_pend += count;
-
-	/* Send PIDX update only if pending desc is more than threshold
-	 * Saves frequent Hardware transactions
-	 */
-	if (txq->tx_desc_pend >= MIN_TX_PIDX_UPDATE_THRESHOLD) {
-		qdma_dev->hw_access->qdma_queue_pidx_update(txq->dev,
-			qdma_dev->is_vf,
-			txq->queue_id, 0, &txq->q_pidx_info);
-
-		txq->tx_desc_pend = 0;
-	}
-	rte_spinlock_unlock(&txq->pidx_update_lock);
-
-	PMD_DRV_LOG(DEBUG, " xmit completed with count:%d\n", count);
+	qdma_tx_pidx_update_st(txq, count);
 
 	return count;
 }
@@ -734,8 +1297,6 @@ uint16_t qdma_xmit_pkts_mm(struct qdma_tx_queue *txq, struct rte_mbuf **tx_pkts,
 	uint32_t count, id;
 	uint64_t	len = 0;
 	int avail, in_use;
-	int ret;
-	struct qdma_pci_dev *qdma_dev = txq->dev->data->dev_private;
 	uint16_t cidx = 0;
 
 #ifdef TEST_64B_DESC_BYPASS
@@ -743,8 +1304,6 @@ uint16_t qdma_xmit_pkts_mm(struct qdma_tx_queue *txq, struct rte_mbuf **tx_pkts,
 #endif
 
 	id = txq->q_pidx_info.pidx;
-	PMD_DRV_LOG(DEBUG, "Xmit start on tx queue-id:%d, tail index:%d\n",
-			txq->queue_id, id);
 
 #ifdef TEST_64B_DESC_BYPASS
 	if (unlikely(txq->en_bypass &&
@@ -757,7 +1316,7 @@ uint16_t qdma_xmit_pkts_mm(struct qdma_tx_queue *txq, struct rte_mbuf **tx_pkts,
 	cidx = txq->wb_status->cidx;
 	/* Free transmitted mbufs back to pool */
 	reclaim_tx_mbuf(txq, cidx);
-	in_use = (int)id - cidx;
+	in_use = (int)id - txq->tx_fl_tail;
 	if (in_use < 0)
 		in_use += (txq->nb_tx_desc - 1);
 
@@ -768,7 +1327,8 @@ uint16_t qdma_xmit_pkts_mm(struct qdma_tx_queue *txq, struct rte_mbuf **tx_pkts,
 	 */
 	avail = txq->nb_tx_desc - 2 - in_use;
 	if (!avail) {
-		PMD_DRV_LOG(ERR, "Tx queue full, in_use = %d", in_use);
+		qdma_trace_tx_queue_full(txq, in_use);
+		txq->xstats.queue_full++;
 		return 0;
 	}
 
@@ -798,22 +1358,10 @@ uint16_t qdma_xmit_pkts_mm(struct qdma_tx_queue *txq, struct rte_mbuf **tx_pkts,
 
 	/* update pidx pointer */
 	if (count > 0) {
-		PMD_DRV_LOG(INFO, "tx PIDX=%d", txq->q_pidx_info.pidx);
-		qdma_dev->hw_access->qdma_queue_pidx_update(txq->dev,
-			qdma_dev->is_vf,
-			txq->queue_id, 0, &txq->q_pidx_info);
-	}
-
-	ret = dma_wb_monitor(txq, DMA_TO_DEVICE, id);
-	if (ret) {
-		PMD_DRV_LOG(ERR, "DMA Engine write-back monitor "
-				"timeout error occurred, wb-count:%d "
-				"and expected-count:%d\n",
-				txq->wb_status->cidx, id);
-		return 0;
+		qdma_txq_pidx_db(txq);
+		txq->xstats.pidx_updates++;
 	}
 
-	PMD_DRV_LOG(DEBUG, " xmit completed with count:%d", count);
 	return count;
 }
 /**
@@ -833,15 +1381,69 @@ uint16_t qdma_xmit_pkts(void *tx_queue, struct rte_mbuf **tx_pkts,
 			uint16_t nb_pkts)
 {
 	struct qdma_tx_queue *txq = tx_queue;
+	uint64_t tsc = 0;
 	uint16_t count;
+	int in_use;
 
 	if (txq->status != RTE_ETH_QUEUE_STATE_STARTED)
 		return 0;
 
-	if (txq->st_mode)
+	if (unlikely(txq->cycles_en))
+		tsc = rte_rdtsc();
+	qdma_trace_tx_burst_entry(txq, nb_pkts);
+
+	if (txq->st_mode) {
+#ifdef RTE_ARCH_X86
+		if (txq->tx_vec_en)
+			count = qdma_xmit_pkts_st_vec(txq, tx_pkts, nb_pkts);
+		else
+#endif
 		count =	qdma_xmit_pkts_st(txq, tx_pkts, nb_pkts);
-	else
+	} else
 		count =	qdma_xmit_pkts_mm(txq, tx_pkts, nb_pkts);
 
+	/* Descriptors in use once the burst is queued */
+	in_use = (int)txq->q_pidx_info.pidx - txq->tx_fl_tail;
+	if (in_use < 0)
+		in_use += txq->nb_tx_desc - 1;
+	qdma_xstats_burst(&txq->xstats, count, in_use);
+	qdma_trace_tx_burst_exit(txq, count);
+	if (unlikely(txq->cycles_en))
+		qdma_cycles_burst(&txq->cycles, tsc, count);
+
 	return count;
 }
+
+/**
+ * DPDK callback to check the status of a Tx descriptor.
+ *
+ * Descriptors from the hardware CIDX up to the software PIDX are in
+ * flight, including the ones whose doorbell is still coalesced.
+ *
+ * @param tx_queue
+ *   Generic pointer to Tx queue structure.
+ * @param offset
+ *   Offset of the descriptor from the next one to be used for Tx.
+ *
+ * @return
+ *   RTE_ETH_TX_DESC_FULL if the hardware still owns it,
+ *   RTE_ETH_TX_DESC_DONE if it can be reused, -EINVAL on a bad offset.
+ */
+int qdma_dev_tx_descriptor_status(void *tx_queue, uint16_t offset)
+{
+	struct qdma_tx_queue *txq = tx_queue;
+	int in_flight;
+
+	if (unlikely(offset >= txq->nb_tx_desc - 1))
+		return -EINVAL;
+
+	in_flight = (int)txq->q_pidx_info.pidx - txq->wb_status->cidx;
+	if (in_flight < 0)
+		in_flight += txq->nb_tx_desc - 1;
+
+	/* one slot stays empty so that the PIDX never reaches the CIDX */
+	if (offset + in_flight >= txq->nb_tx_desc - 2)
+		return RTE_ETH_TX_DESC_FULL;
+
+	return RTE_ETH_TX_DESC_DONE;
+}
@@ -0,0 +1,432 @@
+/*-
+ * BSD LICENSE
+ *
+ * Copyright(c) 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <rte_mbuf.h>
+#include <rte_cpuflags.h>
+#include <rte_vect.h>
+#include "qdma.h"
+#include "qdma_access.h"
+#include "qdma_rxtx.h"
+
+/* Largest number of completion entries decoded in one iteration */
+#define QDMA_RX_VEC_MAX_BATCH	(8)
+
+typedef uint16_t (*qdma_rx_vec_decode_t)(struct qdma_rx_queue *rxq,
+		uint16_t cmpt_tail, uint16_t nb_entries, uint32_t *pkt_len);
+
+/**
+ * Fill the byte offsets of up to QDMA_RX_VEC_MAX_BATCH completion entries
+ * starting at cmpt_tail, following the ring wrap-around.
+ */
+static inline void qdma_rx_vec_cmpt_offsets(struct qdma_rx_queue *rxq,
+		uint16_t cmpt_tail, uint16_t batch, int32_t *offset)
+{
+	uint16_t i;
+
+	for (i = 0; i < batch; i++) {
+		offset[i] = (int32_t)cmpt_tail * rxq->cmpt_desc_len;
+		cmpt_tail++;
+		if (unlikely(cmpt_tail >= (rxq->nb_rx_cmpt_desc - 1)))
+			cmpt_tail -= (rxq->nb_rx_cmpt_desc - 1);
+	}
+}
+
+/**
+ * Decode 4 completion entries with SSE.
+ *
+ * @return
+ *   Number of leading entries (<= nb_entries) that describe an error free,
+ *   single segment packet. Their lengths are returned in pkt_len.
+ */
+static uint16_t qdma_rx_vec_decode_sse(struct qdma_rx_queue *rxq,
+		uint16_t cmpt_tail, uint16_t nb_entries, uint32_t *pkt_len)
+{
+	const uint8_t *cmpt = (const uint8_t *)rxq->cmpt_ring;
+	int32_t off[4];
+	__m128i hdr, good, len, bad;
+	uint32_t mask;
+
+	qdma_rx_vec_cmpt_offsets(rxq, cmpt_tail, 4, off);
+	hdr = _mm_set_epi32(*(const volatile int32_t *)(cmpt + off[3]),
+			*(const volatile int32_t *)(cmpt + off[2]),
+			*(const volatile int32_t *)(cmpt + off[1]),
+			*(const volatile int32_t *)(cmpt + off[0]));
+
+	/* entry must have consumed a C2H descriptor without error */
+	good = _mm_cmpeq_epi32(_mm_and_si128(hdr,
+			_mm_set1_epi32(QDMA_UL_ST_CMPT_ERR_F |
+				QDMA_UL_ST_CMPT_DESC_USED_F)),
+			_mm_set1_epi32(QDMA_UL_ST_CMPT_DESC_USED_F));
+	len = _mm_and_si128(_mm_srli_epi32(hdr, QDMA_UL_ST_CMPT_LEN_SHIFT),
+			_mm_set1_epi32(QDMA_UL_ST_CMPT_LEN_MASK));
+	/* zero length or multi segment packets are left to the scalar path */
+	bad = _mm_or_si128(_mm_cmpeq_epi32(len, _mm_setzero_si128()),
+			_mm_cmpgt_epi32(len, _mm_set1_epi32(rxq->rx_buff_size)));
+	bad = _mm_or_si128(bad, _mm_andnot_si128(good, _mm_set1_epi32(-1)));
+
+	_mm_storeu_si128((__m128i *)pkt_len, len);
+	mask = _mm_movemask_ps(_mm_castsi128_ps(bad));
+	mask |= ~((1U << nb_entries) - 1);
+
+	return __builtin_ctz(mask);
+}
+
+/**
+ * Decode 8 completion entries with AVX2, see qdma_rx_vec_decode_sse().
+ */
+static __attribute__((target("avx2"))) uint16_t
+qdma_rx_vec_decode_avx2(struct qdma_rx_queue *rxq, uint16_t cmpt_tail,
+		uint16_t nb_entries, uint32_t *pkt_len)
+{
+	int32_t off[8];
+	__m256i hdr, good, len, bad;
+	uint32_t mask;
+
+	qdma_rx_vec_cmpt_offsets(rxq, cmpt_tail, 8, off);
+	hdr = _mm256_i32gather_epi32((const int *)rxq->cmpt_ring,
+			_mm256_loadu_si256((const __m256i *)off), 1);
+
+	good = _mm256_cmpeq_epi32(_mm256_and_si256(hdr,
+			_mm256_set1_epi32(QDMA_UL_ST_CMPT_ERR_F |
+				QDMA_UL_ST_CMPT_DESC_USED_F)),
+			_mm256_set1_epi32(QDMA_UL_ST_CMPT_DESC_USED_F));
+	len = _mm256_and_si256(_mm256_srli_epi32(hdr,
+				QDMA_UL_ST_CMPT_LEN_SHIFT),
+			_mm256_set1_epi32(QDMA_UL_ST_CMPT_LEN_MASK));
+	bad = _mm256_or_si256(_mm256_cmpeq_epi32(len, _mm256_setzero_si256()),
+			_mm256_cmpgt_epi32(len,
+				_mm256_set1_epi32(rxq->rx_buff_size)));
+	bad = _mm256_or_si256(bad,
+			_mm256_andnot_si256(good, _mm256_set1_epi32(-1)));
+
+	_mm256_storeu_si256((__m256i *)pkt_len, len);
+	mask = _mm256_movemask_ps(_mm256_castsi256_ps(bad));
+	mask |= ~((1U << nb_entries) - 1);
+
+	return __builtin_ctz(mask);
+}
+
+/**
+ * Select the vector Rx path for a queue and precompute the mbuf rearm
+ * data. Queues which need per-entry processing stay on the scalar path.
+ *
+ * @param rxq
+ *   Pointer to Rx queue structure.
+ */
+void qdma_rx_vec_setup(struct qdma_rx_queue *rxq)
+{
+	struct rte_mbuf mb_def = { .buf_addr = 0 };
+	uintptr_t p;
+
+	RTE_BUILD_BUG_ON(offsetof(struct rte_mbuf, ol_flags) !=
+			offsetof(struct rte_mbuf, rearm_data) + 8);
+	RTE_BUILD_BUG_ON(offsetof(struct rte_mbuf, pkt_len) !=
+			offsetof(struct rte_mbuf, rx_descriptor_fields1) + 4);
+	RTE_BUILD_BUG_ON(offsetof(struct rte_mbuf, data_len) !=
+			offsetof(struct rte_mbuf, rx_descriptor_fields1) + 8);
+	RTE_BUILD_BUG_ON(offsetof(struct rte_mbuf, hash) !=
+			offsetof(struct rte_mbuf, rx_descriptor_fields1) + 12);
+
+	rxq->rx_vec_path = QDMA_RX_VEC_NONE;
+	if (!rxq->st_mode || rxq->dump_immediate_data || rxq->ext_buf)
+		return;
+	/* CMPT user fields are only copied by the scalar path */
+	if (rxq->cmpt_ts_off >= 0 || rxq->cmpt_meta_off >= 0)
+		return;
+#ifdef TEST_64B_DESC_BYPASS
+	if (rxq->en_bypass && qmda_get_desc_sz_idx(rxq->bypass_desc_sz) ==
+			SW_DESC_CNTXT_64B_BYPASS_DMA)
+		return;
+#endif
+
+	mb_def.nb_segs = 1;
+	mb_def.data_off = RTE_PKTMBUF_HEADROOM;
+	mb_def.port = rxq->port_id;
+	rte_mbuf_refcnt_set(&mb_def, 1);
+
+	/* prevent compiler reordering: rearm_data covers previous fields */
+	rte_compiler_barrier();
+	p = (uintptr_t)&mb_def.rearm_data;
+	rxq->mbuf_initializer = *(uint64_t *)p;
+
+	if (rte_cpu_get_flag_enabled(RTE_CPUFLAG_AVX2))
+		rxq->rx_vec_path = QDMA_RX_VEC_AVX2;
+	else
+		rxq->rx_vec_path = QDMA_RX_VEC_SSE;
+
+	PMD_DRV_LOG(INFO, "Rx queue %d uses %s vector path\n", rxq->queue_id,
+			(rxq->rx_vec_path == QDMA_RX_VEC_AVX2) ? "AVX2" : "SSE");
+}
+
+/**
+ * Vector ST receive burst. Single segment packets are taken several
+ * completion entries at a time; on the first entry that needs special
+ * handling (error, zero length or multi segment) the remainder of the
+ * burst is handed to qdma_recv_pkts_st(), which also writes the CIDX
+ * of the entries taken here.
+ *
+ * @param rxq
+ *   Pointer to Rx queue structure.
+ * @param[out] rx_pkts
+ *   Array to store received packets.
+ * @param nb_pkts
+ *   Maximum number of packets in array.
+ *
+ * @return
+ *   Number of packets successfully received (<= nb_pkts).
+ */
+uint16_t qdma_recv_pkts_st_vec(struct qdma_rx_queue *rxq,
+			struct rte_mbuf **rx_pkts, uint16_t nb_pkts)
+{
+	qdma_rx_vec_decode_t decode;
+	uint32_t pkt_len[QDMA_RX_VEC_MAX_BATCH];
+	uint16_t batch, nb_entries, nb_good;
+	uint16_t rx_cmpt_tail, cmpt_pidx, id;
+	uint16_t nb_pkts_avail = 0, nb_rx = 0, i;
+	uint64_t nb_bytes = 0;
+	struct rte_mbuf *mb;
+	__m128i rearm;
+
+	if (unlikely(rxq->err))
+		return 0;
+
+	/* drain of a stopped queue is handled by the scalar path */
+	if (unlikely(rxq->status != RTE_ETH_QUEUE_STATE_STARTED))
+		return qdma_recv_pkts_st(rxq, rx_pkts, nb_pkts, 0);
+
+	rx_cmpt_tail = rxq->cmpt_cidx_info.wrb_cidx;
+	cmpt_pidx = rxq->wb_status->pidx;
+
+	if (rx_cmpt_tail < cmpt_pidx)
+		nb_pkts_avail = cmpt_pidx - rx_cmpt_tail;
+	else if (rx_cmpt_tail > cmpt_pidx)
+		nb_pkts_avail = rxq->nb_rx_cmpt_desc - 1 - rx_cmpt_tail +
+				cmpt_pidx;
+
+	if (nb_pkts_avail == 0 || nb_pkts == 0)
+		return 0;
+
+	if (nb_pkts > nb_pkts_avail)
+		nb_pkts = nb_pkts_avail;
+
+	if (rxq->rx_vec_path == QDMA_RX_VEC_AVX2) {
+		decode = qdma_rx_vec_decode_avx2;
+		batch = 8;
+	} else {
+		decode = qdma_rx_vec_decode_sse;
+		batch = 4;
+	}
+
+	/* Make sure reads to CMPT ring are synchronized before
+	 * accessing the ring
+	 */
+	rte_rmb();
+
+	/* rearm_data and ol_flags are adjacent, set both in one store */
+	rearm = _mm_set_epi64x(0, rxq->mbuf_initializer);
+	id = rxq->rx_tail;
+	while (nb_rx < nb_pkts) {
+		nb_entries = RTE_MIN(batch, nb_pkts - nb_rx);
+		nb_good = decode(rxq, rx_cmpt_tail, nb_entries, pkt_len);
+
+		for (i = 0; i < nb_good; i++) {
+			mb = rxq->sw_ring[id];
+			rxq->sw_ring[id++] = NULL;
+			if (unlikely(id >= (rxq->nb_rx_desc - 1)))
+				id -= (rxq->nb_rx_desc - 1);
+
+			/* mbufs come from the pool with next == NULL */
+			_mm_storeu_si128((__m128i *)&mb->rearm_data, rearm);
+			/* packet_type, pkt_len, data_len/vlan_tci, hash.rss */
+			_mm_storeu_si128((__m128i *)&mb->rx_descriptor_fields1,
+					_mm_set_epi32(0, pkt_len[i],
+						pkt_len[i], 0));
+			nb_bytes += pkt_len[i];
+			rx_pkts[nb_rx + i] = mb;
+		}
+
+		nb_rx += nb_good;
+		rx_cmpt_tail += nb_good;
+		if (rx_cmpt_tail >= (rxq->nb_rx_cmpt_desc - 1))
+			rx_cmpt_tail -= (rxq->nb_rx_cmpt_desc - 1);
+
+		if (nb_good < nb_entries)
+			break;
+	}
+
+	rxq->stats.pkts += nb_rx;
+	rxq->stats.bytes += nb_bytes;
+	rxq->cmpt_cidx_info.wrb_cidx = rx_cmpt_tail;
+	rxq->rx_tail = id;
+
+	/* The scalar path takes over from the entry that stopped the
+	 * vector loop and writes the CIDX and PIDX for both
+	 */
+	if (nb_rx < nb_pkts)
+		return nb_rx + qdma_recv_pkts_st(rxq, rx_pkts + nb_rx,
+				nb_pkts - nb_rx, nb_rx);
+
+	/* Update the CMPT CIDX */
+	qdma_trace_rx_cmpt_batch(rxq, nb_rx);
+	qdma_rxq_cmpt_cidx_db(rxq);
+	rxq->xstats.cidx_updates++;
+
+	qdma_rx_refill_st(rxq);
+
+	return nb_rx;
+}
+
+/**
+ * Enable the vector Tx path on a streaming queue that uses the internal
+ * descriptor format and does not need to send chained mbufs.
+ *
+ * @param txq
+ *   Pointer to Tx queue structure.
+ */
+void qdma_tx_vec_setup(struct qdma_tx_queue *txq)
+{
+	RTE_BUILD_BUG_ON(sizeof(struct qdma_ul_st_h2c_desc) != 16);
+	RTE_BUILD_BUG_ON(offsetof(struct qdma_ul_st_h2c_desc, pld_len) != 2);
+	RTE_BUILD_BUG_ON(offsetof(struct qdma_ul_st_h2c_desc, len) != 4);
+	RTE_BUILD_BUG_ON(offsetof(struct qdma_ul_st_h2c_desc, src_addr) != 8);
+
+	txq->tx_vec_en = 0;
+	if (!txq->st_mode || txq->en_bypass)
+		return;
+	if (txq->offloads & DEV_TX_OFFLOAD_MULTI_SEGS)
+		return;
+
+	txq->tx_vec_en = 1;
+	PMD_DRV_LOG(INFO, "Tx queue %d uses SSE vector path\n", txq->queue_id);
+}
+
+/* Same descriptor as qdma_ul_update_st_h2c_desc() for one segment */
+static inline void qdma_tx_vec_fill_desc(struct qdma_ul_st_h2c_desc *desc,
+		struct rte_mbuf *mb)
+{
+	uint64_t len = rte_pktmbuf_data_len(mb);
+
+	/* cdh_flags = 0, pld_len = len, len = len, flags = 0, src_addr */
+	_mm_store_si128((__m128i *)desc,
+			_mm_set_epi64x(mb->buf_physaddr + mb->data_off,
+				(len << 16) | (len << 32)));
+}
+
+/**
+ * Vector ST transmit burst for single segment mbufs. Descriptors are
+ * written four at a time; stats and the PIDX are updated once per burst.
+ *
+ * @param txq
+ *   Pointer to Tx queue structure.
+ * @param[in] tx_pkts
+ *   Packets to transmit.
+ * @param nb_pkts
+ *   Number of packets in array.
+ *
+ * @return
+ *   Number of packets successfully transmitted (<= nb_pkts).
+ */
+uint16_t qdma_xmit_pkts_st_vec(struct qdma_tx_queue *txq,
+			struct rte_mbuf **tx_pkts, uint16_t nb_pkts)
+{
+	struct qdma_ul_st_h2c_desc *tx_ring =
+			(struct qdma_ul_st_h2c_desc *)txq->tx_ring;
+	uint16_t nb_desc = txq->nb_tx_desc - 1;
+	struct rte_mbuf **pkts;
+	uint16_t id, cidx, nb_tx, n, i;
+	uint64_t nb_bytes = 0;
+	int avail, in_use;
+
+	id = txq->q_pidx_info.pidx;
+	cidx = txq->wb_status->cidx;
+
+	/* Free transmitted mbufs back to pool */
+	reclaim_tx_mbuf(txq, cidx);
+
+	in_use = (int)id - txq->tx_fl_tail;
+	if (in_use < 0)
+		in_use += nb_desc;
+
+	/* Keep one descriptor unused so that a full ring is
+	 * distinguishable from an empty one
+	 */
+	avail = txq->nb_tx_desc - 2 - in_use;
+	if (avail <= 0 || nb_pkts == 0) {
+		if (avail <= 0) {
+			qdma_trace_tx_queue_full(txq, in_use);
+			txq->xstats.queue_full++;
+		}
+		qdma_tx_pidx_update_st(txq, 0);
+		return 0;
+	}
+
+	if (nb_pkts > avail)
+		nb_pkts = avail;
+
+	for (nb_tx = 0; nb_tx < nb_pkts; nb_tx += n) {
+		/* contiguous run up to the end of the ring */
+		n = RTE_MIN(nb_pkts - nb_tx, nb_desc - id);
+		pkts = &tx_pkts[nb_tx];
+
+		for (i = 0; i + 4 <= n; i += 4) {
+			qdma_tx_vec_fill_desc(&tx_ring[id + i], pkts[i]);
+			qdma_tx_vec_fill_desc(&tx_ring[id + i + 1], pkts[i + 1]);
+			qdma_tx_vec_fill_desc(&tx_ring[id + i + 2], pkts[i + 2]);
+			qdma_tx_vec_fill_desc(&tx_ring[id + i + 3], pkts[i + 3]);
+			_mm_storeu_si128((__m128i *)&txq->sw_ring[id + i],
+				_mm_loadu_si128((const __m128i *)&pkts[i]));
+			_mm_storeu_si128((__m128i *)&txq->sw_ring[id + i + 2],
+				_mm_loadu_si128((const __m128i *)&pkts[i + 2]));
+			nb_bytes += rte_pktmbuf_data_len(pkts[i]) +
+				rte_pktmbuf_data_len(pkts[i + 1]) +
+				rte_pktmbuf_data_len(pkts[i + 2]) +
+				rte_pktmbuf_data_len(pkts[i + 3]);
+		}
+		for (; i < n; i++) {
+			qdma_tx_vec_fill_desc(&tx_ring[id + i], pkts[i]);
+			txq->sw_ring[id + i] = pkts[i];
+			nb_bytes += rte_pktmbuf_data_len(pkts[i]);
+		}
+
+		id += n;
+		if (id >= nb_desc)
+			id -= nb_desc;
+	}
+
+	txq->q_pidx_info.pidx = id;
+	txq->stats.pkts += nb_pkts;
+	txq->stats.bytes += nb_bytes;
+
+	qdma_tx_pidx_update_st(txq, nb_pkts);
+
+	return nb_pkts;
+}
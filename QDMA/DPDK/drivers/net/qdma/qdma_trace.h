@@ -0,0 +1,105 @@
+/*-
+ * BSD LICENSE
+ *
+ * Copyright(c) 2019 Xilinx, Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __QDMA_TRACE_H__
+#define __QDMA_TRACE_H__
+
+/*
+ * Data path tracepoints.
+ *
+ * DPDK 18.11 has no rte_trace, the points are built in with QDMA_TRACE=1
+ * on the make command line and compile to nothing otherwise. Built in,
+ * each point is a DEBUG record of the pmd.net.qdma.trace log type
+ * stamped with the TSC, enabled per run with
+ * --log-level=pmd.net.qdma.trace,8. A disabled point costs one level
+ * check.
+ */
+
+#ifdef QDMA_TRACE
+#include <inttypes.h>
+#include <rte_branch_prediction.h>
+#include <rte_cycles.h>
+#include <rte_log.h>
+
+extern int qdma_trace_logtype;
+
+#define QDMA_TRACE_POINT(name, fmt, args...) do { \
+	if (unlikely(rte_log_get_level(qdma_trace_logtype) >= \
+			RTE_LOG_DEBUG)) \
+		rte_log(RTE_LOG_DEBUG, qdma_trace_logtype, \
+			"%" PRIu64 " qdma." #name ": " fmt "\n", \
+			rte_rdtsc(), ## args); \
+} while (0)
+#else
+#define QDMA_TRACE_POINT(name, fmt, args...) do { } while (0)
+#endif
+
+#define QDMA_TRACE_Q(name, q, fmt, args...) \
+	QDMA_TRACE_POINT(name, "port %u qid %u " fmt, \
+		(unsigned int)(q)->port_id, (unsigned int)(q)->queue_id, \
+		## args)
+
+/* Burst entry with the requested and exit with the returned count */
+#define qdma_trace_rx_burst_entry(rxq, nb) \
+	QDMA_TRACE_Q(rx_burst_entry, rxq, "nb_pkts %u", (unsigned int)(nb))
+#define qdma_trace_rx_burst_exit(rxq, nb) \
+	QDMA_TRACE_Q(rx_burst_exit, rxq, "nb_rx %u", (unsigned int)(nb))
+#define qdma_trace_tx_burst_entry(txq, nb) \
+	QDMA_TRACE_Q(tx_burst_entry, txq, "nb_pkts %u", (unsigned int)(nb))
+#define qdma_trace_tx_burst_exit(txq, nb) \
+	QDMA_TRACE_Q(tx_burst_exit, txq, "nb_tx %u", (unsigned int)(nb))
+
+/* CMPT entries consumed by one CIDX update */
+#define qdma_trace_rx_cmpt_batch(rxq, nb) \
+	QDMA_TRACE_Q(rx_cmpt_batch, rxq, "nb_entries %u", (unsigned int)(nb))
+
+/* C2H descriptors posted by one refill */
+#define qdma_trace_rx_refill(rxq, nb) \
+	QDMA_TRACE_Q(rx_refill, rxq, "nb_desc %u", (unsigned int)(nb))
+
+/* Doorbell writes with the value of the index */
+#define qdma_trace_rx_pidx_db(rxq, pidx) \
+	QDMA_TRACE_Q(rx_pidx_db, rxq, "pidx %u", (unsigned int)(pidx))
+#define qdma_trace_rx_cmpt_cidx_db(rxq, cidx) \
+	QDMA_TRACE_Q(rx_cmpt_cidx_db, rxq, "cidx %u", (unsigned int)(cidx))
+#define qdma_trace_tx_pidx_db(txq, pidx) \
+	QDMA_TRACE_Q(tx_pidx_db, txq, "pidx %u", (unsigned int)(pidx))
+
+/* H2C descriptors whose mbufs went back to the pool */
+#define qdma_trace_tx_reclaim(txq, nb) \
+	QDMA_TRACE_Q(tx_reclaim, txq, "nb_desc %u", (unsigned int)(nb))
+
+/* Tx burst refused for lack of descriptors */
+#define qdma_trace_tx_queue_full(txq, in_use) \
+	QDMA_TRACE_Q(tx_queue_full, txq, "in_use %u", (unsigned int)(in_use))
+
+#endif /* ifndef __QDMA_TRACE_H__ */
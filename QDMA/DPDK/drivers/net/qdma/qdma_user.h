@@ -75,6 +75,15 @@ struct __attribute__ ((packed)) qdma_ul_st_cmpt_ring
 						*/
 };
 
+/* Layout of the first 32-bit word of qdma_ul_st_cmpt_ring, used by the
+ * vector Rx path to decode several completion entries at once
+ */
+#define QDMA_UL_ST_CMPT_COLOR_F	(1 << 1)
+#define QDMA_UL_ST_CMPT_ERR_F		(1 << 2)
+#define QDMA_UL_ST_CMPT_DESC_USED_F	(1 << 3)
+#define QDMA_UL_ST_CMPT_LEN_SHIFT	(4)
+#define QDMA_UL_ST_CMPT_LEN_MASK	(0xFFFF)
+
 
  /**
   * Completion entry structure
@@ -259,6 +259,11 @@ static int qdma_ethdev_online(struct rte_eth_dev *dev)
 		PMD_DRV_LOG(ERR, "%x, failed to get dev info %d.\n",
 				qdma_dev->func_id, rv);
 	else {
+		/* an older PF would leave a batched context write
+		 * unanswered until the mailbox timeout
+		 */
+		qdma_dev->qctxt_batch_dis = !(qdma_mbox_vf_hello_flags_get(
+				m->raw_data) & MBOX_HELLO_F_QCTXT_WRT_BATCH);
 		qdma_mbox_msg_free(m);
 	}
 	return rv;
@@ -338,22 +343,21 @@ err_out:
 	return rv;
 }
 
-static int qdma_rxq_context_setup(struct rte_eth_dev *dev, uint16_t qid)
+static int qdma_rxq_context_conf(struct rte_eth_dev *dev, uint16_t qid,
+				 struct mbox_qctxt_wrt_conf *conf)
 {
 	struct qdma_pci_dev *qdma_dev = dev->data->dev_private;
-	uint32_t qid_hw;
-	struct qdma_mbox_msg *m = qdma_mbox_msg_alloc();
-	struct mbox_descq_conf descq_conf;
-	int rv, bypass_desc_sz_idx;
+	struct mbox_descq_conf *descq_conf = &conf->descq_conf;
+	int bypass_desc_sz_idx;
 	struct qdma_rx_queue *rxq;
 	uint8_t cmpt_desc_fmt;
-	enum mbox_cmpt_ctxt_type cmpt_ctxt_type = QDMA_MBOX_CMPT_CTXT_NONE;
 
-	if (!m)
-		return -ENOMEM;
-	memset(&descq_conf, 0, sizeof(struct mbox_descq_conf));
+	memset(conf, 0, sizeof(struct mbox_qctxt_wrt_conf));
 	rxq = (struct qdma_rx_queue *)dev->data->rx_queues[qid];
-	qid_hw =  qdma_dev->queue_base + rxq->queue_id;
+	conf->qid_hw = qdma_dev->queue_base + rxq->queue_id;
+	conf->st = rxq->st_mode;
+	conf->c2h = 1;
+	conf->cmpt_ctxt_type = QDMA_MBOX_CMPT_CTXT_NONE;
 
 	switch (rxq->cmpt_desc_len) {
 	case RTE_PMD_QDMA_CMPT_DESC_LEN_8B:
@@ -377,111 +381,111 @@ static int qdma_rxq_context_setup(struct rte_eth_dev *dev, uint16_t qid)
 		cmpt_desc_fmt = CMPT_CNTXT_DESC_SIZE_8B;
 		break;
 	}
-	descq_conf.ring_bs_addr = rxq->rx_mz->phys_addr;
-	descq_conf.en_bypass = rxq->en_bypass;
-	descq_conf.irq_arm = 0;
-	descq_conf.at = 0;
-	descq_conf.wbk_en = 1;
-	descq_conf.irq_en = 0;
+	descq_conf->ring_bs_addr = rxq->rx_mz->phys_addr;
+	descq_conf->en_bypass = rxq->en_bypass;
+	descq_conf->irq_arm = 0;
+	descq_conf->at = 0;
+	descq_conf->wbk_en = 1;
+	descq_conf->irq_en = 0;
 
 	bypass_desc_sz_idx = qmda_get_desc_sz_idx(rxq->bypass_desc_sz);
 
 	if (!rxq->st_mode) {/* mm c2h */
-		descq_conf.desc_sz = SW_DESC_CNTXT_MEMORY_MAP_DMA;
-		descq_conf.wbi_intvl_en = 1;
-		descq_conf.wbi_chk = 1;
+		descq_conf->desc_sz = SW_DESC_CNTXT_MEMORY_MAP_DMA;
+		descq_conf->wbi_intvl_en = 1;
+		descq_conf->wbi_chk = 1;
+		descq_conf->irq_en = (rxq->intr_vec) ? 1 : 0;
 	} else {/* st c2h*/
-		descq_conf.desc_sz = SW_DESC_CNTXT_C2H_STREAM_DMA;
-		descq_conf.forced_en = 1;
-		descq_conf.cmpt_ring_bs_addr = rxq->rx_cmpt_mz->phys_addr;
-		descq_conf.cmpt_desc_sz = cmpt_desc_fmt;
-		descq_conf.triggermode = rxq->triggermode;
-
-		descq_conf.cmpt_color = CMPT_DEFAULT_COLOR_BIT;
-		descq_conf.cmpt_full_upd = 0;
-		descq_conf.cnt_thres =
+		descq_conf->desc_sz = SW_DESC_CNTXT_C2H_STREAM_DMA;
+		descq_conf->forced_en = 1;
+		descq_conf->cmpt_ring_bs_addr = rxq->rx_cmpt_mz->phys_addr;
+		descq_conf->cmpt_desc_sz = cmpt_desc_fmt;
+		descq_conf->triggermode = rxq->triggermode;
+
+		descq_conf->cmpt_color = CMPT_DEFAULT_COLOR_BIT;
+		descq_conf->cmpt_full_upd = 0;
+		descq_conf->cnt_thres =
 				qdma_dev->g_c2h_cnt_th[rxq->threshidx];
-		descq_conf.timer_thres =
+		descq_conf->timer_thres =
 				qdma_dev->g_c2h_timer_cnt[rxq->timeridx];
-		descq_conf.cmpt_ringsz =
+		descq_conf->cmpt_ringsz =
 				qdma_dev->g_ring_sz[rxq->cmpt_ringszidx] - 1;
-		descq_conf.bufsz = qdma_dev->g_c2h_buf_sz[rxq->buffszidx];
-		descq_conf.cmpt_int_en = 0;
-		descq_conf.cmpl_stat_en = rxq->st_mode;
-		descq_conf.pfch_en = rxq->en_prefetch;
-		descq_conf.en_bypass_prefetch = rxq->en_bypass_prefetch;
+		descq_conf->bufsz = qdma_dev->g_c2h_buf_sz[rxq->buffszidx];
+		descq_conf->cmpt_int_en = (rxq->intr_vec) ? 1 : 0;
+		descq_conf->cmpl_stat_en = rxq->st_mode;
+		descq_conf->pfch_en = rxq->en_prefetch;
+		descq_conf->en_bypass_prefetch = rxq->en_bypass_prefetch;
 		if (qdma_dev->dev_cap.cmpt_ovf_chk_dis)
-			descq_conf.dis_overflow_check = rxq->dis_overflow_check;
+			descq_conf->dis_overflow_check =
+					rxq->dis_overflow_check;
 
-		cmpt_ctxt_type = QDMA_MBOX_CMPT_WITH_ST;
+		conf->cmpt_ctxt_type = QDMA_MBOX_CMPT_WITH_ST;
 	}
 
 	if (rxq->en_bypass &&
 			(rxq->bypass_desc_sz != 0))
-		descq_conf.desc_sz = bypass_desc_sz_idx;
-
-	descq_conf.func_id = rxq->func_id;
-	descq_conf.ringsz = qdma_dev->g_ring_sz[rxq->ringszidx] - 1;
+		descq_conf->desc_sz = bypass_desc_sz_idx;
 
-	qdma_mbox_compose_vf_qctxt_write(rxq->func_id, qid_hw, rxq->st_mode, 1,
-					 cmpt_ctxt_type,
-					 &descq_conf, m->raw_data);
+	descq_conf->func_id = rxq->func_id;
+	descq_conf->intr_id = rxq->intr_vec;
+	descq_conf->ringsz = qdma_dev->g_ring_sz[rxq->ringszidx] - 1;
 
-	rv = qdma_mbox_msg_send(dev, m, MBOX_OP_RSP_TIMEOUT);
-	if (rv < 0) {
-		PMD_DRV_LOG(ERR, "%x, qid_hw 0x%x, mbox failed %d.\n",
-			qdma_dev->func_id, qid_hw, rv);
-		goto err_out;
-	}
-
-	rv = qdma_mbox_vf_response_status(m->raw_data);
-
-err_out:
-	qdma_mbox_msg_free(m);
-	return rv;
+	return 0;
 }
 
-static int qdma_txq_context_setup(struct rte_eth_dev *dev, uint16_t qid)
+static void qdma_txq_context_conf(struct rte_eth_dev *dev, uint16_t qid,
+				  struct mbox_qctxt_wrt_conf *conf)
 {
 	struct qdma_pci_dev *qdma_dev = dev->data->dev_private;
-	struct qdma_mbox_msg *m = qdma_mbox_msg_alloc();
-	struct mbox_descq_conf descq_conf;
-	int rv, bypass_desc_sz_idx;
+	struct mbox_descq_conf *descq_conf = &conf->descq_conf;
+	int bypass_desc_sz_idx;
 	struct qdma_tx_queue *txq;
-	uint32_t qid_hw;
 
-	if (!m)
-		return -ENOMEM;
-	memset(&descq_conf, 0, sizeof(struct mbox_descq_conf));
+	memset(conf, 0, sizeof(struct mbox_qctxt_wrt_conf));
 	txq = (struct qdma_tx_queue *)dev->data->tx_queues[qid];
-	qid_hw =  qdma_dev->queue_base + txq->queue_id;
-	descq_conf.ring_bs_addr = txq->tx_mz->phys_addr;
-	descq_conf.en_bypass = txq->en_bypass;
-	descq_conf.wbi_intvl_en = 1;
-	descq_conf.wbi_chk = 1;
-	descq_conf.wbk_en = 1;
+	conf->qid_hw = qdma_dev->queue_base + txq->queue_id;
+	conf->st = txq->st_mode;
+	conf->c2h = 0;
+	conf->cmpt_ctxt_type = QDMA_MBOX_CMPT_CTXT_NONE;
+	descq_conf->ring_bs_addr = txq->tx_mz->phys_addr;
+	descq_conf->en_bypass = txq->en_bypass;
+	descq_conf->wbi_intvl_en = 1;
+	descq_conf->wbi_chk = 1;
+	descq_conf->wbk_en = 1;
 
 	bypass_desc_sz_idx = qmda_get_desc_sz_idx(txq->bypass_desc_sz);
 
 	if (!txq->st_mode) /* mm h2c */
-		descq_conf.desc_sz = SW_DESC_CNTXT_MEMORY_MAP_DMA;
+		descq_conf->desc_sz = SW_DESC_CNTXT_MEMORY_MAP_DMA;
 	else /* st h2c */
-		descq_conf.desc_sz = SW_DESC_CNTXT_H2C_STREAM_DMA;
-	descq_conf.func_id = txq->func_id;
-	descq_conf.ringsz = qdma_dev->g_ring_sz[txq->ringszidx] - 1;
+		descq_conf->desc_sz = SW_DESC_CNTXT_H2C_STREAM_DMA;
+	descq_conf->func_id = txq->func_id;
+	descq_conf->ringsz = qdma_dev->g_ring_sz[txq->ringszidx] - 1;
 
 	if (txq->en_bypass &&
 		(txq->bypass_desc_sz != 0))
-		descq_conf.desc_sz = bypass_desc_sz_idx;
+		descq_conf->desc_sz = bypass_desc_sz_idx;
+}
+
+static int qdma_queue_context_write(struct rte_eth_dev *dev,
+				    struct mbox_qctxt_wrt_conf *conf)
+{
+	struct qdma_pci_dev *qdma_dev = dev->data->dev_private;
+	struct qdma_mbox_msg *m = qdma_mbox_msg_alloc();
+	int rv;
 
-	qdma_mbox_compose_vf_qctxt_write(txq->func_id, qid_hw, txq->st_mode, 0,
-					 QDMA_MBOX_CMPT_CTXT_NONE,
-					 &descq_conf, m->raw_data);
+	if (!m)
+		return -ENOMEM;
+
+	qdma_mbox_compose_vf_qctxt_write(conf->descq_conf.func_id,
+					 conf->qid_hw, conf->st, conf->c2h,
+					 conf->cmpt_ctxt_type,
+					 &conf->descq_conf, m->raw_data);
 
 	rv = qdma_mbox_msg_send(dev, m, MBOX_OP_RSP_TIMEOUT);
 	if (rv < 0) {
 		PMD_DRV_LOG(ERR, "%x, qid_hw 0x%x, mbox failed %d.\n",
-			qdma_dev->func_id, qid_hw, rv);
+			qdma_dev->func_id, conf->qid_hw, rv);
 		goto err_out;
 	}
 
@@ -492,6 +496,103 @@ err_out:
 	return rv;
 }
 
+static int qdma_rxq_context_setup(struct rte_eth_dev *dev, uint16_t qid)
+{
+	struct mbox_qctxt_wrt_conf conf;
+
+	if (qdma_rxq_context_conf(dev, qid, &conf) < 0)
+		return -1;
+
+	return qdma_queue_context_write(dev, &conf);
+}
+
+static int qdma_txq_context_setup(struct rte_eth_dev *dev, uint16_t qid)
+{
+	struct mbox_qctxt_wrt_conf conf;
+
+	qdma_txq_context_conf(dev, qid, &conf);
+
+	return qdma_queue_context_write(dev, &conf);
+}
+
+/*
+ * Program the contexts of all queues in conf[] with batched mailbox
+ * messages. All messages are posted before the first response is awaited,
+ * so the PF processes them back to back. One message per queue is used
+ * if the PF did not advertise the batched opcode in its hello response,
+ * or if a batched write fails at the mailbox level.
+ */
+static int qdma_queue_context_write_batch(struct rte_eth_dev *dev,
+					  struct mbox_qctxt_wrt_conf *conf,
+					  uint32_t nb_conf)
+{
+	struct qdma_pci_dev *qdma_dev = dev->data->dev_private;
+	uint32_t nb_msg = (nb_conf + MBOX_QCTXT_WRT_BATCH_MAX - 1) /
+			MBOX_QCTXT_WRT_BATCH_MAX;
+	struct qdma_mbox_msg **m;
+	uint32_t i, n;
+	int rv = 0, err;
+
+	if (!nb_conf)
+		return 0;
+
+	if (qdma_dev->qctxt_batch_dis)
+		goto fallback;
+
+	m = rte_zmalloc("qctxt_batch", nb_msg * sizeof(*m), 0);
+	if (!m)
+		goto fallback;
+
+	for (i = 0; i < nb_msg; i++) {
+		m[i] = qdma_mbox_msg_alloc();
+		if (!m[i]) {
+			rv = -ENOMEM;
+			goto free_msg;
+		}
+	}
+
+	for (i = 0; i < nb_msg; i++) {
+		n = RTE_MIN(nb_conf - i * MBOX_QCTXT_WRT_BATCH_MAX,
+			    (uint32_t)MBOX_QCTXT_WRT_BATCH_MAX);
+		qdma_mbox_compose_vf_qctxt_write_batch(qdma_dev->func_id, n,
+				&conf[i * MBOX_QCTXT_WRT_BATCH_MAX],
+				m[i]->raw_data);
+		qdma_mbox_msg_post(dev, m[i], MBOX_OP_RSP_TIMEOUT);
+	}
+
+	/* after the first failure only reclaim the remaining messages */
+	for (i = 0; i < nb_msg; i++) {
+		err = qdma_mbox_msg_wait(dev, m[i],
+					 rv ? 0 : MBOX_OP_RSP_TIMEOUT);
+		if (!rv && err < 0) {
+			PMD_DRV_LOG(INFO, "%x, batched context write mbox "
+				"failed %d.\n", qdma_dev->func_id, err);
+			qdma_dev->qctxt_batch_dis = 1;
+			rv = err;
+		} else if (!rv) {
+			rv = qdma_mbox_vf_response_status(m[i]->raw_data);
+		}
+	}
+
+free_msg:
+	for (i = 0; i < nb_msg && m[i]; i++)
+		qdma_mbox_msg_free(m[i]);
+	rte_free(m);
+	if (!rv)
+		return 0;
+	if (rv != -EPIPE && rv != -ENOMEM)
+		return rv;
+
+fallback:
+	for (i = 0; i < nb_conf; i++) {
+		rv = qdma_queue_context_write(dev, &conf[i]);
+		if (rv < 0)
+			return rv;
+	}
+
+	return 0;
+}
+
 static int qdma_queue_context_invalidate(struct rte_eth_dev *dev, uint32_t qid,
 				  bool st, bool c2h)
 {
@@ -525,23 +626,76 @@ err_out:
 	return rv;
 }
 
+static void qdma_vf_txq_enable(struct rte_eth_dev *dev, uint16_t qid)
+{
+	struct qdma_pci_dev *qdma_dev = dev->data->dev_private;
+	struct qdma_tx_queue *txq;
+
+	txq = (struct qdma_tx_queue *)dev->data->tx_queues[qid];
+	txq->q_pidx_info.pidx = 0;
+	qdma_dev->hw_access->qdma_queue_pidx_update(dev, qdma_dev->is_vf,
+			qid, 0, &txq->q_pidx_info);
+
+	dev->data->tx_queue_state[qid] = RTE_ETH_QUEUE_STATE_STARTED;
+	txq->status = RTE_ETH_QUEUE_STATE_STARTED;
+}
+
+static void qdma_vf_rxq_enable(struct rte_eth_dev *dev, uint16_t qid)
+{
+	struct qdma_pci_dev *qdma_dev = dev->data->dev_private;
+	struct qdma_rx_queue *rxq;
+
+	rxq = (struct qdma_rx_queue *)dev->data->rx_queues[qid];
+	if (rxq->st_mode) {
+		rxq->cmpt_cidx_info.counter_idx = rxq->threshidx;
+		rxq->cmpt_cidx_info.timer_idx = rxq->timeridx;
+		rxq->cmpt_cidx_info.trig_mode = rxq->triggermode;
+		rxq->cmpt_cidx_info.wrb_en = 1;
+		qdma_dev->hw_access->qdma_queue_cmpt_cidx_update(dev, 1,
+				qid, &rxq->cmpt_cidx_info);
+
+		rxq->q_pidx_info.pidx = (rxq->nb_rx_desc - 2);
+		qdma_dev->hw_access->qdma_queue_pidx_update(dev, 1,
+				qid, 1, &rxq->q_pidx_info);
+	}
+
+	dev->data->rx_queue_state[qid] = RTE_ETH_QUEUE_STATE_STARTED;
+	rxq->status = RTE_ETH_QUEUE_STATE_STARTED;
+}
+
 static int qdma_vf_dev_start(struct rte_eth_dev *dev)
 {
+	struct mbox_qctxt_wrt_conf *conf;
 	struct qdma_tx_queue *txq;
 	struct qdma_rx_queue *rxq;
-	uint32_t qid;
+	uint32_t qid, nb_conf = 0;
 	int err;
 
 	PMD_DRV_LOG(INFO, "qdma_dev_start: Starting\n");
-	/* prepare descriptor rings for operation */
+
+	err = qdma_dev_rx_intr_setup(dev);
+	if (err != 0)
+		return err;
+
+	conf = rte_zmalloc("qctxt_conf", sizeof(struct mbox_qctxt_wrt_conf) *
+			   (dev->data->nb_tx_queues + dev->data->nb_rx_queues),
+			   0);
+	if (!conf) {
+		qdma_dev_rx_intr_teardown(dev);
+		return -ENOMEM;
+	}
+
+	/* prepare descriptor rings for operation, the contexts of all
+	 * queues are then programmed with as few mailbox round trips
+	 * as possible
+	 */
 	for (qid = 0; qid < dev->data->nb_tx_queues; qid++) {
 		txq = (struct qdma_tx_queue *)dev->data->tx_queues[qid];
 
 		/*Deferred Queues should not start with dev_start*/
 		if (!txq->tx_deferred_start) {
-			err = qdma_vf_dev_tx_queue_start(dev, qid);
-			if (err != 0)
-				return err;
+			qdma_reset_tx_queue(txq);
+			qdma_txq_context_conf(dev, qid, &conf[nb_conf++]);
 		}
 	}
 
@@ -550,12 +704,42 @@ static int qdma_vf_dev_start(struct rte_eth_dev *dev)
 
 		/*Deferred Queues should not start with dev_start*/
 		if (!rxq->rx_deferred_start) {
-			err = qdma_vf_dev_rx_queue_start(dev, qid);
+			qdma_reset_rx_queue(rxq);
+			err = qdma_init_rx_queue(rxq);
 			if (err != 0)
-				return err;
+				goto out;
+			if (qdma_rxq_context_conf(dev, qid,
+						  &conf[nb_conf++]) < 0) {
+				err = -1;
+				goto out;
+			}
 		}
 	}
-	return 0;
+
+	err = qdma_queue_context_write_batch(dev, conf, nb_conf);
+	if (err < 0) {
+		PMD_DRV_LOG(ERR, "context_setup of %u queues failed",
+			    nb_conf);
+		goto out;
+	}
+
+	for (qid = 0; qid < dev->data->nb_tx_queues; qid++) {
+		txq = (struct qdma_tx_queue *)dev->data->tx_queues[qid];
+		if (!txq->tx_deferred_start)
+			qdma_vf_txq_enable(dev, qid);
+	}
+
+	for (qid = 0; qid < dev->data->nb_rx_queues; qid++) {
+		rxq = (struct qdma_rx_queue *)dev->data->rx_queues[qid];
+		if (!rxq->rx_deferred_start)
+			qdma_vf_rxq_enable(dev, qid);
+	}
+
+out:
+	rte_free(conf);
+	if (err < 0)
+		qdma_dev_rx_intr_teardown(dev);
+	return err;
 }
 
 static int qdma_vf_dev_link_update(struct rte_eth_dev *dev,
@@ -581,6 +765,9 @@ static void qdma_vf_dev_infos_get(__rte_unused struct rte_eth_dev *dev,
 	dev_info->min_rx_bufsize = QDMA_MIN_RXBUFF_SIZE;
 	dev_info->max_rx_pktlen = DMA_BRAM_SIZE;
 	dev_info->max_mac_addrs = 1;
+	dev_info->tx_offload_capa = QDMA_TX_OFFLOAD_CAPA;
+	dev_info->default_txconf.tx_free_thresh = DEFAULT_TX_FREE_THRESHOLD;
+	dev_info->default_rxconf.rx_free_thresh = DEFAULT_RX_FREE_THRESHOLD;
 }
 
 static void qdma_vf_dev_stop(struct rte_eth_dev *dev)
@@ -597,6 +784,8 @@ static void qdma_vf_dev_stop(struct rte_eth_dev *dev)
 		qdma_vf_dev_tx_queue_stop(dev, qid);
 	for (qid = 0; qid < dev->data->nb_rx_queues; qid++)
 		qdma_vf_dev_rx_queue_stop(dev, qid);
+
+	qdma_dev_rx_intr_teardown(dev);
 }
 
 static void qdma_vf_dev_close(struct rte_eth_dev *dev)
@@ -630,6 +819,8 @@ static void qdma_vf_dev_close(struct rte_eth_dev *dev)
 
 			if (rxq->sw_ring)
 				rte_free(rxq->sw_ring);
+			if (rxq->ext_ring)
+				rte_free(rxq->ext_ring);
 
 			if (rxq->st_mode) { /** if ST-mode **/
 				if (rxq->rx_cmpt_mz)
@@ -805,6 +996,9 @@ static int qdma_vf_dev_configure(struct rte_eth_dev *dev)
 		qdma_dev->q_info[qid].cmpt_desc_sz = qdma_dev->cmpt_desc_len;
 		qdma_dev->q_info[qid].rx_bypass_mode =
 						qdma_dev->c2h_bypass_mode;
+		qdma_dev->q_info[qid].cmpt_ts_off = RTE_PMD_QDMA_CMPT_FIELD_NONE;
+		qdma_dev->q_info[qid].cmpt_meta_off =
+						RTE_PMD_QDMA_CMPT_FIELD_NONE;
 		qdma_dev->q_info[qid].trigger_mode = qdma_dev->trigger_mode;
 		qdma_dev->q_info[qid].timer_count =
 					qdma_dev->timer_count;
@@ -831,7 +1025,6 @@ static int qdma_vf_dev_configure(struct rte_eth_dev *dev)
 
 int qdma_vf_dev_tx_queue_start(struct rte_eth_dev *dev, uint16_t qid)
 {
-	struct qdma_pci_dev *qdma_dev = dev->data->dev_private;
 	struct qdma_tx_queue *txq;
 
 	txq = (struct qdma_tx_queue *)dev->data->tx_queues[qid];
@@ -840,19 +1033,13 @@ int qdma_vf_dev_tx_queue_start(struct rte_eth_dev *dev, uint16_t qid)
 	if (qdma_txq_context_setup(dev, qid) < 0)
 		return -1;
 
-	txq->q_pidx_info.pidx = 0;
-	qdma_dev->hw_access->qdma_queue_pidx_update(dev, qdma_dev->is_vf,
-			qid, 0, &txq->q_pidx_info);
-
-	dev->data->tx_queue_state[qid] = RTE_ETH_QUEUE_STATE_STARTED;
-	txq->status = RTE_ETH_QUEUE_STATE_STARTED;
+	qdma_vf_txq_enable(dev, qid);
 
 	return 0;
 }
 
 int qdma_vf_dev_rx_queue_start(struct rte_eth_dev *dev, uint16_t qid)
 {
-	struct qdma_pci_dev *qdma_dev = dev->data->dev_private;
 	struct qdma_rx_queue *rxq;
 	int err;
 
@@ -868,21 +1055,7 @@ int qdma_vf_dev_rx_queue_start(struct rte_eth_dev *dev, uint16_t qid)
 		return -1;
 	}
 
-	if (rxq->st_mode) {
-		rxq->cmpt_cidx_info.counter_idx = rxq->threshidx;
-		rxq->cmpt_cidx_info.timer_idx = rxq->timeridx;
-		rxq->cmpt_cidx_info.trig_mode = rxq->triggermode;
-		rxq->cmpt_cidx_info.wrb_en = 1;
-		qdma_dev->hw_access->qdma_queue_cmpt_cidx_update(dev, 1,
-				qid, &rxq->cmpt_cidx_info);
-
-		rxq->q_pidx_info.pidx = (rxq->nb_rx_desc - 2);
-		qdma_dev->hw_access->qdma_queue_pidx_update(dev, 1,
-				qid, 1, &rxq->q_pidx_info);
-	}
-
-	dev->data->rx_queue_state[qid] = RTE_ETH_QUEUE_STATE_STARTED;
-	rxq->status = RTE_ETH_QUEUE_STATE_STARTED;
+	qdma_vf_rxq_enable(dev, qid);
 	return 0;
 }
 
@@ -932,6 +1105,12 @@ int qdma_vf_dev_rx_queue_stop(struct rte_eth_dev *dev, uint16_t qid)
 				rte_mempool_avail_count(rxq->mb_pool),
 				rte_mempool_in_use_count(rxq->mb_pool));
 #endif //DUMP_MEMPOOL_USAGE_STATS
+	} else {
+		/* Free buffers still posted to the MM descriptor ring */
+		for (i = 0; i < rxq->nb_rx_desc - 1; i++) {
+			rte_pktmbuf_free(rxq->sw_ring[i]);
+			rxq->sw_ring[i] = NULL;
+		}
 	}
 
 	qdma_reset_rx_queue(rxq);
@@ -948,6 +1127,8 @@ int qdma_vf_dev_tx_queue_stop(struct rte_eth_dev *dev, uint16_t qid)
 	txq = (struct qdma_tx_queue *)dev->data->tx_queues[qid];
 
 	txq->status = RTE_ETH_QUEUE_STATE_STOPPED;
+	/* Hand over descriptors still held back by doorbell coalescing */
+	qdma_tx_pidx_flush(txq);
 	/* Wait for TXQ to send out all packets. */
 	while (txq->wb_status->cidx != txq->q_pidx_info.pidx) {
 		usleep(10);
@@ -984,7 +1165,16 @@ static struct eth_dev_ops qdma_vf_eth_dev_ops = {
 	.rx_queue_stop        = qdma_vf_dev_rx_queue_stop,
 	.tx_queue_start       = qdma_vf_dev_tx_queue_start,
 	.tx_queue_stop        = qdma_vf_dev_tx_queue_stop,
+	.rx_queue_intr_enable = qdma_dev_rx_queue_intr_enable,
+	.rx_queue_intr_disable = qdma_dev_rx_queue_intr_disable,
 	.stats_get            = qdma_dev_stats_get,
+	.stats_reset          = qdma_dev_stats_reset,
+	.xstats_get           = qdma_dev_xstats_get,
+	.xstats_get_names     = qdma_dev_xstats_get_names,
+	.xstats_reset         = qdma_dev_xstats_reset,
+	.rx_queue_count       = qdma_dev_rx_queue_count,
+	.rx_descriptor_status = qdma_dev_rx_descriptor_status,
+	.tx_descriptor_status = qdma_dev_tx_descriptor_status,
 };
 
 /**
@@ -1023,7 +1213,13 @@ static int eth_qdma_vf_dev_init(struct rte_eth_dev *dev)
 	 * has already done this work.
 	 */
 	if (rte_eal_process_type() != RTE_PROC_PRIMARY) {
+		/* BARs and access layer function pointers are process local */
+		idx = qdma_proc_priv_init(dev);
+		if (idx < 0)
+			return idx;
 		dev->dev_ops = &qdma_vf_eth_dev_ops;
+		dev->rx_pkt_burst = &qdma_recv_pkts;
+		dev->tx_pkt_burst = &qdma_xmit_pkts;
 		return 0;
 	}
 
@@ -1047,6 +1243,7 @@ static int eth_qdma_vf_dev_init(struct rte_eth_dev *dev)
 	dma_priv = (struct qdma_pci_dev *)dev->data->dev_private;
 	dma_priv->func_id = 0;
 	dma_priv->is_vf = 1;
+	dma_priv->dma_device_index = pci_dev->addr.bus;
 	dma_priv->timer_count = DEFAULT_TIMER_CNT_TRIG_MODE_TIMER;
 
 	if (dma_priv->dev_cap.cmpt_trig_count_timer) {
@@ -1066,6 +1263,8 @@ static int eth_qdma_vf_dev_init(struct rte_eth_dev *dev)
 	dma_priv->cmpt_desc_len = DEFAULT_QDMA_CMPT_DESC_LEN;
 	dma_priv->c2h_bypass_mode = RTE_PMD_QDMA_RX_BYPASS_NONE;
 	dma_priv->h2c_bypass_mode = 0;
+	dma_priv->tx_pidx_batch = MIN_TX_PIDX_UPDATE_THRESHOLD;
+	dma_priv->tx_pidx_timeout = QDMA_TXQ_PIDX_UPDATE_INTERVAL;
 
 	dev->dev_ops = &qdma_vf_eth_dev_ops;
 	dev->rx_pkt_burst = &qdma_recv_pkts;
@@ -1084,7 +1283,8 @@ static int eth_qdma_vf_dev_init(struct rte_eth_dev *dev)
 	/* Store BAR address and length of Config BAR */
 	baseaddr = (uint8_t *)
 			pci_dev->mem_resource[dma_priv->config_bar_idx].addr;
-	dma_priv->bar_addr[dma_priv->config_bar_idx] = baseaddr;
+	QDMA_PROC_PRIV(dev->data->port_id)->bar_addr[dma_priv->config_bar_idx] =
+								baseaddr;
 
 	/*Assigning QDMA access layer function pointers based on the HW design*/
 	dma_priv->hw_access = rte_zmalloc("vf_hwaccess",
@@ -1114,11 +1314,12 @@ static int eth_qdma_vf_dev_init(struct rte_eth_dev *dev)
 		return -EINVAL;
 	}
 
-	/* Store BAR address and length of User BAR */
-	if (dma_priv->user_bar_idx >= 0) {
-		baseaddr = (uint8_t *)
-			     pci_dev->mem_resource[dma_priv->user_bar_idx].addr;
-		dma_priv->bar_addr[dma_priv->user_bar_idx] = baseaddr;
+	/* Store BAR addresses and the data path access layer of this process */
+	idx = qdma_proc_priv_init(dev);
+	if (idx < 0) {
+		rte_free(dma_priv->hw_access);
+		rte_free(dev->data->mac_addrs);
+		return idx;
 	}
 
 	if ((dma_priv->device_type == QDMA_DEVICE_VERSAL) &&
@@ -151,6 +151,10 @@ static int qdma_c2h_struct_dump(uint8_t port_id, uint16_t queue)
 				rx_q->en_bypass);
 		xdebug_info(dev, "\t\t dump_immediate_data :%x\n",
 				rx_q->dump_immediate_data);
+		xdebug_info(dev, "\t\t cmpt_ts_off         :%d\n",
+				rx_q->cmpt_ts_off);
+		xdebug_info(dev, "\t\t cmpt_meta_off       :%d\n",
+				rx_q->cmpt_meta_off);
 		xdebug_info(dev, "\t\t en_bypass_prefetch  :%x\n",
 				rx_q->en_bypass_prefetch);
 
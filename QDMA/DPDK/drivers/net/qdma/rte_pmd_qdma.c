@@ -44,6 +44,7 @@
 #include <rte_ethdev.h>
 #include <rte_alarm.h>
 #include <rte_cycles.h>
+#include <rte_prefetch.h>
 #include <unistd.h>
 #include <string.h>
 
@@ -423,6 +424,98 @@ int rte_pmd_qdma_set_immediate_data_state(int portid, uint32_t qid,
 	return ret;
 }
 
+/******************************************************************************/
+/**
+ *Function Name:	rte_pmd_qdma_set_cmpt_user_fields
+ *Description:		Selects the user defined bytes of the completion
+ *			entries delivered in the received mbufs, as
+ *			mbuf->timestamp and mbuf->hash.fdir.hi.
+ *
+ * @param	portid : Port ID.
+ * @param	qid : Queue ID.
+ * @param	ts_offset : Byte offset of the 64 bit timestamp,
+ *			RTE_PMD_QDMA_CMPT_FIELD_NONE to disable
+ * @param	meta_offset : Byte offset of the 32 bit metadata,
+ *			RTE_PMD_QDMA_CMPT_FIELD_NONE to disable
+ *
+ * @return	'0' on success and '< 0' on failure.
+ *
+ * @note	Application can call this API after successful
+ *		call to rte_eth_dev_configure() API. Application can
+ *		also call this API after successful call to
+ *		rte_eth_rx_queue_setup() only if rx queue is not in
+ *		start state. This API is applicable for
+ *		streaming queues only.
+ ******************************************************************************/
+int rte_pmd_qdma_set_cmpt_user_fields(int portid, uint32_t qid,
+		int8_t ts_offset, int8_t meta_offset)
+{
+	struct rte_eth_dev *dev;
+	struct qdma_pci_dev *qdma_dev;
+	struct qdma_rx_queue *rxq;
+	int ret = 0;
+
+	ret = validate_qdma_dev_info(portid, qid);
+	if (ret != QDMA_SUCCESS) {
+		PMD_DRV_LOG(ERR,
+			"QDMA device validation failed for port id %d\n",
+			portid);
+		return ret;
+	}
+	dev = &rte_eth_devices[portid];
+	qdma_dev = dev->data->dev_private;
+	if (qid >= dev->data->nb_rx_queues) {
+		PMD_DRV_LOG(ERR, "Invalid RX Queue id passed for %s,"
+				"Queue ID = %d\n", __func__, qid);
+		return -EINVAL;
+	}
+
+	if (ts_offset < RTE_PMD_QDMA_CMPT_FIELD_NONE ||
+			meta_offset < RTE_PMD_QDMA_CMPT_FIELD_NONE) {
+		PMD_DRV_LOG(ERR, "Invalid CMPT user field offset for %s, "
+				"Queue ID = %d\n", __func__, qid);
+		return -EINVAL;
+	}
+
+	if (qdma_dev->q_info[qid].queue_mode !=
+			RTE_PMD_QDMA_STREAMING_MODE) {
+		PMD_DRV_LOG(ERR, "Qid %d is not setup in ST mode\n", qid);
+		return -EINVAL;
+	}
+
+	rxq = (struct qdma_rx_queue *)dev->data->rx_queues[qid];
+	if (rxq == NULL) {
+		/* Checked against the entry size at rx queue setup */
+		qdma_dev->q_info[qid].cmpt_ts_off = ts_offset;
+		qdma_dev->q_info[qid].cmpt_meta_off = meta_offset;
+	} else if (dev->data->rx_queue_state[qid] ==
+			RTE_ETH_QUEUE_STATE_STOPPED) {
+		if (ts_offset + (int)sizeof(uint64_t) > rxq->cmpt_desc_len ||
+				meta_offset + (int)sizeof(uint32_t) >
+				rxq->cmpt_desc_len) {
+			PMD_DRV_LOG(ERR, "CMPT user field offsets %d/%d exceed "
+					"the %dB completion entry\n", ts_offset,
+					meta_offset, rxq->cmpt_desc_len);
+			return -EINVAL;
+		}
+		qdma_dev->q_info[qid].cmpt_ts_off = ts_offset;
+		qdma_dev->q_info[qid].cmpt_meta_off = meta_offset;
+		rxq->cmpt_ts_off = ts_offset;
+		rxq->cmpt_meta_off = meta_offset;
+#ifdef RTE_ARCH_X86
+		/* Fall back to the scalar path if the fields are used */
+		qdma_rx_vec_setup(rxq);
+#endif
+	} else {
+		PMD_DRV_LOG(ERR,
+			"Cannot configure when Qid %d is in start state\n",
+			qid);
+		return -EINVAL;
+	}
+
+	return ret;
+}
+
 /******************************************************************************/
 /**
  * Function Name:	rte_pmd_qdma_set_cmpt_overflow_check
@@ -802,6 +895,217 @@ int rte_pmd_qdma_set_cmpt_timer(int portid, uint32_t qid, uint32_t value)
 	return ret;
 }
 
+/* Streaming mode Rx queue of a port that is setup, NULL otherwise */
+static struct qdma_rx_queue *qdma_st_rxq_get(int portid, uint32_t qid)
+{
+	struct rte_eth_dev *dev;
+	struct qdma_pci_dev *qdma_dev;
+
+	if (validate_qdma_dev_info(portid, qid) != QDMA_SUCCESS) {
+		PMD_DRV_LOG(ERR,
+			"QDMA device validation failed for port id %d\n",
+			portid);
+		return NULL;
+	}
+	dev = &rte_eth_devices[portid];
+	qdma_dev = dev->data->dev_private;
+
+	if (qid >= dev->data->nb_rx_queues ||
+			qdma_dev->q_info[qid].queue_mode !=
+			RTE_PMD_QDMA_STREAMING_MODE ||
+			dev->data->rx_queues[qid] == NULL) {
+		PMD_DRV_LOG(ERR, "Qid %d is not a streaming mode Rx queue "
+				"that is setup\n", qid);
+		return NULL;
+	}
+
+	return (struct qdma_rx_queue *)dev->data->rx_queues[qid];
+}
+
+/******************************************************************************/
+/**
+ * Function Name:	rte_pmd_qdma_set_cmpt_moderation
+ * Description:		Changes the trigger mode, timer and counter threshold
+ *			of the completion ring of a streaming mode Rx queue,
+ *			also while the queue is started
+ *
+ * @param	portid : Port ID.
+ * @param	qid : Queue ID.
+ * @param	mode : Trigger mode to be configured
+ * @param	timer : Timer interval, one of the global CSR timer values
+ * @param	count : Counter threshold, one of the global CSR counter
+ *			values
+ *
+ * @return	'0' on success and '< 0' on failure.
+ *
+ * @note	Application can call this API after successful call to
+ *		rte_eth_rx_queue_setup() API. On a started queue the new
+ *		values reach the hardware through the completion ring CIDX
+ *		update done by the next rte_eth_rx_burst() or
+ *		rte_eth_dev_rx_intr_enable() call on the queue.
+ ******************************************************************************/
+int rte_pmd_qdma_set_cmpt_moderation(int portid, uint32_t qid,
+			enum rte_pmd_qdma_tigger_mode_t mode, uint32_t timer,
+			uint32_t count)
+{
+	struct qdma_pci_dev *qdma_dev;
+	struct qdma_rx_queue *rxq;
+	int8_t timer_index, cntr_index;
+
+	rxq = qdma_st_rxq_get(portid, qid);
+	if (rxq == NULL)
+		return -EINVAL;
+	qdma_dev = rte_eth_devices[portid].data->dev_private;
+
+	if (mode >= RTE_PMD_QDMA_TRIG_MODE_MAX) {
+		PMD_DRV_LOG(ERR, "Invalid Trigger mode passed\n");
+		return -EINVAL;
+	}
+
+	if ((mode == RTE_PMD_QDMA_TRIG_MODE_USER_TIMER_COUNT) &&
+		!qdma_dev->dev_cap.cmpt_trig_count_timer) {
+		PMD_DRV_LOG(ERR, "%s: Trigger mode %d is "
+			"not supported in the current design\n",
+			__func__, mode);
+		return -EINVAL;
+	}
+
+	timer_index = index_of_array(qdma_dev->g_c2h_timer_cnt,
+			QDMA_NUM_C2H_TIMERS, timer);
+	if (timer_index < 0) {
+		PMD_DRV_LOG(ERR, "Expected timer %d not found\n", timer);
+		return -ENOTSUP;
+	}
+
+	cntr_index = index_of_array(qdma_dev->g_c2h_cnt_th,
+			QDMA_NUM_C2H_COUNTERS, count);
+	if (cntr_index < 0) {
+		PMD_DRV_LOG(ERR, "Expected counter %d not found\n", count);
+		return -ENOTSUP;
+	}
+
+	qdma_dev->q_info[qid].trigger_mode = qdma_get_trigger_mode(mode);
+	qdma_dev->q_info[qid].timer_count = timer;
+	rxq->triggermode = qdma_dev->q_info[qid].trigger_mode;
+	rxq->timeridx = timer_index;
+	rxq->threshidx = cntr_index;
+
+	/* hand over to the lcore polling the queue, it owns the CIDX */
+	if (rxq->status == RTE_ETH_QUEUE_STATE_STARTED) {
+		rte_smp_wmb();
+		rxq->cmpt_moder_upd = 1;
+	}
+
+	return 0;
+}
+
+/******************************************************************************/
+/**
+ * Function Name:	rte_pmd_qdma_set_cmpt_adaptive_count
+ * Description:		Enables or disables the adaptive counter threshold of
+ *			a streaming mode Rx queue. When enabled, the PMD picks
+ *			the global CSR counter value closest to the recent
+ *			completion ring backlog.
+ *
+ * @param	portid : Port ID.
+ * @param	qid : Queue ID.
+ * @param	enable : '1' to enable and '0' to disable
+ *
+ * @return	'0' on success and '< 0' on failure.
+ *
+ * @note	Application can call this API after successful call to
+ *		rte_eth_rx_queue_setup() API. Disabling restores the counter
+ *		threshold the queue was configured with.
+ ******************************************************************************/
+int rte_pmd_qdma_set_cmpt_adaptive_count(int portid, uint32_t qid,
+			uint8_t enable)
+{
+	struct qdma_rx_queue *rxq;
+
+	rxq = qdma_st_rxq_get(portid, qid);
+	if (rxq == NULL)
+		return -EINVAL;
+
+	rxq->cntr_adaptive = enable ? 1 : 0;
+	if (!enable && rxq->status == RTE_ETH_QUEUE_STATE_STARTED) {
+		rte_smp_wmb();
+		rxq->cmpt_moder_upd = 1;
+	}
+
+	return 0;
+}
+
+/******************************************************************************/
+/**
+ * Function Name:	rte_pmd_qdma_set_rx_extbuf_pool
+ * Description:		Selects the pool of large buffers a streaming mode Rx
+ *			queue receives into. Every received packet is an
+ *			mbuf from the queue mbuf pool attached to the packet
+ *			data in the large buffer, instead of a chain of
+ *			mbufs each holding one C2H buffer.
+ *
+ * @param	portid : Port ID.
+ * @param	qid : Queue ID.
+ * @param	ext_pool : Pool of the large buffers, NULL to go back to
+ *			mbuf buffers
+ * @param	buf_sz : C2H buffer size the large buffers are carved in,
+ *			one of the global CSR buffer sizes
+ *
+ * @return	'0' on success and '< 0' on failure.
+ *
+ * @note	Application can call this API after successful call to
+ *		rte_eth_dev_configure() API and before rte_eth_rx_queue_setup()
+ *		API for the queue. This API is applicable for streaming
+ *		queues only.
+ ******************************************************************************/
+int rte_pmd_qdma_set_rx_extbuf_pool(int portid, uint32_t qid,
+		struct rte_mempool *ext_pool, uint16_t buf_sz)
+{
+	struct rte_eth_dev *dev;
+	struct qdma_pci_dev *qdma_dev;
+	int ret = 0;
+
+	ret = validate_qdma_dev_info(portid, qid);
+	if (ret != QDMA_SUCCESS) {
+		PMD_DRV_LOG(ERR,
+			"QDMA device validation failed for port id %d\n",
+			portid);
+		return ret;
+	}
+	dev = &rte_eth_devices[portid];
+	qdma_dev = dev->data->dev_private;
+	if (qid >= dev->data->nb_rx_queues) {
+		PMD_DRV_LOG(ERR, "Invalid RX Queue id passed for %s,"
+				"Queue ID = %d\n", __func__, qid);
+		return -EINVAL;
+	}
+
+	if (qdma_dev->q_info[qid].queue_mode !=
+			RTE_PMD_QDMA_STREAMING_MODE) {
+		PMD_DRV_LOG(ERR, "Qid %d is not setup in ST mode\n", qid);
+		return -EINVAL;
+	}
+
+	/* buf_sz is checked against the CSR values at rx queue setup */
+	if (ext_pool && buf_sz == 0) {
+		PMD_DRV_LOG(ERR, "Invalid C2H buffer size passed for %s\n",
+				__func__);
+		return -EINVAL;
+	}
+
+	if (dev->data->rx_queues[qid] != NULL) {
+		PMD_DRV_LOG(ERR,
+			"Cannot configure when Qid %d is already setup\n",
+			qid);
+		return -EINVAL;
+	}
+
+	qdma_dev->q_info[qid].ext_pool = ext_pool;
+	qdma_dev->q_info[qid].ext_buf_sz = ext_pool ? buf_sz : 0;
+
+	return ret;
+}
+
 /******************************************************************************/
 /**
  *Function Name:	rte_pmd_qdma_set_c2h_descriptor_prefetch
@@ -1204,6 +1508,8 @@ int rte_pmd_qdma_get_device_capabilities(int portid,
  *			in case of NUMA. Its value can be SOCKET_ID_ANY
  *			if there is no NUMA constraint for the DMA memory
  *			allocated for the transmit descriptors of the ring.
+ *			With the numa_policy=1 devarg the ring is put on
+ *			the device socket instead.
  *
  * @return  '0' on success and '< 0' on failure.
  *
@@ -1219,7 +1525,6 @@ int rte_pmd_qdma_dev_cmptq_setup(int portid, uint32_t cmpt_queue_id,
 	struct rte_eth_dev *dev;
 	uint32_t sz;
 	struct qdma_pci_dev *qdma_dev;
-	struct rte_pci_device *pci_dev;
 	struct qdma_cmpt_queue *cmptq = NULL;
 	int err;
 	int ret = 0;
@@ -1233,7 +1538,6 @@ int rte_pmd_qdma_dev_cmptq_setup(int portid, uint32_t cmpt_queue_id,
 	}
 	dev = &rte_eth_devices[portid];
 	qdma_dev = dev->data->dev_private;
-	pci_dev = RTE_ETH_DEV_TO_PCI(dev);
 	if (nb_cmpt_desc == 0) {
 		PMD_DRV_LOG(ERR, "Invalid descriptor ring size %d\n",
 				nb_cmpt_desc);
@@ -1247,7 +1551,8 @@ int rte_pmd_qdma_dev_cmptq_setup(int portid, uint32_t cmpt_queue_id,
 	}
 
 	if (!qdma_dev->is_vf) {
-		err = qdma_dev_increment_active_queue(pci_dev->addr.bus,
+		err = qdma_dev_increment_active_queue(
+				qdma_dev->dma_device_index,
 				qdma_dev->func_id, QDMA_DEV_Q_TYPE_CMPT);
 		if (err != QDMA_SUCCESS)
 			return -EINVAL;
@@ -1276,8 +1581,9 @@ int rte_pmd_qdma_dev_cmptq_setup(int portid, uint32_t cmpt_queue_id,
 	}
 
 	/* Allocate cmpt queue data structure */
-	cmptq = rte_zmalloc("QDMA_CmptQ", sizeof(struct qdma_cmpt_queue),
-						RTE_CACHE_LINE_SIZE);
+	cmptq = rte_zmalloc_socket("QDMA_CmptQ",
+						sizeof(struct qdma_cmpt_queue),
+						RTE_CACHE_LINE_SIZE, socket_id);
 
 	if (!cmptq) {
 		PMD_DRV_LOG(ERR, "Unable to allocate structure cmptq of "
@@ -1290,6 +1596,7 @@ int rte_pmd_qdma_dev_cmptq_setup(int portid, uint32_t cmpt_queue_id,
 	cmptq->queue_id = cmpt_queue_id;
 	cmptq->port_id = dev->data->port_id;
 	cmptq->func_id = qdma_dev->func_id;
+	cmptq->cmpt_db = qdma_cmpt_cidx_db_offset(qdma_dev, cmpt_queue_id);
 	cmptq->dev = dev;
 	cmptq->st_mode = qdma_dev->q_info[cmpt_queue_id].queue_mode;
 	cmptq->triggermode = qdma_dev->q_info[cmpt_queue_id].trigger_mode;
@@ -1342,7 +1649,9 @@ int rte_pmd_qdma_dev_cmptq_setup(int portid, uint32_t cmpt_queue_id,
 	/* Allocate memory for completion(CMPT) descriptor ring */
 	sz = (cmptq->nb_cmpt_desc) * cmptq->cmpt_desc_len;
 	cmptq->cmpt_mz = qdma_zone_reserve(dev, "RxHwCmptRn",
-			cmpt_queue_id, sz, socket_id);
+			cmpt_queue_id, sz,
+			qdma_ring_socket(dev, "CMPT", cmpt_queue_id,
+					socket_id));
 	if (!cmptq->cmpt_mz) {
 		PMD_DRV_LOG(ERR, "Unable to allocate cmptq->cmpt_mz "
 				"of size %d\n", sz);
@@ -1361,7 +1670,7 @@ int rte_pmd_qdma_dev_cmptq_setup(int portid, uint32_t cmpt_queue_id,
 
 cmptq_setup_err:
 	if (!qdma_dev->is_vf)
-		qdma_dev_decrement_active_queue(pci_dev->addr.bus,
+		qdma_dev_decrement_active_queue(qdma_dev->dma_device_index,
 				qdma_dev->func_id, QDMA_DEV_Q_TYPE_CMPT);
 	else
 		qdma_dev_notify_qdel(dev, cmpt_queue_id +
@@ -1763,9 +2072,610 @@ uint16_t rte_pmd_qdma_mm_cmpt_process(int portid, uint32_t qid,
 
 	// Update the CPMT CIDX
 	cmptq->cmpt_cidx_info.wrb_cidx = cmpt_tail;
-	qdma_dev->hw_access->qdma_queue_cmpt_cidx_update(cmptq->dev,
-			qdma_dev->is_vf,
-			cmptq->queue_id,
-			&cmptq->cmpt_cidx_info);
+	qdma_cmptq_cidx_db(cmptq);
 	return count;
 }
+
+/* MM completion entries prefetched ahead of the peek scan */
+#define QDMA_MM_CMPT_PREFETCH_AHEAD	4
+
+static struct qdma_cmpt_queue *qdma_mm_cmptq_get(int portid, uint32_t qid)
+{
+	struct qdma_pci_dev *qdma_dev;
+
+	if (validate_qdma_dev_info(portid, qid) != QDMA_SUCCESS) {
+		PMD_DRV_LOG(ERR,
+			"QDMA device validation failed for port id %d\n",
+			portid);
+		return NULL;
+	}
+	qdma_dev = rte_eth_devices[portid].data->dev_private;
+	if (qdma_dev->q_info[qid].queue_mode !=
+			RTE_PMD_QDMA_MEMORY_MAPPED_MODE) {
+		PMD_DRV_LOG(ERR, "Qid %d is not configured in MM-mode\n", qid);
+		return NULL;
+	}
+
+	return (struct qdma_cmpt_queue *)qdma_dev->cmpt_queues[qid];
+}
+
+/******************************************************************************/
+/**
+ * Function Name:   rte_pmd_qdma_mm_cmpt_peek
+ * Description:     Return pointers to the pending MM completion entries,
+ *                  in place in the completion ring.
+ *
+ * @param   portid : Port ID.
+ * @param   qid : Queue ID.
+ * @param   cmpt_entries : Array filled with the entry addresses.
+ * @param   nb_entries : Size of the cmpt_entries array.
+ *
+ * @return  'number of entries returned' on success, -EIO if the oldest
+ *          pending entry has the error bit set and '< 0' on other
+ *          failures.
+ *
+ * @note    The entries stay owned by the application until released with
+ *          rte_pmd_qdma_mm_cmpt_release(). The scan stops before an entry
+ *          with the error bit set; once it is the oldest one, -EIO is
+ *          returned until it is released.
+ ******************************************************************************/
+int rte_pmd_qdma_mm_cmpt_peek(int portid, uint32_t qid,
+		void **cmpt_entries, uint16_t nb_entries)
+{
+	struct qdma_cmpt_queue *cmptq;
+	struct qdma_ul_cmpt_ring *cmpt_entry;
+	uint16_t nb_desc, cmpt_tail, cmpt_pidx, pf_idx;
+	uint16_t nb_entries_avail = 0;
+	uint16_t count = 0;
+
+	cmptq = qdma_mm_cmptq_get(portid, qid);
+	if (cmptq == NULL || cmpt_entries == NULL)
+		return -EINVAL;
+
+	nb_desc = cmptq->nb_cmpt_desc - 1;
+	cmpt_tail = cmptq->cmpt_cidx_info.wrb_cidx;
+	cmpt_pidx = cmptq->wb_status->pidx;
+
+	if (cmpt_tail < cmpt_pidx)
+		nb_entries_avail = cmpt_pidx - cmpt_tail;
+	else if (cmpt_tail > cmpt_pidx)
+		nb_entries_avail = nb_desc - cmpt_tail + cmpt_pidx;
+
+	if (nb_entries > nb_entries_avail)
+		nb_entries = nb_entries_avail;
+
+	/* Make sure reads to CMPT ring are synchronized before
+	 * accessing the ring
+	 */
+	rte_rmb();
+
+	pf_idx = cmpt_tail;
+	for (count = 0; count < RTE_MIN(nb_entries,
+			QDMA_MM_CMPT_PREFETCH_AHEAD); count++) {
+		rte_prefetch0((uint8_t *)cmptq->cmpt_ring +
+				((uint64_t)pf_idx * cmptq->cmpt_desc_len));
+		if (unlikely(++pf_idx >= nb_desc))
+			pf_idx = 0;
+	}
+
+	for (count = 0; count < nb_entries; count++) {
+		if (count + QDMA_MM_CMPT_PREFETCH_AHEAD < nb_entries) {
+			rte_prefetch0((uint8_t *)cmptq->cmpt_ring +
+				((uint64_t)pf_idx * cmptq->cmpt_desc_len));
+			if (unlikely(++pf_idx >= nb_desc))
+				pf_idx = 0;
+		}
+
+		cmpt_entry = (struct qdma_ul_cmpt_ring *)
+			((uint8_t *)cmptq->cmpt_ring +
+			((uint64_t)cmpt_tail * cmptq->cmpt_desc_len));
+		if (unlikely(cmpt_entry->err || cmpt_entry->data_frmt)) {
+			/* entries ahead of it are returned first, the next
+			 * peek then reports the error
+			 */
+			if (count == 0) {
+				PMD_DRV_LOG(DEBUG, "Error entry on CMPT ring "
+						"at index %d, queue_id = %d\n",
+						cmpt_tail, cmptq->queue_id);
+				return -EIO;
+			}
+			break;
+		}
+		cmpt_entries[count] = cmpt_entry;
+
+		if (unlikely(++cmpt_tail >= nb_desc))
+			cmpt_tail = 0;
+	}
+
+	return count;
+}
+
+/******************************************************************************/
+/**
+ * Function Name:   rte_pmd_qdma_mm_cmpt_release
+ * Description:     Hand MM completion entries returned by
+ *                  rte_pmd_qdma_mm_cmpt_peek() back to the hardware,
+ *                  with a single CIDX update.
+ *
+ * @param   portid : Port ID.
+ * @param   qid : Queue ID.
+ * @param   nb_entries : Number of entries to release, oldest first.
+ *
+ * @return  '0' on success and '< 0' on failure.
+ ******************************************************************************/
+int rte_pmd_qdma_mm_cmpt_release(int portid, uint32_t qid,
+		uint16_t nb_entries)
+{
+	struct qdma_cmpt_queue *cmptq;
+	uint16_t nb_desc, cmpt_tail, cmpt_pidx;
+	uint16_t nb_entries_avail = 0;
+
+	cmptq = qdma_mm_cmptq_get(portid, qid);
+	if (cmptq == NULL)
+		return -EINVAL;
+	if (nb_entries == 0)
+		return 0;
+
+	nb_desc = cmptq->nb_cmpt_desc - 1;
+	cmpt_tail = cmptq->cmpt_cidx_info.wrb_cidx;
+	cmpt_pidx = cmptq->wb_status->pidx;
+
+	if (cmpt_tail < cmpt_pidx)
+		nb_entries_avail = cmpt_pidx - cmpt_tail;
+	else if (cmpt_tail > cmpt_pidx)
+		nb_entries_avail = nb_desc - cmpt_tail + cmpt_pidx;
+
+	if (nb_entries > nb_entries_avail) {
+		PMD_DRV_LOG(ERR, "Cannot release %d CMPT entries, only %d "
+				"pending on queue_id = %d\n", nb_entries,
+				nb_entries_avail, cmptq->queue_id);
+		return -EINVAL;
+	}
+
+	cmpt_tail += nb_entries;
+	if (cmpt_tail >= nb_desc)
+		cmpt_tail -= nb_desc;
+
+	cmptq->cmpt_cidx_info.wrb_cidx = cmpt_tail;
+	qdma_cmptq_cidx_db(cmptq);
+
+	return 0;
+}
+
+/* Descriptor ring of a MM queue as seen by the copy API */
+struct qdma_mm_copy_ring {
+	struct qdma_pci_dev *qdma_dev;
+	struct qdma_hw_access *hw_access;
+	struct rte_eth_dev *dev;
+	struct qdma_ul_mm_desc *ring;
+	struct wb_status *wb_status;
+	struct qdma_q_pidx_reg_info *pidx_info;
+	uint16_t *tail;	/* first descriptor not completed yet */
+	uint16_t *pend;	/* descriptors written after the last doorbell */
+	uint16_t nb_desc;
+	uint16_t queue_id;
+	uint8_t is_c2h;
+};
+
+static int qdma_mm_copy_ring_get(int portid, uint32_t qid,
+			enum rte_pmd_qdma_dir_type dir,
+			struct qdma_mm_copy_ring *r)
+{
+	struct rte_eth_dev *dev;
+	struct qdma_pci_dev *qdma_dev;
+	struct qdma_rx_queue *rxq;
+	struct qdma_tx_queue *txq;
+	int ret;
+
+	ret = validate_qdma_dev_info(portid, qid);
+	if (ret != QDMA_SUCCESS)
+		return ret;
+
+	dev = &rte_eth_devices[portid];
+	qdma_dev = dev->data->dev_private;
+	r->dev = dev;
+	r->qdma_dev = qdma_dev;
+	r->hw_access = &QDMA_PROC_PRIV(portid)->hw_access;
+	r->queue_id = qid;
+
+	if (dir == RTE_PMD_QDMA_TX) {
+		if (qid >= dev->data->nb_tx_queues) {
+			PMD_DRV_LOG(ERR, "Invalid Q-id passed qid %d max "
+					"en_qid %d\n", qid,
+					dev->data->nb_tx_queues);
+			return -EINVAL;
+		}
+		txq = (struct qdma_tx_queue *)dev->data->tx_queues[qid];
+		if (txq == NULL || txq->st_mode || txq->en_bypass ||
+				txq->status != RTE_ETH_QUEUE_STATE_STARTED)
+			return -EINVAL;
+		r->ring = (struct qdma_ul_mm_desc *)txq->tx_ring;
+		r->wb_status = txq->wb_status;
+		r->pidx_info = &txq->q_pidx_info;
+		r->tail = &txq->tx_fl_tail;
+		r->pend = &txq->tx_desc_pend;
+		r->nb_desc = txq->nb_tx_desc - 1;
+		r->is_c2h = 0;
+	} else if (dir == RTE_PMD_QDMA_RX) {
+		if (qid >= dev->data->nb_rx_queues) {
+			PMD_DRV_LOG(ERR, "Invalid Q-id passed qid %d max "
+					"en_qid %d\n", qid,
+					dev->data->nb_rx_queues);
+			return -EINVAL;
+		}
+		rxq = (struct qdma_rx_queue *)dev->data->rx_queues[qid];
+		if (rxq == NULL || rxq->st_mode || rxq->en_bypass ||
+				rxq->status != RTE_ETH_QUEUE_STATE_STARTED)
+			return -EINVAL;
+		r->ring = (struct qdma_ul_mm_desc *)rxq->rx_ring;
+		r->wb_status = rxq->wb_status;
+		r->pidx_info = &rxq->q_pidx_info;
+		r->tail = &rxq->rx_tail;
+		r->pend = &rxq->rx_desc_pend;
+		r->nb_desc = rxq->nb_rx_desc - 1;
+		r->is_c2h = 1;
+	} else {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static void qdma_mm_copy_ring_submit(struct qdma_mm_copy_ring *r)
+{
+	if (!*r->pend)
+		return;
+
+	/* Make sure writes to the descriptors are synchronized
+	 * before updating PIDX
+	 */
+	rte_wmb();
+
+	r->hw_access->qdma_queue_pidx_update(r->dev,
+			r->qdma_dev->is_vf, r->queue_id, r->is_c2h,
+			r->pidx_info);
+	*r->pend = 0;
+}
+
+static int qdma_mm_copy_ring_enqueue(struct qdma_mm_copy_ring *r,
+			const struct rte_pmd_qdma_mm_copy_seg *segs,
+			uint16_t nb_segs, uint64_t flags)
+{
+	struct qdma_ul_mm_desc *desc;
+	uint16_t id = r->pidx_info->pidx;
+	uint16_t last = id;
+	int in_use;
+	uint16_t i;
+
+	/* Keep one descriptor free so a full ring is told apart from
+	 * an empty one by the engine
+	 */
+	in_use = (int)id - *r->tail;
+	if (in_use < 0)
+		in_use += r->nb_desc;
+	if (nb_segs > (r->nb_desc - 1 - in_use))
+		return -ENOSPC;
+
+	for (i = 0; i < nb_segs; i++) {
+		if (unlikely(segs[i].len == 0 ||
+				segs[i].len > RTE_PMD_QDMA_MM_COPY_MAX_LEN))
+			return -EINVAL;
+	}
+
+	for (i = 0; i < nb_segs; i++) {
+		desc = &r->ring[id];
+		if (r->is_c2h) {
+			desc->src_addr = segs[i].ep_addr;
+			desc->dst_addr = segs[i].host_addr;
+		} else {
+			desc->src_addr = segs[i].host_addr;
+			desc->dst_addr = segs[i].ep_addr;
+		}
+		desc->dv = 1;
+		desc->sop = 1;
+		desc->eop = 1;
+		desc->len = segs[i].len;
+
+		last = id;
+		id++;
+		if (unlikely(id >= r->nb_desc))
+			id -= r->nb_desc;
+	}
+
+	r->pidx_info->pidx = id;
+	*r->pend += nb_segs;
+
+	if (flags & RTE_PMD_QDMA_MM_COPY_F_SUBMIT)
+		qdma_mm_copy_ring_submit(r);
+
+	return last;
+}
+
+/******************************************************************************/
+/**
+ * Function Name:	rte_pmd_qdma_mm_copy
+ * Description:		Enqueue a copy between host and card memory on a
+ *			memory mapped queue, without an mbuf.
+ *
+ * @param	portid : Port ID.
+ * @param	qid : Queue ID.
+ * @param	dir : RTE_PMD_QDMA_TX copies host to card memory,
+ *		RTE_PMD_QDMA_RX copies card to host memory.
+ * @param	host_addr : IO address of the host buffer.
+ * @param	ep_addr : Card memory address.
+ * @param	len : Number of bytes to copy.
+ * @param	flags : RTE_PMD_QDMA_MM_COPY_F_* flags.
+ *
+ * @return	ring index of the copy on success, '-ENOSPC' if the ring
+ *		is full and other '< 0' values on failure.
+ *
+ * @note	The copy is not started before rte_pmd_qdma_mm_submit() is
+ *		called or RTE_PMD_QDMA_MM_COPY_F_SUBMIT is passed.
+ ******************************************************************************/
+int rte_pmd_qdma_mm_copy(int portid, uint32_t qid,
+			enum rte_pmd_qdma_dir_type dir, rte_iova_t host_addr,
+			uint64_t ep_addr, uint32_t len, uint64_t flags)
+{
+	struct rte_pmd_qdma_mm_copy_seg seg;
+	struct qdma_mm_copy_ring r;
+	int ret;
+
+	ret = qdma_mm_copy_ring_get(portid, qid, dir, &r);
+	if (ret < 0)
+		return ret;
+
+	seg.host_addr = host_addr;
+	seg.ep_addr = ep_addr;
+	seg.len = len;
+
+	return qdma_mm_copy_ring_enqueue(&r, &seg, 1, flags);
+}
+
+/******************************************************************************/
+/**
+ * Function Name:	rte_pmd_qdma_mm_copy_sg
+ * Description:		Enqueue a copy job made of several segments on a
+ *			memory mapped queue, one descriptor per segment.
+ *
+ * @param	portid : Port ID.
+ * @param	qid : Queue ID.
+ * @param	dir : direction i.e. Tx (host to card) or Rx (card to host).
+ * @param	segs : Array of segments to copy.
+ * @param	nb_segs : Number of segments in the array.
+ * @param	flags : RTE_PMD_QDMA_MM_COPY_F_* flags.
+ *
+ * @return	ring index of the last segment on success, '-ENOSPC' if the
+ *		ring can not hold all segments and other '< 0' values
+ *		on failure.
+ *
+ * @note	Either all segments or none are enqueued.
+ ******************************************************************************/
+int rte_pmd_qdma_mm_copy_sg(int portid, uint32_t qid,
+			enum rte_pmd_qdma_dir_type dir,
+			const struct rte_pmd_qdma_mm_copy_seg *segs,
+			uint16_t nb_segs, uint64_t flags)
+{
+	struct qdma_mm_copy_ring r;
+	int ret;
+
+	if (segs == NULL || nb_segs == 0)
+		return -EINVAL;
+
+	ret = qdma_mm_copy_ring_get(portid, qid, dir, &r);
+	if (ret < 0)
+		return ret;
+
+	return qdma_mm_copy_ring_enqueue(&r, segs, nb_segs, flags);
+}
+
+/******************************************************************************/
+/**
+ * Function Name:	rte_pmd_qdma_mm_submit
+ * Description:		Start the copies enqueued on a memory mapped queue
+ *			with a single doorbell write.
+ *
+ * @param	portid : Port ID.
+ * @param	qid : Queue ID.
+ * @param	dir : direction i.e. Tx or Rx.
+ *
+ * @return	'0' on success and '< 0' on failure.
+ *
+ * @note	None.
+ ******************************************************************************/
+int rte_pmd_qdma_mm_submit(int portid, uint32_t qid,
+			enum rte_pmd_qdma_dir_type dir)
+{
+	struct qdma_mm_copy_ring r;
+	int ret;
+
+	ret = qdma_mm_copy_ring_get(portid, qid, dir, &r);
+	if (ret < 0)
+		return ret;
+
+	qdma_mm_copy_ring_submit(&r);
+	return 0;
+}
+
+/******************************************************************************/
+/**
+ * Function Name:	rte_pmd_qdma_mm_completed
+ * Description:		Return the number of copies completed by the engine
+ *			since the previous call and release their descriptors.
+ *
+ * @param	portid : Port ID.
+ * @param	qid : Queue ID.
+ * @param	dir : direction i.e. Tx or Rx.
+ * @param	nb_cpls : Maximum number of completions to return.
+ * @param	last_idx : If not NULL, ring index of the last completed
+ *		descriptor is returned here.
+ *
+ * @return	number of completed descriptors on success and '< 0'
+ *		on failure.
+ *
+ * @note	Copies complete in the order they were enqueued.
+ ******************************************************************************/
+int rte_pmd_qdma_mm_completed(int portid, uint32_t qid,
+			enum rte_pmd_qdma_dir_type dir, uint16_t nb_cpls,
+			uint16_t *last_idx)
+{
+	struct qdma_mm_copy_ring r;
+	int nb_done;
+	uint16_t id;
+	int ret;
+
+	ret = qdma_mm_copy_ring_get(portid, qid, dir, &r);
+	if (ret < 0)
+		return ret;
+
+	id = *r.tail;
+	nb_done = (int)r.wb_status->cidx - id;
+	if (nb_done < 0)
+		nb_done += r.nb_desc;
+	if (nb_done > nb_cpls)
+		nb_done = nb_cpls;
+	if (nb_done == 0)
+		return 0;
+
+	/* Make sure the copied data is not read before the
+	 * writeback CIDX is read
+	 */
+	rte_rmb();
+
+	id += nb_done;
+	if (id >= r.nb_desc)
+		id -= r.nb_desc;
+	*r.tail = id;
+
+	if (last_idx != NULL)
+		*last_idx = (id == 0) ? (r.nb_desc - 1) : (id - 1);
+
+	return nb_done;
+}
+
+static int qdma_queue_cycles_get(int portid, uint32_t qid,
+			enum rte_pmd_qdma_dir_type dir, uint8_t **en,
+			struct rte_pmd_qdma_q_cycles **cycles)
+{
+	struct rte_eth_dev *dev;
+	struct qdma_rx_queue *rxq;
+	struct qdma_tx_queue *txq;
+	int ret;
+
+	ret = validate_qdma_dev_info(portid, qid);
+	if (ret != QDMA_SUCCESS) {
+		PMD_DRV_LOG(ERR,
+			"QDMA device validation failed for port id %d\n",
+			portid);
+		return ret;
+	}
+	dev = &rte_eth_devices[portid];
+
+	if (dir == RTE_PMD_QDMA_TX) {
+		if (qid >= dev->data->nb_tx_queues) {
+			PMD_DRV_LOG(ERR, "Invalid Q-id passed qid %d max "
+					"en_qid %d\n", qid,
+					dev->data->nb_tx_queues);
+			return -EINVAL;
+		}
+		txq = (struct qdma_tx_queue *)dev->data->tx_queues[qid];
+		if (txq == NULL) {
+			PMD_DRV_LOG(ERR, "Qid %d is not setup\n", qid);
+			return -EINVAL;
+		}
+		*en = &txq->cycles_en;
+		*cycles = &txq->cycles;
+	} else if (dir == RTE_PMD_QDMA_RX) {
+		if (qid >= dev->data->nb_rx_queues) {
+			PMD_DRV_LOG(ERR, "Invalid Q-id passed qid %d max "
+					"en_qid %d\n", qid,
+					dev->data->nb_rx_queues);
+			return -EINVAL;
+		}
+		rxq = (struct qdma_rx_queue *)dev->data->rx_queues[qid];
+		if (rxq == NULL) {
+			PMD_DRV_LOG(ERR, "Qid %d is not setup\n", qid);
+			return -EINVAL;
+		}
+		*en = &rxq->cycles_en;
+		*cycles = &rxq->cycles;
+	} else {
+		PMD_DRV_LOG(ERR, "Invalid direction specified,"
+			"Direction is %d\n", dir);
+		return -EINVAL;
+	}
+	return 0;
+}
+
+/******************************************************************************/
+/**
+ * Function Name:	rte_pmd_qdma_set_queue_cycles
+ * Description:		Enables or disables the accounting of the TSC
+ *			cycles spent in the Rx or Tx burst function of a
+ *			queue.
+ *
+ * @param	portid : Port ID.
+ * @param	qid : Queue ID.
+ * @param	dir : direction i.e. Tx or Rx.
+ * @param	enable : '1' to enable and '0' to disable.
+ *
+ * @return	'0' on success and '< 0' on failure.
+ *
+ * @note	The counters are cleared on every call. Accounting reads the
+ *		TSC twice per burst, keep it off outside of measurements.
+ ******************************************************************************/
+int rte_pmd_qdma_set_queue_cycles(int portid, uint32_t qid,
+			enum rte_pmd_qdma_dir_type dir, uint8_t enable)
+{
+	struct rte_pmd_qdma_q_cycles *c;
+	uint8_t *en;
+	int ret;
+
+	ret = qdma_queue_cycles_get(portid, qid, dir, &en, &c);
+	if (ret < 0)
+		return ret;
+
+	/* Stop accounting before clearing, the polling lcore may be in a
+	 * burst, a clear racing with it can leave at most that burst behind
+	 */
+	*en = 0;
+	rte_smp_wmb();
+	memset(c, 0, sizeof(*c));
+	rte_smp_wmb();
+	*en = !!enable;
+	return 0;
+}
+
+/******************************************************************************/
+/**
+ * Function Name:	rte_pmd_qdma_get_queue_cycles
+ * Description:		Returns the burst cycle counters of a queue.
+ *
+ * @param	portid : Port ID.
+ * @param	qid : Queue ID.
+ * @param	dir : direction i.e. Tx or Rx.
+ * @param	cycles : Counters are returned here.
+ *
+ * @return	'0' on success and '< 0' on failure.
+ *
+ * @note	Counters are updated by the lcore polling the queue without
+ *		synchronization, a snapshot taken while it runs may mix
+ *		counts of two bursts. Cycles per packet is cycles / pkts.
+ ******************************************************************************/
+int rte_pmd_qdma_get_queue_cycles(int portid, uint32_t qid,
+			enum rte_pmd_qdma_dir_type dir,
+			struct rte_pmd_qdma_q_cycles *cycles)
+{
+	struct rte_pmd_qdma_q_cycles *c;
+	uint8_t *en;
+	int ret;
+
+	if (cycles == NULL)
+		return -EINVAL;
+
+	ret = qdma_queue_cycles_get(portid, qid, dir, &en, &c);
+	if (ret < 0)
+		return ret;
+
+	*cycles = *c;
+	return 0;
+}
@@ -142,6 +142,44 @@ enum rte_pmd_qdma_versal_ip_type {
 	RTE_PMD_QDMA_VERSAL_NONE
 };
 
+/** Offset value disabling a CMPT user field, see
+ *  rte_pmd_qdma_set_cmpt_user_fields()
+ */
+#define RTE_PMD_QDMA_CMPT_FIELD_NONE	(-1)
+
+/** Ring the queue doorbell as part of the copy enqueue */
+#define RTE_PMD_QDMA_MM_COPY_F_SUBMIT	(1ULL << 0)
+/** Largest length of a single MM copy descriptor */
+#define RTE_PMD_QDMA_MM_COPY_MAX_LEN	((1U << 28) - 1)
+
+/**
+ * struct rte_pmd_qdma_mm_copy_seg - one segment of a MM copy job
+ */
+struct rte_pmd_qdma_mm_copy_seg {
+	/** @host_addr - IO address of the host memory */
+	rte_iova_t host_addr;
+	/** @ep_addr - Card memory address */
+	uint64_t ep_addr;
+	/** @len - Number of bytes to copy */
+	uint32_t len;
+};
+
+/**
+ * struct rte_pmd_qdma_q_cycles - burst function cycle accounting
+ */
+struct rte_pmd_qdma_q_cycles {
+	/** @bursts - Bursts that moved at least one packet */
+	uint64_t bursts;
+	/** @pkts - Packets moved by those bursts */
+	uint64_t pkts;
+	/** @cycles - TSC cycles spent in those bursts */
+	uint64_t cycles;
+	/** @idle_bursts - Bursts that moved no packet */
+	uint64_t idle_bursts;
+	/** @idle_cycles - TSC cycles spent in those bursts */
+	uint64_t idle_cycles;
+};
+
 struct rte_pmd_qdma_xdebug_desc_param {
 	uint16_t queue;
 	int start;
@@ -363,6 +401,37 @@ int rte_pmd_qdma_set_queue_mode(int portid, uint32_t qid,
 int rte_pmd_qdma_set_immediate_data_state(int portid, uint32_t qid,
 			uint8_t state);
 
+/******************************************************************************/
+/**
+ *Function Name:	rte_pmd_qdma_set_cmpt_user_fields
+ *Description:		Selects the user defined bytes of the completion
+ *			entries delivered in the received mbufs.
+ *			The 64 bit little endian value at ts_offset is stored
+ *			in mbuf->timestamp with PKT_RX_TIMESTAMP set.
+ *			The 32 bit little endian value at meta_offset is
+ *			stored in mbuf->hash.fdir.hi with PKT_RX_FDIR and
+ *			PKT_RX_FDIR_ID set.
+ *
+ *@param	portid : Port ID.
+ *@param	qid : Queue ID.
+ *@param	ts_offset : Byte offset of the timestamp in the completion
+ *			entry, RTE_PMD_QDMA_CMPT_FIELD_NONE to disable
+ *@param	meta_offset : Byte offset of the metadata in the completion
+ *			entry, RTE_PMD_QDMA_CMPT_FIELD_NONE to disable
+ *
+ *@return	'0' on success and '< 0' on failure.
+ *
+ *@note		Application can call this API after successful
+ *		call to rte_eth_dev_configure() API, and after
+ *		rte_eth_rx_queue_setup() only if rx queue is not in
+ *		start state. The fields must lie within the completion
+ *		entry size of the queue. Queues using them are served by
+ *		the scalar receive path.
+ *		This API is applicable for streaming queues only.
+ ******************************************************************************/
+int rte_pmd_qdma_set_cmpt_user_fields(int portid, uint32_t qid,
+			int8_t ts_offset, int8_t meta_offset);
+
 /******************************************************************************/
 /**
  * Function Name:	rte_pmd_qdma_set_cmpt_overflow_check
@@ -442,6 +511,86 @@ int rte_pmd_qdma_set_cmpt_trigger_mode(int portid, uint32_t qid,
  ******************************************************************************/
 int rte_pmd_qdma_set_cmpt_timer(int portid, uint32_t qid, uint32_t value);
 
+/******************************************************************************/
+/**
+ * Function Name:	rte_pmd_qdma_set_cmpt_moderation
+ * Description:		Changes the trigger mode, timer and counter threshold
+ *			of the completion ring of a streaming mode Rx queue,
+ *			also while the queue is started
+ *
+ * @param	portid : Port ID.
+ * @param	qid : Queue ID.
+ * @param	mode : Trigger mode to be configured
+ * @param	timer : Timer interval, one of the global CSR timer values
+ * @param	count : Counter threshold, one of the global CSR counter
+ *			values
+ *
+ * @return	'0' on success and '< 0' on failure.
+ *
+ * @note	Application can call this API after successful call to
+ *		rte_eth_rx_queue_setup() API. On a started queue the new
+ *		values reach the hardware through the completion ring CIDX
+ *		update done by the next rte_eth_rx_burst() or
+ *		rte_eth_dev_rx_intr_enable() call on the queue.
+ ******************************************************************************/
+int rte_pmd_qdma_set_cmpt_moderation(int portid, uint32_t qid,
+			enum rte_pmd_qdma_tigger_mode_t mode, uint32_t timer,
+			uint32_t count);
+
+/******************************************************************************/
+/**
+ * Function Name:	rte_pmd_qdma_set_cmpt_adaptive_count
+ * Description:		Enables or disables the adaptive counter threshold of
+ *			a streaming mode Rx queue. When enabled, the PMD picks
+ *			the global CSR counter value closest to the recent
+ *			completion ring backlog.
+ *
+ * @param	portid : Port ID.
+ * @param	qid : Queue ID.
+ * @param	enable : '1' to enable and '0' to disable
+ *
+ * @return	'0' on success and '< 0' on failure.
+ *
+ * @note	Application can call this API after successful call to
+ *		rte_eth_rx_queue_setup() API. Disabling restores the counter
+ *		threshold the queue was configured with.
+ ******************************************************************************/
+int rte_pmd_qdma_set_cmpt_adaptive_count(int portid, uint32_t qid,
+			uint8_t enable);
+
+/******************************************************************************/
+/**
+ * Function Name:	rte_pmd_qdma_set_rx_extbuf_pool
+ * Description:		Selects the pool of large buffers a streaming mode Rx
+ *			queue receives into, for transfers of many C2H
+ *			buffers. The whole buf_sz slices in front of the
+ *			struct rte_mbuf_ext_shared_info kept at the tail of
+ *			each pool element are posted to the hardware in
+ *			order. A received packet is an mbuf of the queue
+ *			mbuf pool attached with rte_pktmbuf_attach_extbuf()
+ *			to its data, which is contiguous unless the packet
+ *			straddles two large buffers (then it has a second
+ *			segment). A large buffer goes back to ext_pool once
+ *			the last mbuf attached to it is freed.
+ *
+ * @param	portid : Port ID.
+ * @param	qid : Queue ID.
+ * @param	ext_pool : Pool of the large buffers, its elements must be
+ *			IOVA contiguous. NULL to go back to mbuf buffers
+ * @param	buf_sz : C2H buffer size the large buffers are carved in,
+ *			one of the global CSR buffer sizes
+ *
+ * @return	'0' on success and '< 0' on failure.
+ *
+ * @note	Application can call this API after successful call to
+ *		rte_eth_dev_configure() API and before rte_eth_rx_queue_setup()
+ *		API for the queue. Queues in this mode are served by the
+ *		scalar receive path.
+ *		This API is applicable for streaming queues only.
+ ******************************************************************************/
+int rte_pmd_qdma_set_rx_extbuf_pool(int portid, uint32_t qid,
+			struct rte_mempool *ext_pool, uint16_t buf_sz);
+
 /******************************************************************************/
 /**
  *Function Name:	rte_pmd_qdma_set_c2h_descriptor_prefetch
@@ -557,6 +706,8 @@ int rte_pmd_qdma_get_device_capabilities(int portid,
  *			in case of NUMA. Its value can be SOCKET_ID_ANY
  *			if there is no NUMA constraint for the DMA memory
  *			allocated for the transmit descriptors of the ring.
+ *			With the numa_policy=1 devarg the ring is put on
+ *			the device socket instead.
  *
  * @return  '0' on success and '< 0' on failure.
  *
@@ -618,4 +769,182 @@ int rte_pmd_qdma_dev_cmptq_stop(int portid, uint32_t qid);
 uint16_t rte_pmd_qdma_mm_cmpt_process(int portid, uint32_t qid, void *cmpt_buff,
 		uint16_t nb_entries);
 
+/******************************************************************************/
+/**
+ * Function Name:   rte_pmd_qdma_mm_cmpt_peek
+ * Description:     Zero-copy access to the MM completion queue. Returns
+ *                  pointers to the pending entries in the completion ring
+ *                  without consuming them.
+ *
+ * @param   portid : Port ID.
+ * @param   qid : Queue ID.
+ * @param   cmpt_entries : Array filled with the entry addresses, each
+ *                         entry being the completion descriptor size long.
+ * @param   nb_entries : Size of the cmpt_entries array.
+ *
+ * @return  'number of entries returned' on success, -EIO if the oldest
+ *          pending entry has the error bit set and '< 0' on other
+ *          failures.
+ *
+ * @note    Application can call this API after successful call to
+ *          rte_pmd_qdma_dev_cmptq_start() API. Entries are valid until
+ *          released with rte_pmd_qdma_mm_cmpt_release(); repeated peeks
+ *          return the same entries first. The scan stops before an entry
+ *          with the error bit set; once it is the oldest one, -EIO is
+ *          returned until the application drops it with
+ *          rte_pmd_qdma_mm_cmpt_release(portid, qid, 1).
+ ******************************************************************************/
+int rte_pmd_qdma_mm_cmpt_peek(int portid, uint32_t qid,
+		void **cmpt_entries, uint16_t nb_entries);
+
+/******************************************************************************/
+/**
+ * Function Name:   rte_pmd_qdma_mm_cmpt_release
+ * Description:     Return the oldest peeked MM completion entries to the
+ *                  hardware with a single CIDX update.
+ *
+ * @param   portid : Port ID.
+ * @param   qid : Queue ID.
+ * @param   nb_entries : Number of entries to release.
+ *
+ * @return  '0' on success and '< 0' on failure.
+ *
+ * @note    nb_entries must not exceed the number of pending entries.
+ ******************************************************************************/
+int rte_pmd_qdma_mm_cmpt_release(int portid, uint32_t qid,
+		uint16_t nb_entries);
+
+/******************************************************************************/
+/**
+ * Function Name:	rte_pmd_qdma_mm_copy
+ * Description:		Enqueue a copy between host and card memory on a
+ *			memory mapped queue, without an mbuf.
+ *
+ * @param	portid : Port ID.
+ * @param	qid : Queue ID.
+ * @param	dir : RTE_PMD_QDMA_TX copies host to card memory,
+ *		RTE_PMD_QDMA_RX copies card to host memory.
+ * @param	host_addr : IO address of the host buffer.
+ * @param	ep_addr : Card memory address.
+ * @param	len : Number of bytes to copy.
+ * @param	flags : RTE_PMD_QDMA_MM_COPY_F_* flags.
+ *
+ * @return	ring index of the copy on success, '-ENOSPC' if the ring
+ *		is full and other '< 0' values on failure.
+ *
+ * @note	The queue must be set up and started in memory mapped mode
+ *		without bypass. A queue used for copies must not be used with
+ *		rte_eth_tx_burst()/rte_eth_rx_burst() in the same direction.
+ *		The copy is not started before rte_pmd_qdma_mm_submit() is
+ *		called or RTE_PMD_QDMA_MM_COPY_F_SUBMIT is passed.
+ ******************************************************************************/
+int rte_pmd_qdma_mm_copy(int portid, uint32_t qid,
+			enum rte_pmd_qdma_dir_type dir, rte_iova_t host_addr,
+			uint64_t ep_addr, uint32_t len, uint64_t flags);
+
+/******************************************************************************/
+/**
+ * Function Name:	rte_pmd_qdma_mm_copy_sg
+ * Description:		Enqueue a copy job made of several segments on a
+ *			memory mapped queue, one descriptor per segment.
+ *
+ * @param	portid : Port ID.
+ * @param	qid : Queue ID.
+ * @param	dir : direction i.e. Tx (host to card) or Rx (card to host).
+ * @param	segs : Array of segments to copy.
+ * @param	nb_segs : Number of segments in the array.
+ * @param	flags : RTE_PMD_QDMA_MM_COPY_F_* flags.
+ *
+ * @return	ring index of the last segment on success, '-ENOSPC' if the
+ *		ring can not hold all segments and other '< 0' values
+ *		on failure.
+ *
+ * @note	Either all segments or none are enqueued. The job is complete
+ *		once the returned ring index is reported by
+ *		rte_pmd_qdma_mm_completed().
+ ******************************************************************************/
+int rte_pmd_qdma_mm_copy_sg(int portid, uint32_t qid,
+			enum rte_pmd_qdma_dir_type dir,
+			const struct rte_pmd_qdma_mm_copy_seg *segs,
+			uint16_t nb_segs, uint64_t flags);
+
+/******************************************************************************/
+/**
+ * Function Name:	rte_pmd_qdma_mm_submit
+ * Description:		Start the copies enqueued on a memory mapped queue
+ *			with a single doorbell write.
+ *
+ * @param	portid : Port ID.
+ * @param	qid : Queue ID.
+ * @param	dir : direction i.e. Tx or Rx.
+ *
+ * @return	'0' on success and '< 0' on failure.
+ *
+ * @note	None.
+ ******************************************************************************/
+int rte_pmd_qdma_mm_submit(int portid, uint32_t qid,
+			enum rte_pmd_qdma_dir_type dir);
+
+/******************************************************************************/
+/**
+ * Function Name:	rte_pmd_qdma_mm_completed
+ * Description:		Return the number of copies completed by the engine
+ *			since the previous call and release their descriptors.
+ *
+ * @param	portid : Port ID.
+ * @param	qid : Queue ID.
+ * @param	dir : direction i.e. Tx or Rx.
+ * @param	nb_cpls : Maximum number of completions to return.
+ * @param	last_idx : If not NULL, ring index of the last completed
+ *		descriptor is returned here.
+ *
+ * @return	number of completed descriptors on success and '< 0'
+ *		on failure.
+ *
+ * @note	Copies complete in the order they were enqueued.
+ ******************************************************************************/
+int rte_pmd_qdma_mm_completed(int portid, uint32_t qid,
+			enum rte_pmd_qdma_dir_type dir, uint16_t nb_cpls,
+			uint16_t *last_idx);
+
+/******************************************************************************/
+/**
+ * Function Name:	rte_pmd_qdma_set_queue_cycles
+ * Description:		Enables or disables the accounting of the TSC
+ *			cycles spent in the Rx or Tx burst function of a
+ *			queue.
+ *
+ * @param	portid : Port ID.
+ * @param	qid : Queue ID.
+ * @param	dir : direction i.e. Tx or Rx.
+ * @param	enable : '1' to enable and '0' to disable.
+ *
+ * @return	'0' on success and '< 0' on failure.
+ *
+ * @note	The counters are cleared on every call. Accounting reads the
+ *		TSC twice per burst, keep it off outside of measurements.
+ ******************************************************************************/
+int rte_pmd_qdma_set_queue_cycles(int portid, uint32_t qid,
+			enum rte_pmd_qdma_dir_type dir, uint8_t enable);
+
+/******************************************************************************/
+/**
+ * Function Name:	rte_pmd_qdma_get_queue_cycles
+ * Description:		Returns the burst cycle counters of a queue.
+ *
+ * @param	portid : Port ID.
+ * @param	qid : Queue ID.
+ * @param	dir : direction i.e. Tx or Rx.
+ * @param	cycles : Counters are returned here.
+ *
+ * @return	'0' on success and '< 0' on failure.
+ *
+ * @note	Counters are updated by the lcore polling the queue without
+ *		synchronization, a snapshot taken while it runs may mix
+ *		counts of two bursts. Cycles per packet is cycles / pkts.
+ ******************************************************************************/
+int rte_pmd_qdma_get_queue_cycles(int portid, uint32_t qid,
+			enum rte_pmd_qdma_dir_type dir,
+			struct rte_pmd_qdma_q_cycles *cycles);
+
 #endif /* ifndef __RTE_PMD_QDMA_EXPORT_H__ */
@@ -160,6 +160,10 @@ static void cmd_help_parsed(__attribute__((unused)) void *parsed_result,
 						"<output-filename> "
 			"<src_addr> <size> <iterations>  "
 			":To Receive\n"
+			"\tdma_bench            <port-id> <num-queues> "
+						"<h2c|c2h> <pkt-size> "
+			"<seconds> <bytes> <verify>  "
+			":Throughput benchmark, one lcore per queue\n"
 			"\treg_dump             <port-id>  "
 			":To dump all the valid registers\n"
 			"\tqueue_dump           <port-id> <queue-id>  "
@@ -1032,6 +1036,107 @@ cmdline_parse_inst_t cmd_obj_dma_from_device = {
 
 };
 
+/* Command dma-bench */
+struct cmd_obj_dma_bench_result {
+	cmdline_fixed_string_t action;
+	cmdline_fixed_string_t port_id;
+	cmdline_fixed_string_t queues;
+	cmdline_fixed_string_t dir;
+	cmdline_fixed_string_t pkt_size;
+	cmdline_fixed_string_t seconds;
+	cmdline_fixed_string_t bytes;
+	cmdline_fixed_string_t verify;
+};
+
+static void cmd_obj_dma_bench_parsed(void *parsed_result,
+			       struct cmdline *cl,
+			       __attribute__((unused)) void *data)
+{
+	struct cmd_obj_dma_bench_result *res = parsed_result;
+	int port_id = 0, num_queues = 0, dir, ret;
+
+	port_id = atoi(res->port_id);
+	if (port_id >= num_ports) {
+		cmdline_printf(cl, "Error: port-id:%d not supported\n "
+					"Please enter valid port-id\n",
+					port_id);
+		return;
+	}
+	num_queues = atoi(res->queues);
+	if ((unsigned int)num_queues > pinfo[port_id].num_queues) {
+		cmdline_printf(cl, "Error: num-queues:%d are more than "
+				"the configured queues:%d,\n "
+				"Please enter valid number of queues\n",
+				num_queues, pinfo[port_id].num_queues);
+		return;
+	}
+	if (num_queues <= 0) {
+		cmdline_printf(cl, "Error: Please enter valid number "
+					"of queues\n");
+		return;
+	}
+
+	if (!strcmp(res->dir, "h2c"))
+		dir = BENCH_DIR_H2C;
+	else
+		dir = BENCH_DIR_C2H;
+
+	ret = do_bench(port_id, num_queues, dir,
+			(unsigned int)strtoul(res->pkt_size, NULL, 0),
+			(unsigned int)strtoul(res->seconds, NULL, 0),
+			strtoull(res->bytes, NULL, 0),
+			atoi(res->verify));
+	if (ret < 0)
+		return;
+
+	cmdline_printf(cl, "\n######## DMA benchmark is completed "
+						"successfully #######\n");
+}
+
+cmdline_parse_token_string_t cmd_obj_action_dma_bench =
+	TOKEN_STRING_INITIALIZER(struct cmd_obj_dma_bench_result, action,
+								"dma_bench");
+cmdline_parse_token_string_t cmd_obj_dma_bench_port_id =
+	TOKEN_STRING_INITIALIZER(struct cmd_obj_dma_bench_result, port_id,
+								NULL);
+cmdline_parse_token_string_t cmd_obj_dma_bench_queues =
+	TOKEN_STRING_INITIALIZER(struct cmd_obj_dma_bench_result, queues,
+								NULL);
+cmdline_parse_token_string_t cmd_obj_dma_bench_dir =
+	TOKEN_STRING_INITIALIZER(struct cmd_obj_dma_bench_result, dir,
+								"h2c#c2h");
+cmdline_parse_token_string_t cmd_obj_dma_bench_pkt_size =
+	TOKEN_STRING_INITIALIZER(struct cmd_obj_dma_bench_result, pkt_size,
+								NULL);
+cmdline_parse_token_string_t cmd_obj_dma_bench_seconds =
+	TOKEN_STRING_INITIALIZER(struct cmd_obj_dma_bench_result, seconds,
+								NULL);
+cmdline_parse_token_string_t cmd_obj_dma_bench_bytes =
+	TOKEN_STRING_INITIALIZER(struct cmd_obj_dma_bench_result, bytes,
+								NULL);
+cmdline_parse_token_string_t cmd_obj_dma_bench_verify =
+	TOKEN_STRING_INITIALIZER(struct cmd_obj_dma_bench_result, verify,
+								NULL);
+
+cmdline_parse_inst_t cmd_obj_dma_bench = {
+	.f = cmd_obj_dma_bench_parsed,  /* function to call */
+	.data = NULL,      /* 2nd arg of func */
+	.help_str = "dma_bench port-id num-queues h2c|c2h pkt-size seconds "
+			"bytes verify",
+	.tokens = {        /* token list, NULL terminated */
+		(void *)&cmd_obj_action_dma_bench,
+		(void *)&cmd_obj_dma_bench_port_id,
+		(void *)&cmd_obj_dma_bench_queues,
+		(void *)&cmd_obj_dma_bench_dir,
+		(void *)&cmd_obj_dma_bench_pkt_size,
+		(void *)&cmd_obj_dma_bench_seconds,
+		(void *)&cmd_obj_dma_bench_bytes,
+		(void *)&cmd_obj_dma_bench_verify,
+		NULL,
+	},
+
+};
+
 struct cmd_obj_reg_dump_result {
 	cmdline_fixed_string_t action;
 	cmdline_fixed_string_t port_id;
@@ -1289,6 +1394,7 @@ cmdline_parse_ctx_t main_ctx[] = {
 	(cmdline_parse_inst_t *)&cmd_obj_reg_write,
 	(cmdline_parse_inst_t *)&cmd_obj_dma_to_device,
 	(cmdline_parse_inst_t *)&cmd_obj_dma_from_device,
+	(cmdline_parse_inst_t *)&cmd_obj_dma_bench,
 	(cmdline_parse_inst_t *)&cmd_obj_reg_dump,
 	(cmdline_parse_inst_t *)&cmd_obj_queue_dump,
 	(cmdline_parse_inst_t *)&cmd_obj_desc_dump,
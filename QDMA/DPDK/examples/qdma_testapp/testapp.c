@@ -45,6 +45,8 @@
 #include <rte_log.h>
 #include <rte_string_fns.h>
 #include <rte_spinlock.h>
+#include <rte_launch.h>
+#include <rte_lcore.h>
 #include <cmdline_rdline.h>
 #include <cmdline_parse.h>
 #include <cmdline_socket.h>
@@ -73,7 +75,7 @@ int do_recv_mm(int port_id, int fd, int queueid, int ld_size, int tot_num_desc)
 	struct rte_mbuf *pkts[NUM_RX_PKTS] = { NULL };
 	struct rte_device *dev;
 	int nb_rx = 0, i = 0, ret = 0, num_pkts;
-	int tdesc;
+	int tdesc, max_rx_retry;
 #ifdef PERF_BENCHMARK
 	uint64_t prev_tsc, cur_tsc, diff_tsc;
 #endif
@@ -109,8 +111,17 @@ int do_recv_mm(int port_id, int fd, int queueid, int ld_size, int tot_num_desc)
 #ifdef PERF_BENCHMARK
 		prev_tsc = rte_rdtsc_precise();
 #endif
-		/* try to receive RX_BURST_SZ packets */
+		/* try to receive RX_BURST_SZ packets, the first call only
+		 * posts the transfers on the MM queue
+		 */
+		max_rx_retry = RX_TX_MAX_RETRY;
 		nb_rx = rte_eth_rx_burst(port_id, queueid, pkts, num_pkts);
+		while ((nb_rx == 0) && max_rx_retry) {
+			rte_delay_us(1);
+			nb_rx = rte_eth_rx_burst(port_id, queueid, pkts,
+							num_pkts);
+			max_rx_retry--;
+		}
 
 #ifdef PERF_BENCHMARK
 		cur_tsc = rte_rdtsc_precise();
@@ -161,7 +172,14 @@ int do_recv_mm(int port_id, int fd, int queueid, int ld_size, int tot_num_desc)
 	}
 	if (ld_size) {
 		struct rte_mbuf *mb;
+
+		max_rx_retry = RX_TX_MAX_RETRY;
 		nb_rx = rte_eth_rx_burst(port_id, queueid, pkts, 1);
+		while ((nb_rx == 0) && max_rx_retry) {
+			rte_delay_us(1);
+			nb_rx = rte_eth_rx_burst(port_id, queueid, pkts, 1);
+			max_rx_retry--;
+		}
 		if (nb_rx != 0) {
 			mb = pkts[0];
 			ret = write(fd, rte_pktmbuf_mtod(mb, void*), ld_size);
@@ -614,6 +632,494 @@ int do_xmit(int port_id, int fd, int queueid, int ld_size, int tot_num_desc,
 	return 0;
 }
 
+/* Burst latency histogram, 16 linear buckets per power of two cycles */
+#define BENCH_LAT_SUB_BITS	4
+#define BENCH_LAT_SUB		(1 << BENCH_LAT_SUB_BITS)
+#define BENCH_LAT_BUCKETS	(64 * BENCH_LAT_SUB)
+
+/* A queue that moves no data for this long ends its run */
+#define BENCH_IDLE_TIMEOUT_MS	1000
+
+/* C2H stream packets requested from the generator for a timed run */
+#define BENCH_ST_C2H_MAX_PKTS	0x7FFFFFFF
+
+struct bench_queue {
+	int port_id;
+	int queue_id;
+	int dir;
+	int st_mode;
+	int verify;
+	unsigned int lcore_id;
+	unsigned int pkt_size;
+	uint64_t max_bytes;	/* 0: no byte limit */
+	uint64_t run_tsc;	/* 0: no time limit */
+	struct rte_mbuf *pkts[BENCH_BURST_SZ];
+
+	uint64_t nb_pkts;
+	uint64_t nb_bytes;
+	uint64_t nb_errors;
+	uint64_t stop_tsc;
+	int stalled;
+	uint64_t lat[BENCH_LAT_BUCKETS];
+	struct rte_pmd_qdma_q_cycles cycles; /* PMD burst cycles */
+} __rte_cache_aligned;
+
+static volatile int bench_go;
+static uint64_t bench_start_tsc;
+
+static inline unsigned int bench_lat_bucket(uint64_t cycles)
+{
+	unsigned int shift;
+
+	if (cycles < BENCH_LAT_SUB)
+		return cycles;
+
+	shift = 63 - __builtin_clzll(cycles) - BENCH_LAT_SUB_BITS;
+	return ((shift + 1) << BENCH_LAT_SUB_BITS) +
+		((cycles >> shift) & (BENCH_LAT_SUB - 1));
+}
+
+/* Largest cycle count that falls in a bucket */
+static uint64_t bench_lat_cycles(unsigned int bucket)
+{
+	unsigned int shift;
+	uint64_t mant;
+
+	if (bucket < BENCH_LAT_SUB)
+		return bucket;
+
+	shift = (bucket >> BENCH_LAT_SUB_BITS) - 1;
+	mant = (bucket & (BENCH_LAT_SUB - 1)) | BENCH_LAT_SUB;
+	return ((mant + 1) << shift) - 1;
+}
+
+static double bench_lat_pct_us(const uint64_t *lat, double pct)
+{
+	uint64_t total = 0, target, sum = 0;
+	unsigned int i;
+
+	for (i = 0; i < BENCH_LAT_BUCKETS; i++)
+		total += lat[i];
+	if (total == 0)
+		return 0;
+
+	target = (uint64_t)(total * pct / 100);
+	if (target == 0)
+		target = 1;
+	for (i = 0; i < BENCH_LAT_BUCKETS; i++) {
+		sum += lat[i];
+		if (sum >= target)
+			break;
+	}
+
+	return (double)bench_lat_cycles(i) * 1000000 / rte_get_tsc_hz();
+}
+
+/* The example design streams a running 16 bit counter */
+static void bench_fill_pattern(struct rte_mbuf *mb, unsigned int len)
+{
+	uint16_t *data = rte_pktmbuf_mtod(mb, uint16_t *);
+	unsigned int i;
+
+	for (i = 0; i < len / 2; i++)
+		data[i] = (uint16_t)i;
+}
+
+static int bench_check_pattern(struct rte_mbuf *mb)
+{
+	uint16_t *data, expect = 0;
+	unsigned int i, nb_words;
+	int first = 1;
+
+	for (; mb != NULL; mb = mb->next) {
+		data = rte_pktmbuf_mtod(mb, uint16_t *);
+		nb_words = rte_pktmbuf_data_len(mb) / 2;
+		for (i = 0; i < nb_words; i++) {
+			if (first) {
+				expect = data[i];
+				first = 0;
+			}
+			if (data[i] != expect)
+				return -1;
+			expect++;
+		}
+	}
+
+	return 0;
+}
+
+static uint16_t bench_tx_burst(struct bench_queue *bq, uint16_t nb_pkts)
+{
+	uint16_t nb_tx, i;
+
+	/* The pattern mbufs are resent every burst, the reference taken
+	 * here is the one the PMD drops on completion
+	 */
+	for (i = 0; i < nb_pkts; i++)
+		rte_mbuf_refcnt_update(bq->pkts[i], 1);
+
+	nb_tx = rte_eth_tx_burst(bq->port_id, bq->queue_id, bq->pkts,
+					nb_pkts);
+
+	for (i = nb_tx; i < nb_pkts; i++)
+		rte_mbuf_refcnt_update(bq->pkts[i], -1);
+
+	bq->nb_pkts += nb_tx;
+	bq->nb_bytes += (uint64_t)nb_tx * bq->pkt_size;
+
+	return nb_tx;
+}
+
+static uint16_t bench_rx_burst(struct bench_queue *bq, uint16_t nb_pkts)
+{
+	struct rte_mbuf *mb;
+	uint16_t nb_rx, i;
+
+	nb_rx = rte_eth_rx_burst(bq->port_id, bq->queue_id, bq->pkts,
+					nb_pkts);
+
+	for (i = 0; i < nb_rx; i++) {
+		mb = bq->pkts[i];
+		bq->nb_bytes += rte_pktmbuf_pkt_len(mb);
+		if (bq->verify && bench_check_pattern(mb))
+			bq->nb_errors++;
+		rte_pktmbuf_free(mb);
+	}
+	bq->nb_pkts += nb_rx;
+
+	return nb_rx;
+}
+
+/* Burst latency is the time between two bursts that moved data */
+static int bench_worker(void *arg)
+{
+	struct bench_queue *bq = arg;
+	uint64_t idle_tsc = rte_get_tsc_hz() * BENCH_IDLE_TIMEOUT_MS / 1000;
+	uint64_t end_tsc, last_tsc, now, left;
+	uint16_t nb_pkts, nb;
+
+	while (!bench_go)
+		rte_pause();
+	rte_smp_rmb();
+
+	last_tsc = bench_start_tsc;
+	end_tsc = bq->run_tsc ? bench_start_tsc + bq->run_tsc : UINT64_MAX;
+	now = last_tsc;
+
+	while (now < end_tsc &&
+			(!bq->max_bytes || bq->nb_bytes < bq->max_bytes)) {
+		nb_pkts = BENCH_BURST_SZ;
+		if (bq->max_bytes) {
+			left = (bq->max_bytes - bq->nb_bytes +
+					bq->pkt_size - 1) / bq->pkt_size;
+			if (left < nb_pkts)
+				nb_pkts = (uint16_t)left;
+		}
+
+		if (bq->dir == BENCH_DIR_H2C)
+			nb = bench_tx_burst(bq, nb_pkts);
+		else
+			nb = bench_rx_burst(bq, nb_pkts);
+
+		now = rte_rdtsc();
+		if (nb == 0) {
+			if (now - last_tsc > idle_tsc) {
+				bq->stalled = 1;
+				break;
+			}
+			continue;
+		}
+		bq->lat[bench_lat_bucket(now - last_tsc)]++;
+		last_tsc = now;
+	}
+	bq->stop_tsc = last_tsc;
+
+	return 0;
+}
+
+/* PMD burst cycles per packet moved, idle bursts excluded */
+static double bench_cyc_per_pkt(const struct rte_pmd_qdma_q_cycles *c)
+{
+	return c->pkts ? (double)c->cycles / c->pkts : 0;
+}
+
+static void bench_report(struct bench_queue *bq, int num_queues)
+{
+	uint64_t hz = rte_get_tsc_hz();
+	uint64_t lat[BENCH_LAT_BUCKETS] = { 0 };
+	uint64_t nb_pkts = 0, nb_bytes = 0, nb_errors = 0, stop_tsc = 0;
+	uint64_t cyc = 0, cyc_pkts = 0;
+	double secs;
+	int q, i;
+
+	printf("%6s%6s%6s%14s%16s%10s%10s%10s%10s%10s%9s%8s\n",
+			"Queue", "Lcore", "Mode", "Packets", "Bytes", "Gbps",
+			"Mpps", "p50(us)", "p99(us)", "p999(us)", "Cyc/pkt",
+			"Errors");
+	for (q = 0; q < num_queues; q++) {
+		secs = (double)(bq[q].stop_tsc - bench_start_tsc) / hz;
+		if (secs <= 0)
+			secs = 1.0 / hz;
+		printf("%6d%6u%6s%14"PRIu64"%16"PRIu64"%10.3lf%10.3lf"
+				"%10.2lf%10.2lf%10.2lf%9.1lf%8"PRIu64"%s\n",
+				bq[q].queue_id, bq[q].lcore_id,
+				bq[q].st_mode ? "ST" : "MM",
+				bq[q].nb_pkts, bq[q].nb_bytes,
+				bq[q].nb_bytes * 8 / secs / 1000000000,
+				bq[q].nb_pkts / secs / 1000000,
+				bench_lat_pct_us(bq[q].lat, 50),
+				bench_lat_pct_us(bq[q].lat, 99),
+				bench_lat_pct_us(bq[q].lat, 99.9),
+				bench_cyc_per_pkt(&bq[q].cycles),
+				bq[q].nb_errors,
+				bq[q].stalled ? "  (stalled)" : "");
+
+		nb_pkts += bq[q].nb_pkts;
+		nb_bytes += bq[q].nb_bytes;
+		nb_errors += bq[q].nb_errors;
+		cyc += bq[q].cycles.cycles;
+		cyc_pkts += bq[q].cycles.pkts;
+		if (bq[q].stop_tsc > stop_tsc)
+			stop_tsc = bq[q].stop_tsc;
+		for (i = 0; i < BENCH_LAT_BUCKETS; i++)
+			lat[i] += bq[q].lat[i];
+	}
+
+	secs = (double)(stop_tsc - bench_start_tsc) / hz;
+	if (secs <= 0)
+		secs = 1.0 / hz;
+	printf("%18s%14"PRIu64"%16"PRIu64"%10.3lf%10.3lf"
+			"%10.2lf%10.2lf%10.2lf%9.1lf%8"PRIu64"\n",
+			"Total", nb_pkts, nb_bytes,
+			nb_bytes * 8 / secs / 1000000000,
+			nb_pkts / secs / 1000000,
+			bench_lat_pct_us(lat, 50),
+			bench_lat_pct_us(lat, 99),
+			bench_lat_pct_us(lat, 99.9),
+			cyc_pkts ? (double)cyc / cyc_pkts : 0,
+			nb_errors);
+	printf("Elapsed time: %.3lf seconds\n", secs);
+}
+
+int do_bench(int port_id, int num_queues, int dir, unsigned int pkt_size,
+		unsigned int seconds, uint64_t max_bytes, int verify)
+{
+	unsigned int lcores[RTE_MAX_LCORE];
+	unsigned int nb_lcores = 0, lcore_id, max_size;
+	struct bench_queue *bq;
+	struct rte_mempool *mp = NULL;
+	struct rte_device *dev;
+	int q, i, ret = 0, reg_val, user_bar_idx, st_c2h = -1;
+	int qbase = pinfo[port_id].queue_base;
+	uint64_t nb_c2h_pkts;
+
+	if (!seconds && !max_bytes) {
+		printf("Error: either a duration or a byte count is needed\n");
+		return -1;
+	}
+	if (pkt_size == 0) {
+		printf("Error: pkt-size shall be greater than 0\n");
+		return -1;
+	}
+
+	RTE_LCORE_FOREACH_SLAVE(lcore_id)
+		lcores[nb_lcores++] = lcore_id;
+	if ((unsigned int)num_queues > nb_lcores) {
+		printf("Error: %d queues need as many worker lcores, "
+				"only %u available\n", num_queues, nb_lcores);
+		return -1;
+	}
+
+	rte_spinlock_lock(&port_update_lock);
+
+	dev = rte_eth_devices[port_id].device;
+	if (dev == NULL) {
+		printf("Port id %d already removed. "
+			"Relaunch application to use the port again\n",
+			port_id);
+		rte_spinlock_unlock(&port_update_lock);
+		return -1;
+	}
+
+	user_bar_idx = pinfo[port_id].user_bar_idx;
+	reg_val = PciRead(user_bar_idx, C2H_CONTROL_REG, port_id);
+	reg_val &= C2H_CONTROL_REG_MASK;
+
+	for (q = 0; q < num_queues; q++) {
+		if (dir == BENCH_DIR_H2C)
+			max_size = pinfo[port_id].buff_size;
+		else if ((unsigned int)q < pinfo[port_id].st_queues)
+			max_size = pinfo[port_id].buff_size * 7;
+		else if (pkt_size != pinfo[port_id].buff_size) {
+			printf("Error: MM C2H transfers are of the port "
+					"buffer size %u\n",
+					pinfo[port_id].buff_size);
+			rte_spinlock_unlock(&port_update_lock);
+			return -1;
+		} else
+			max_size = pkt_size;
+
+		if (pkt_size > max_size) {
+			printf("Error: pkt-size %u is more than %u on "
+					"queue-id %d\n", pkt_size, max_size, q);
+			rte_spinlock_unlock(&port_update_lock);
+			return -1;
+		}
+
+		if (dir == BENCH_DIR_C2H &&
+				(unsigned int)q < pinfo[port_id].st_queues) {
+			/* The generator feeds a single queue */
+			if (st_c2h >= 0 || (reg_val & ST_LOOPBACK_EN)) {
+				printf("Error: C2H stream traffic is generated "
+						"for one ST queue only, with "
+						"loopback disabled\n");
+				rte_spinlock_unlock(&port_update_lock);
+				return -1;
+			}
+			st_c2h = q;
+		}
+	}
+
+	if (dir == BENCH_DIR_H2C) {
+		mp = rte_mempool_lookup(pinfo[port_id].mem_pool);
+		if (mp == NULL) {
+			printf("Could not find mempool with name %s\n",
+					pinfo[port_id].mem_pool);
+			rte_spinlock_unlock(&port_update_lock);
+			return -1;
+		}
+	}
+
+	bq = rte_zmalloc("qdma_bench", sizeof(*bq) * num_queues,
+				RTE_CACHE_LINE_SIZE);
+	if (bq == NULL) {
+		printf("Error: Could not allocate the benchmark state\n");
+		rte_spinlock_unlock(&port_update_lock);
+		return -1;
+	}
+
+	for (q = 0; q < num_queues; q++) {
+		bq[q].port_id = port_id;
+		bq[q].queue_id = q;
+		bq[q].dir = dir;
+		bq[q].st_mode = (unsigned int)q < pinfo[port_id].st_queues;
+		bq[q].verify = verify && bq[q].st_mode &&
+				dir == BENCH_DIR_C2H;
+		bq[q].lcore_id = lcores[q];
+		bq[q].pkt_size = pkt_size;
+		bq[q].max_bytes = max_bytes;
+		bq[q].run_tsc = (uint64_t)seconds * rte_get_tsc_hz();
+
+		if (!bq[q].st_mode) {
+			ret = rte_pmd_qdma_set_mm_endpoint_addr(port_id, q,
+					dir == BENCH_DIR_H2C ?
+					RTE_PMD_QDMA_TX : RTE_PMD_QDMA_RX,
+					(BRAM_SIZE / num_queues) * q);
+			if (ret < 0)
+				goto free_bench;
+		}
+
+		if (dir != BENCH_DIR_H2C)
+			continue;
+
+		ret = rte_pktmbuf_alloc_bulk(mp, bq[q].pkts, BENCH_BURST_SZ);
+		if (ret < 0) {
+			printf(" #####Cannot allocate mbuf packet\n");
+			goto free_bench;
+		}
+		for (i = 0; i < BENCH_BURST_SZ; i++) {
+			bench_fill_pattern(bq[q].pkts[i], pkt_size);
+			rte_pktmbuf_data_len(bq[q].pkts[i]) = (uint16_t)pkt_size;
+			rte_pktmbuf_pkt_len(bq[q].pkts[i]) = pkt_size;
+		}
+	}
+
+	if (st_c2h >= 0) {
+		nb_c2h_pkts = BENCH_ST_C2H_MAX_PKTS;
+		if (max_bytes && (max_bytes + pkt_size - 1) / pkt_size <
+				nb_c2h_pkts)
+			nb_c2h_pkts = (max_bytes + pkt_size - 1) / pkt_size;
+
+		PciWrite(user_bar_idx, C2H_ST_QID_REG, (st_c2h + qbase),
+				port_id);
+		PciWrite(user_bar_idx, C2H_ST_LEN_REG, pkt_size, port_id);
+		PciWrite(user_bar_idx, C2H_PACKET_COUNT_REG,
+				(unsigned int)nb_c2h_pkts, port_id);
+		PciWrite(user_bar_idx, C2H_CONTROL_REG,
+				reg_val | ST_C2H_START_VAL, port_id);
+	} else if (dir == BENCH_DIR_H2C && pinfo[port_id].st_queues) {
+		PciWrite(user_bar_idx, C2H_ST_QID_REG, qbase, port_id);
+	}
+
+	printf("dma_bench: %d queue(s), %s, pkt-size %u, burst %d\n",
+			num_queues, dir == BENCH_DIR_H2C ? "H2C" : "C2H",
+			pkt_size, BENCH_BURST_SZ);
+
+	for (q = 0; q < num_queues; q++)
+		rte_pmd_qdma_set_queue_cycles(port_id, q, dir == BENCH_DIR_H2C ?
+				RTE_PMD_QDMA_TX : RTE_PMD_QDMA_RX, 1);
+
+	bench_go = 0;
+	for (q = 0; q < num_queues; q++)
+		rte_eal_remote_launch(bench_worker, &bq[q], lcores[q]);
+
+	bench_start_tsc = rte_rdtsc();
+	rte_smp_wmb();
+	bench_go = 1;
+
+	for (q = 0; q < num_queues; q++) {
+		rte_eal_wait_lcore(lcores[q]);
+		rte_pmd_qdma_get_queue_cycles(port_id, q, dir == BENCH_DIR_H2C ?
+				RTE_PMD_QDMA_TX : RTE_PMD_QDMA_RX,
+				&bq[q].cycles);
+		rte_pmd_qdma_set_queue_cycles(port_id, q, dir == BENCH_DIR_H2C ?
+				RTE_PMD_QDMA_TX : RTE_PMD_QDMA_RX, 0);
+	}
+
+	if (st_c2h >= 0) {
+		/* Stop the C2H Engine */
+		PciWrite(user_bar_idx, C2H_CONTROL_REG,
+				reg_val & ~(ST_C2H_START_VAL), port_id);
+	} else if (dir == BENCH_DIR_H2C && pinfo[port_id].st_queues &&
+			!(reg_val & ST_LOOPBACK_EN)) {
+		printf("BAR-%d is the QDMA H2C transfer match: 0x%x,\n",
+				user_bar_idx,
+				PciRead(user_bar_idx, H2C_STATUS_REG, port_id));
+
+		/** TO clear H2C DMA write **/
+		PciWrite(user_bar_idx, H2C_CONTROL_REG, 0x1, port_id);
+	}
+
+	bench_report(bq, num_queues);
+
+	/* Restart the queues so that data still in flight does not show up
+	 * in the next transfer
+	 */
+	for (q = 0; q < num_queues; q++) {
+		if (dir == BENCH_DIR_H2C) {
+			rte_eth_dev_tx_queue_stop(port_id, q);
+			ret = rte_eth_dev_tx_queue_start(port_id, q);
+		} else {
+			rte_eth_dev_rx_queue_stop(port_id, q);
+			ret = rte_eth_dev_rx_queue_start(port_id, q);
+		}
+		if (ret < 0)
+			printf("Error: Could not restart queue-id %d\n", q);
+	}
+
+free_bench:
+	/* Drop the pattern mbufs, C2H bursts already freed theirs */
+	for (q = 0; dir == BENCH_DIR_H2C && q < num_queues; q++) {
+		for (i = 0; i < BENCH_BURST_SZ; i++)
+			rte_pktmbuf_free(bq[q].pkts[i]);
+	}
+	rte_free(bq);
+
+	rte_spinlock_unlock(&port_update_lock);
+
+	return ret < 0 ? -1 : 0;
+}
+
 static int dev_reset_callback(uint16_t port_id,
 				enum rte_eth_event_type type,
 				void *param __rte_unused, void *ret_param)
@@ -45,6 +45,9 @@
 #define RX_TX_MAX_RETRY			1500
 #define DEFAULT_RX_WRITEBACK_THRESH	(64)
 
+/* Packets per burst of a dma_bench worker */
+#define BENCH_BURST_SZ	64
+
 #define MP_CACHE_SZ     512
 #define MBUF_POOL_NAME_PORT   "mbuf_pool_%d"
 
@@ -62,6 +65,11 @@
 
 extern int num_ports;
 
+enum bench_dir {
+	BENCH_DIR_H2C,
+	BENCH_DIR_C2H
+};
+
 struct port_info {
 	int config_bar_idx;
 	int user_bar_idx;
@@ -80,6 +88,8 @@ int port_init(int portid, int num_queues, int st_queues,
 int do_recv_st(int portid, int fd, int queueid, int input_size);
 int do_recv_mm(int portid, int fd, int queueid, int size, int tot_num_desc);
 int do_xmit(int portid, int fd, int queueid, int size, int nb_desc, int zbyte);
+int do_bench(int portid, int num_queues, int dir, unsigned int pkt_size,
+		unsigned int seconds, uint64_t max_bytes, int verify);
 void load_file_cmds(struct cmdline *cl);
 void port_close(int port_id);
 int port_reset(int port_id, int num_queues, int st_queues,
@@ -4168,6 +4168,10 @@ static int qdma_hw_error_process(void *dev_hndl)
 	for (i = 0; i < TOTAL_LEAF_ERROR_AGGREGATORS; i++) {
 		bit = hw_err_position[i];
 
+		/* only read the leaf status of asserted aggregators */
+		if (!(glbl_err_stat & err_info[bit].global_err_mask))
+			continue;
+
 		if ((!dev_cap->st_en) && (bit == QDMA_ST_C2H_ERR_MTY_MISMATCH ||
 				bit == QDMA_ST_FATAL_ERR_MTY_MISMATCH ||
 				bit == QDMA_ST_H2C_ERR_ZERO_LEN_DESC))
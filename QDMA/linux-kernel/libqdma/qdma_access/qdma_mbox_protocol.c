@@ -158,6 +158,8 @@ enum mbox_msg_op {
 	MBOX_OP_RESET_DONE,
 	/** @MBOX_OP_PF_BYE: pf offline */
 	MBOX_OP_PF_BYE,
+	/** @MBOX_OP_QCTXT_WRT_BATCH: context write of several queues */
+	MBOX_OP_QCTXT_WRT_BATCH,
 
 	/** @MBOX_OP_HELLO_RESP: response to @MBOX_OP_HELLO */
 	MBOX_OP_HELLO_RESP = 0x81,
@@ -195,6 +197,10 @@ enum mbox_msg_op {
 	MBOX_OP_RESET_DONE_RESP,
 	/** @MBOX_OP_PF_BYE_RESP: response to @MBOX_OP_PF_BYE */
 	MBOX_OP_PF_BYE_RESP,
+	/** @MBOX_OP_QCTXT_WRT_BATCH_RESP: response to
+	 *  @MBOX_OP_QCTXT_WRT_BATCH
+	 */
+	MBOX_OP_QCTXT_WRT_BATCH_RESP,
 	/** @MBOX_OP_MAX: total mbox opcodes*/
 	MBOX_OP_MAX
 };
@@ -225,6 +231,8 @@ struct mbox_msg_hello {
 	uint32_t qmax;
 	/** @dev_cap: device capability */
 	struct qdma_dev_attributes dev_cap;
+	/** @flags: MBOX_HELLO_F_* features of the PF, response only */
+	uint32_t flags;
 };
 
 /**
@@ -301,6 +309,19 @@ struct mbox_msg_qctxt {
 	};
 };
 
+/**
+ * @struct - mbox_msg_qctxt_batch
+ * @brief batched queue context write mailbox message
+ */
+struct mbox_msg_qctxt_batch {
+	/** @hdr: mailbox message header*/
+	struct mbox_msg_hdr hdr;
+	/** @num_qs: number of valid entries in qctxt */
+	uint8_t num_qs;
+	/** @qctxt: per queue context write requests */
+	struct mbox_qctxt_wrt_conf qctxt[MBOX_QCTXT_WRT_BATCH_MAX];
+};
+
 /**
  * @struct - mbox_intr_ctxt
  * @brief queue context mailbox message header
@@ -323,6 +344,8 @@ union qdma_mbox_txrx {
 		struct mbox_intr_ctxt intr_ctxt;
 		/** queue context mailbox message*/
 		struct mbox_msg_qctxt qctxt;
+		/** batched queue context write message */
+		struct mbox_msg_qctxt_batch qctxt_batch;
 		/** global csr mailbox message */
 		struct mbox_msg_csr csr;
 		/** acive q count */
@@ -1001,6 +1024,7 @@ int qdma_mbox_pf_rcv_msg_handler(void *dev_hndl, uint8_t pci_bus_num,
 			rsp_hello->qmax = fmap->qmax;
 			hw->qdma_get_device_attributes(dev_hndl,
 						       &rsp_hello->dev_cap);
+			rsp_hello->flags = MBOX_HELLO_F_QCTXT_WRT_BATCH;
 		}
 		qdma_mbox_memset(&fmap_cfg, 0,
 				 sizeof(struct qdma_fmap_cfg));
@@ -1292,6 +1316,36 @@ int qdma_mbox_pf_rcv_msg_handler(void *dev_hndl, uint8_t pci_bus_num,
 					       qctxt);
 	}
 	break;
+	case MBOX_OP_QCTXT_WRT_BATCH:
+	{
+		struct mbox_msg_qctxt_batch *batch = &rcv->qctxt_batch;
+		struct mbox_msg_qctxt qctxt;
+		uint8_t i;
+
+		if (batch->num_qs > MBOX_QCTXT_WRT_BATCH_MAX) {
+			rv = -QDMA_ERR_MBOX_INV_MSG;
+			break;
+		}
+
+		/* program all queues in one pass, stop at the first error */
+		for (i = 0; i < batch->num_qs; i++) {
+			qdma_mbox_memset(&qctxt, 0,
+					 sizeof(struct mbox_msg_qctxt));
+			qctxt.qid_hw = batch->qctxt[i].qid_hw;
+			qctxt.st = batch->qctxt[i].st;
+			qctxt.c2h = batch->qctxt[i].c2h;
+			qctxt.cmpt_ctxt_type = batch->qctxt[i].cmpt_ctxt_type;
+			qdma_mbox_memcpy(&qctxt.descq_conf,
+					 &batch->qctxt[i].descq_conf,
+					 sizeof(struct mbox_descq_conf));
+			qctxt.descq_conf.func_id = hdr->src_func_id;
+			rv = mbox_write_queue_contexts(dev_hndl, pci_bus_num,
+						       &qctxt);
+			if (rv < 0)
+				break;
+		}
+	}
+	break;
 	case MBOX_OP_RESET_PREPARE_RESP:
 		mbox_pf_hw_clear_func_ack(dev_hndl, hdr->src_func_id);
 		return QDMA_MBOX_VF_RESET;
@@ -1497,6 +1551,31 @@ int qdma_mbox_compose_vf_qctxt_write(uint16_t func_id,
 	return QDMA_SUCCESS;
 }
 
+int qdma_mbox_compose_vf_qctxt_write_batch(uint16_t func_id,
+			uint8_t num_qs, struct mbox_qctxt_wrt_conf *qctxt,
+			uint32_t *raw_data)
+{
+	union qdma_mbox_txrx *msg = (union qdma_mbox_txrx *)raw_data;
+
+	if (!raw_data || !qctxt || !num_qs ||
+			num_qs > MBOX_QCTXT_WRT_BATCH_MAX) {
+		qdma_log_error("%s: raw_data=%p, num_qs=%d, err:%d\n",
+						__func__, raw_data, num_qs,
+						-QDMA_ERR_INV_PARAM);
+		return -QDMA_ERR_INV_PARAM;
+	}
+
+	qdma_mbox_memset(raw_data, 0, sizeof(union qdma_mbox_txrx));
+	msg->hdr.op = MBOX_OP_QCTXT_WRT_BATCH;
+	msg->hdr.src_func_id = func_id;
+	msg->qctxt_batch.num_qs = num_qs;
+
+	qdma_mbox_memcpy(msg->qctxt_batch.qctxt, qctxt,
+	       num_qs * sizeof(struct mbox_qctxt_wrt_conf));
+
+	return QDMA_SUCCESS;
+}
+
 int qdma_mbox_compose_vf_qctxt_read(uint16_t func_id,
 				uint16_t qid_hw, uint8_t st, uint8_t c2h,
 				enum mbox_cmpt_ctxt_type cmpt_ctxt_type,
@@ -1744,6 +1823,13 @@ int qdma_mbox_vf_dev_info_get(uint32_t *rcv_data,
 	return msg->hdr.status;
 }
 
+uint32_t qdma_mbox_vf_hello_flags_get(uint32_t *rcv_data)
+{
+	union qdma_mbox_txrx *msg = (union qdma_mbox_txrx *)rcv_data;
+
+	return msg->hello.flags;
+}
+
 int qdma_mbox_vf_qinfo_get(uint32_t *rcv_data, int *qbase, uint16_t *qmax)
 {
 	union qdma_mbox_txrx *msg = (union qdma_mbox_txrx *)rcv_data;
@@ -123,6 +123,32 @@ enum mbox_cmpt_ctxt_type {
 	QDMA_MBOX_CMPT_CTXT_NONE
 };
 
+/** max queues carried by one batched context write message */
+#define MBOX_QCTXT_WRT_BATCH_MAX	3
+
+/** hello response flag, the PF handles MBOX_OP_QCTXT_WRT_BATCH */
+#define MBOX_HELLO_F_QCTXT_WRT_BATCH	(1 << 0)
+
+/**
+ * @struct - mbox_qctxt_wrt_conf
+ * @brief context write request of one queue, see
+ * qdma_mbox_compose_vf_qctxt_write_batch()
+ */
+struct mbox_qctxt_wrt_conf {
+	/** @qid_hw: queue ID */
+	uint16_t qid_hw;
+	/** @st: streaming mode */
+	uint8_t st:1;
+	/** @c2h: c2h direction */
+	uint8_t c2h:1;
+	/** @cmpt_ctxt_type: completion context type */
+	enum mbox_cmpt_ctxt_type cmpt_ctxt_type:2;
+	/** @rsvd: reserved */
+	uint8_t rsvd:4;
+	/** @descq_conf: queue configuration */
+	struct mbox_descq_conf descq_conf;
+};
+
 /**
  * @struct - mbox_msg_intr_ctxt
  * @brief	interrupt context mailbox message
@@ -325,6 +351,22 @@ int qdma_mbox_compose_vf_qctxt_write(uint16_t func_id,
 			struct mbox_descq_conf *descq_conf,
 			uint32_t *raw_data);
 
+/*****************************************************************************/
+/**
+ * qdma_mbox_compose_vf_qctxt_write_batch(): compose one message programming
+ * the contexts of up to MBOX_QCTXT_WRT_BATCH_MAX queues
+ *
+ * @func_id:   destination function id
+ * @num_qs:   number of entries in qctxt
+ * @qctxt:   per queue context write requests
+ * @raw_data: output raw message to be sent
+ *
+ * Return:	0  : success and < 0: failure
+ *****************************************************************************/
+int qdma_mbox_compose_vf_qctxt_write_batch(uint16_t func_id,
+			uint8_t num_qs, struct mbox_qctxt_wrt_conf *qctxt,
+			uint32_t *raw_data);
+
 /*****************************************************************************/
 /**
  * qdma_mbox_compose_vf_qctxt_read(): compose message to read context data of a
@@ -510,6 +552,17 @@ uint8_t qdma_mbox_vf_parent_func_id_get(uint32_t *rcv_data);
 int qdma_mbox_vf_dev_info_get(uint32_t *rcv_data,
 				struct qdma_dev_attributes *dev_cap);
 
+/*****************************************************************************/
+/**
+ * qdma_mbox_vf_hello_flags_get(): get the PF feature flags from the
+ * response to the hello message
+ *
+ * @rcv_data: mbox message recieved
+ *
+ * Return:	MBOX_HELLO_F_* flags, 0 from a PF that predates them
+ *****************************************************************************/
+uint32_t qdma_mbox_vf_hello_flags_get(uint32_t *rcv_data);
+
 /*****************************************************************************/
 /**
  * qdma_mbox_vf_qinfo_get(): get qinfo from received message